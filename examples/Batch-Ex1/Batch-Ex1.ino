@@ -0,0 +1,104 @@
+
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - Batch - Example #1
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ * 
+ * -----------------------------------------
+ * Example of a batch of reads and writes, executed in a single pass over the tag.
+ * 
+ * The requests are added in any order, then executeBatch() visits the blocks in
+ * order, authenticating each sector only once, and writing/reading each block only
+ * once. The time the tag must stay in the field depends on the number of sectors
+ * accessed, not on the number of requests.
+ * 
+ * Hardware: you need an Arduino or Esp8266 connected to a MFRC522 reader, and
+ * at least one Mifare Classic card/tag.
+ * 
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      Arduino       NodeMCU
+ * Reader       Uno           Esp8266
+ * Pin          Pin           Pin    
+ * -----------------------------------------
+ * SDA(SS)      4*            D4*
+ * SCK          13            D5   
+ * MOSI         11            D7
+ * MISO         12            D6
+ * RST          3*            D3*
+ * NC(IRQ)      not used      not used
+ * 3.3V         3.3V          3V
+ * GND          GND           GND
+ * -----------------------------------------
+ * Other boards: connect the non-configurable pins to the corresponding 
+ * SPI-related pins (MISO, MOSI). Connect the configurable pins to any
+ * general-purpose IO digital ports and adjust the declaration below.
+ * --------------------------------------------------------------------------
+ */
+
+EasyMFRC522 rfidReader(D4, D3); //the Mifare sensor, with the SDA and RST pins given
+
+RfidStaticBatch<4> batch;   // up to 4 requests
+
+char name[] = "Pablo";
+uint16_t counters[4] = { 0, 0, 0, 0 };
+byte history[32];
+
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial)
+    ;
+
+  // you must call this initialization function!
+  rfidReader.init();
+}
+
+void loop() {
+  Serial.println();
+  Serial.println("APPROACH a Mifare tag. Waiting...");
+
+  while (!rfidReader.detectTag()) {
+    delay(50); //0.05s
+  }
+  Serial.println("--> PICC DETECTED!");
+
+  counters[0] ++;
+  for (int i = 0; i < 32; i ++) {
+    history[i] = 0;
+  }
+
+  // the requests are given in any order (and may overlap)
+  batch.clear();
+  batch.addWrite(8, (byte*)counters, sizeof(counters));      // block 8 (sector 2)
+  batch.addWriteFile(1, "name", (byte*)name, sizeof(name));   // blocks 1-2 (sector 0)
+  batch.addRead(12, history, sizeof(history));               // blocks 12-13 (sector 3)
+  batch.addRead(4, history, 16);                             // block 4 (sector 1)
+
+  int result = rfidReader.executeBatch(batch);
+  if (result >= 0) {
+    Serial.print("--> Batch done, sectors accessed: ");
+    Serial.println(result);
+  } else {
+    Serial.print("--> Error in the batch: ");
+    Serial.println(result);
+  }
+
+  // the result of each request
+  for (int i = 0; i < batch.getNumRequests(); i ++) {
+    Serial.print("    request ");
+    Serial.print(i);
+    Serial.print(": ");
+    Serial.println(batch.getResult(i));
+  }
+
+  // call this after doing all desired operations in the tag
+  rfidReader.unselectMifareTag();
+
+  Serial.println();
+  Serial.println("Finished operation!");
+  delay(3000);
+}
@@ -0,0 +1,173 @@
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - Benchmark
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ *
+ * -----------------------------------------
+ * Measures the cost of the unlabeled operations (writeRaw/readRaw) for a few
+ * SPI clocks. For each operation, it reports the time spent and the SPI traffic
+ * per block operation (transactions and bytes), as counted by the class. The reads of
+ * ComIrqReg while waiting for the tag (polls, which grow with the SPI clock) are given
+ * apart, in "polls_per_op", and are not included in the other two columns.
+ *
+ * Then, it compares plain, encrypted and parity-protected files (writeFile/readFile),
+ * and reports the time to encrypt one block (16 bytes) with RfidCipher, in the line
+ * "cipher_block" (whose "micros" column is the average time per block). The line
+ * "parity_recovered" gives the number of blocks rebuilt from parity in the last read.
+ *
+ * The results are printed as CSV lines (starting with "csv,") to make it easy to
+ * compare them between versions of the library.
+ *
+ * The same SPI traffic may be measured without a board, against a simulated MFRC522
+ * on Linux: see tools/host/spi_traffic.cpp ("make -C tools/host test"). The parity is
+ * measured there with injected read failures (which are rare in a real tag, so the line
+ * "parity_recovered" usually gives 0): see tools/host/parity_bench.cpp.
+ *
+ * Attention: it overwrites the blocks starting at BLOCK in the tag!
+ *
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      Arduino       NodeMCU
+ * Reader       Uno           Esp8266
+ * Pin          Pin           Pin
+ * -----------------------------------------
+ * SDA(SS)      4*            D4*
+ * SCK          13            D5
+ * MOSI         11            D7
+ * MISO         12            D6
+ * RST          3*            D3*
+ * NC(IRQ)      not used      not used
+ * 3.3V         3.3V          3V
+ * GND          GND           GND
+ * --------------------------------------------------------------------------
+ */
+
+EasyMFRC522 rfidReader(D4, D3); //the MFRC522 reader, with the SDA and RST pins given
+
+#define BLOCK       1     // the initial block for all operations
+#define DATA_SIZE   48    // 3 blocks (a full sector of user data in Mifare 1k)
+
+const uint32_t clocks[] = { 1000000UL, 4000000UL, 10000000UL };
+
+#define CIPHER_BLOCKS  64  // blocks encrypted to measure the throughput of the cipher
+
+byte data[DATA_SIZE];
+
+const byte aesKey[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+RfidCipher cipher(aesKey);
+
+void printResult(const char* operation, unsigned long elapsedMicros, int result);
+
+
+void setup() {
+  Serial.begin(9600);
+
+  while (!Serial)
+    ;
+
+  rfidReader.init();
+  delay(1000);
+
+  for (int i = 0; i < DATA_SIZE; i ++) {
+    data[i] = (byte)i;
+  }
+}
+
+
+void loop() {
+  Serial.println();
+  Serial.println("APPROACH a Mifare tag. Waiting...");
+
+  bool success;
+  do {
+    success = rfidReader.detectTag();
+    delay(50);
+  } while (!success);
+
+  Serial.println("--> TAG DETECTED!\n");
+  Serial.println("csv,operation,spi_clock,micros,result,block_ops,transactions_per_op,bytes_per_op,polls_per_op");
+
+  unsigned long start;
+  int result;
+
+  for (unsigned int c = 0; c < sizeof(clocks)/sizeof(clocks[0]); c ++) {
+    rfidReader.setSpiClock(clocks[c]);
+
+    rfidReader.resetTransferStats();
+    start = micros();
+    result = rfidReader.writeRaw(BLOCK, data, DATA_SIZE);
+    printResult("writeRaw", micros() - start, result);
+
+    rfidReader.resetTransferStats();
+    start = micros();
+    result = rfidReader.readRaw(BLOCK, data, DATA_SIZE);
+    printResult("readRaw", micros() - start, result);
+  }
+
+  // files, plain and encrypted (at the maximum clock)
+  for (int encrypted = 0; encrypted <= 1; encrypted ++) {
+    rfidReader.setFileCipher(encrypted? &cipher : NULL);
+
+    rfidReader.resetTransferStats();
+    start = micros();
+    result = rfidReader.writeFile(BLOCK, "bench", data, DATA_SIZE);
+    printResult(encrypted? "writeFile_encrypted" : "writeFile", micros() - start, result);
+
+    rfidReader.resetTransferStats();
+    start = micros();
+    result = rfidReader.readFile(BLOCK, "bench", data, DATA_SIZE);
+    printResult(encrypted? "readFile_encrypted" : "readFile", micros() - start, result);
+  }
+  rfidReader.setFileCipher(NULL);
+
+  // file with parity (1 parity block for each 4 data blocks), which costs 1 block more in the tag
+  rfidReader.setFileParity(4);
+  rfidReader.resetTransferStats();
+  start = micros();
+  result = rfidReader.writeFile(BLOCK, "bench", data, DATA_SIZE);
+  printResult("writeFile_parity", micros() - start, result);
+
+  rfidReader.resetTransferStats();
+  start = micros();
+  result = rfidReader.readFile(BLOCK, "bench", data, DATA_SIZE);
+  printResult("readFile_parity", micros() - start, result);
+  printResult("parity_recovered", 0, rfidReader.getTransferStats().blocksRecovered);
+  rfidReader.setFileParity(0);
+
+  // encryption alone (no access to the tag), as done for each block of an encrypted file
+  byte nonce[13] = { 0 };
+  byte tag[8];
+  byte chunk[16] = { 0 };
+  rfidReader.resetTransferStats();
+  start = micros();
+  cipher.begin(nonce, NULL, 0, CIPHER_BLOCKS * 16);
+  for (int i = 0; i < CIPHER_BLOCKS; i ++) {
+    cipher.encrypt(chunk, 16);
+  }
+  cipher.finish(tag);
+  printResult("cipher_block", (micros() - start) / CIPHER_BLOCKS, CIPHER_BLOCKS);
+
+  rfidReader.unselectMifareTag();
+
+  Serial.println();
+  Serial.println("Finished benchmark!");
+  delay(3000);
+}
+
+void printResult(const char* operation, unsigned long elapsedMicros, int result) {
+  const EasyMFRC522::TransferStats& stats = rfidReader.getTransferStats();
+  unsigned long ops = (stats.blockOperations > 0)? stats.blockOperations : 1;
+
+  Serial.print("csv,");
+  Serial.print(operation);             Serial.print(",");
+  Serial.print(rfidReader.getSpiClock()); Serial.print(",");
+  Serial.print(elapsedMicros);         Serial.print(",");
+  Serial.print(result);                Serial.print(",");
+  Serial.print(stats.blockOperations); Serial.print(",");
+  Serial.print((float)(stats.spiTransactions - stats.spiPolls) / ops); Serial.print(",");
+  Serial.print((float)(stats.spiBytes - 2 * stats.spiPolls) / ops);   Serial.print(",");
+  Serial.println((float)stats.spiPolls / ops);
+}
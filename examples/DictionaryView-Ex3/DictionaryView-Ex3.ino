@@ -0,0 +1,112 @@
+
+#include "EasyMFRC522.h"
+
+ /**
+  * ----------------------------------------------------------------------------
+  * Easy MFRC522 library - Dictionary View - Example #3
+  * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+  *
+  * -----------------------------------------
+  * Same as Example #1, but using RfidStaticDictionary, which has a fixed capacity
+  * (given at compile time) and does no dynamic allocation. Keys and values are
+  * C strings, and errors (e.g. capacity exceeded) are returned as negative numbers.
+  *
+  * Hardware: you need an Arduino or Esp8266 connected to a MFRC522 reader, and
+  * at least one Mifare Classic card/tag.
+  *
+  * -----------------------------------------
+  * Pin layout used (where * indicates configurable pin):
+  * -----------------------------------------
+  * MFRC522      Arduino       NodeMCU
+  * Reader       Uno           Esp8266
+  * Pin          Pin           Pin
+  * -----------------------------------------
+  * SDA(SS)      4*            D4*
+  * SCK          13            D5
+  * MOSI         11            D7
+  * MISO         12            D6
+  * RST          3*            D3*
+  * NC(IRQ)      not used      not used
+  * 3.3V         3.3V          3V
+  * GND          GND           GND
+  * --------------------------------------------------------------------------
+  */
+
+EasyMFRC522 rfidReader(D4, D3);  // parameters: ports for SDA and RST pins
+
+// at most 128 bytes and 8 entries; the dictionary starts in block 10
+RfidStaticDictionary<128, 8> rfidDict(&rfidReader, 10);
+
+void printDictionary();
+
+
+void setup() {
+  Serial.begin(9600);
+
+  while (!Serial)
+    ;
+
+  rfidReader.init();
+  delay(1000);
+}
+
+
+void loop() {
+  bool tagSelected;
+
+  Serial.println();
+  Serial.println("STEP 0: Approach a Mifare tag. Waiting...");
+
+  do {
+    tagSelected = rfidDict.detectTag();
+    delay(5);
+  } while (!tagSelected);
+
+  Serial.println(" --> PICC DETECTED (Mifare Classic)\n");
+
+  int result;
+
+  Serial.println("STEP 1: Setting values for keys \"PERSON\", \"ADDRESS\" and \"AGE\"");
+  result = rfidDict.set("PERSON", "Joe van Paul");
+  result = (result < 0)? result : rfidDict.set("ADDRESS", "Up above Street, 0");
+  result = (result < 0)? result : rfidDict.set("AGE", "30");
+  if (result < 0) {
+    Serial.print(" --> Error: ");
+    Serial.println(result);
+  }
+  Serial.println();
+
+  Serial.println("STEP 2 - Full content of the DICTIONARY");
+  printDictionary();
+
+  Serial.println("STEP 3: Removing key \"AGE\"");
+  result = rfidDict.remove("AGE");
+  if (result < 0) {
+    Serial.print(" --> Error: ");
+    Serial.println(result);
+  }
+  Serial.println();
+
+  Serial.println("STEP 4 - Full content of the DICTIONARY");
+  printDictionary();
+
+  Serial.println("---> Example finished. Restarting in 10 secs. <---\n");
+  rfidDict.disconnectTag();
+  delay(9000);
+}
+
+void printDictionary() {
+  char key[32];
+  char value[64];
+  int numEntries = rfidDict.getNumEntries();
+
+  for (int i = 0; i < numEntries; i ++) {
+    if (rfidDict.getKey(i, key, sizeof(key)) >= 0 && rfidDict.get(key, value, sizeof(value)) >= 0) {
+      Serial.print("  | ");
+      Serial.print(key);
+      Serial.print(" \t=> ");
+      Serial.println(value);
+    }
+  }
+  Serial.println("  --------------------------------\n");
+}
@@ -0,0 +1,110 @@
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - Inventory - Example #1
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ *
+ * -----------------------------------------
+ * Reads a labeled data chunk (file) from each one of multiple tags presented
+ * together (e.g. a stack of cards) to the reader, without separating them.
+ *
+ * First, inventory() finds the UIDs of all tags in the field. Then, processTags()
+ * selects each tag in turn, calls the function "readLabel" and halts the tag.
+ * The number of tags processed per second is printed in the end.
+ *
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      Arduino       NodeMCU
+ * Reader       Uno           Esp8266
+ * Pin          Pin           Pin
+ * -----------------------------------------
+ * SDA(SS)      4*            D4*
+ * SCK          13            D5
+ * MOSI         11            D7
+ * MISO         12            D6
+ * RST          3*            D3*
+ * NC(IRQ)      not used      not used
+ * 3.3V         3.3V          3V
+ * GND          GND           GND
+ * --------------------------------------------------------------------------
+ */
+
+EasyMFRC522 rfidReader(D4, D3); //the MFRC522 reader, with the SDA and RST pins given
+
+#define MAX_TAGS  8
+#define BLOCK     1    // block where the file starts, in all tags
+
+MFRC522::Uid uids[MAX_TAGS];
+int results[MAX_TAGS];
+char labels[MAX_TAGS][32];
+
+
+// called by processTags() for each tag, while it is selected
+int readLabel(EasyMFRC522* reader, const MFRC522::Uid* uid, void* context) {
+  int index = uid - uids;  // position of the tag in the array
+  int result = reader->readFile(BLOCK, "parcel", (byte*)labels[index], sizeof(labels[index]) - 1);
+  if (result >= 0) {
+    labels[index][result] = '\0';
+  }
+  return result;
+}
+
+
+void setup() {
+  Serial.begin(9600);
+
+  while (!Serial)
+    ;
+
+  rfidReader.init();
+  delay(1000);
+}
+
+
+void loop() {
+  Serial.println();
+  Serial.println("APPROACH a stack of Mifare tags and TYPE any key...");
+
+  while (Serial.available() == 0) // waits for incoming data
+    ;
+  while (Serial.available() > 0) {
+    Serial.read();
+  }
+
+  unsigned long start = millis();
+
+  int numTags = rfidReader.inventory(uids, MAX_TAGS);
+  int processed = rfidReader.processTags(uids, numTags, readLabel, NULL, results);
+
+  unsigned long elapsed = millis() - start;
+
+  Serial.print("--> Tags found: ");
+  Serial.println(numTags);
+
+  for (int i = 0; i < numTags; i ++) {
+    Serial.print("   - UID ");
+    for (byte j = 0; j < uids[i].size; j ++) {
+      Serial.print(uids[i].uidByte[j], HEX);
+    }
+    if (results[i] >= 0) {
+      Serial.print(": ");
+      Serial.println(labels[i]);
+    } else {
+      Serial.print(": error ");
+      Serial.println(results[i]);
+    }
+  }
+
+  Serial.print("--> Processed ");
+  Serial.print(processed);
+  Serial.print(" tags in ");
+  Serial.print(elapsed);
+  Serial.print(" ms (");
+  Serial.print((elapsed > 0)? (1000.0 * processed / elapsed) : 0.0);
+  Serial.println(" tags/s)");
+
+  rfidReader.unselectMifareTag(true);  // restarts the tags, to allow detecting them again
+  delay(3000);
+}
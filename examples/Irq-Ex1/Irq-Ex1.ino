@@ -0,0 +1,82 @@
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - IRQ - Example #1
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ *
+ * -----------------------------------------
+ * Shows the IRQ mode, where the IRQ pin of the MFRC522 signals the end of each
+ * command. Then, detectTag() doesn't block waiting for the tags, and the board 
+ * is free (e.g. to sleep, or to do other tasks) while there is no tag. Block
+ * reads/writes also wait for the IRQ, instead of polling the MFRC522.
+ *
+ * The example counts how many times loop() runs while no tag is present (i.e.
+ * how free the board is), and shows the time to read a block after detection.
+ *
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      Arduino       NodeMCU
+ * Reader       Uno           Esp8266
+ * Pin          Pin           Pin
+ * -----------------------------------------
+ * SDA(SS)      4*            D4*
+ * SCK          13            D5
+ * MOSI         11            D7
+ * MISO         12            D6
+ * RST          3*            D3*
+ * IRQ          2*            D2*     (must be an interrupt pin)
+ * 3.3V         3.3V          3V
+ * GND          GND           GND
+ * --------------------------------------------------------------------------
+ */
+
+EasyMFRC522 rfidReader(D4, D3); //the MFRC522 reader, with the SDA and RST pins given
+
+#define IRQ_PIN  D2
+#define BLOCK    1
+
+unsigned long idleLoops = 0;
+
+
+void setup() {
+  Serial.begin(9600);
+
+  while (!Serial)
+    ;
+
+  rfidReader.init();
+  if (! rfidReader.enableIrq(IRQ_PIN)) {
+    Serial.println("Could not enable the IRQ mode (is it an interrupt pin?)");
+  }
+  delay(1000);
+
+  Serial.println("APPROACH a Mifare tag. Waiting...");
+}
+
+
+void loop() {
+  // returns immediately; the tag is detected in the first call after the IRQ
+  if (! rfidReader.detectTag()) {
+    idleLoops ++;
+    // ... other tasks here ...
+    return;
+  }
+
+  Serial.print("--> TAG DETECTED! Loops while waiting: ");
+  Serial.println(idleLoops);
+  idleLoops = 0;
+
+  byte data[16];
+  unsigned long start = micros();
+  int result = rfidReader.readRaw(BLOCK, data, 16);
+  unsigned long elapsed = micros() - start;
+
+  Serial.print("    readRaw: "); Serial.print(result);
+  Serial.print(", time (us): ");  Serial.println(elapsed);
+
+  rfidReader.unselectMifareTag();
+  delay(2000);
+  Serial.println("APPROACH a Mifare tag. Waiting...");
+}
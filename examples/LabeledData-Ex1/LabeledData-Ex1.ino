@@ -60,6 +60,13 @@ void setup() {
 
   // you must call this initialization function!
   rfidReader.init(); 
+
+  // the library doesn't print anything; the version of the MFRC522 (or a communication 
+  // failure, with code -13) is given in the diagnostics, as well as the errors with the tags
+  RfidDiagnostic event;
+  while (rfidReader.popDiagnostic(&event)) {
+    printfSerial("Diagnostic event: code %d, block %d, status 0x%x\n", event.code, event.block, event.status);
+  }
 }
 
 
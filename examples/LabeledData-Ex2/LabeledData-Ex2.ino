@@ -64,6 +64,11 @@ int historySize;      // counts occupied/useful positions
 
 #define BLOCK  16     // writes from this block on, in the tag
 
+// the history is read as soon as a tag is detected, so that existsFile() and 
+// readFile() below are answered from RAM, without accessing the tag again
+RfidPrefetchEntry prefetchList[] = { {BLOCK, "history"} };
+byte prefetchBuffer[sizeof(AccessRecord)*HISTORY_MAX_SIZE];
+
 
 void setup() {
   Serial.begin(9600);
@@ -72,6 +77,7 @@ void setup() {
     ;
 
   rfidReader.init();
+  rfidReader.setPrefetchList(prefetchList, 1, prefetchBuffer, sizeof(prefetchBuffer));
 
   delay(1000);
 }
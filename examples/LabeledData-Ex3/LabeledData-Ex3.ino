@@ -0,0 +1,135 @@
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - Labeled Data - Example #3
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ * 
+ * -----------------------------------------
+ * Shows how to read/write files with no buffer for the whole data, using the
+ * streaming functions. The data goes from the serial port directly to the tag 
+ * (and vice-versa), one block (16 bytes) at a time. So, files of any size that 
+ * fits the tag can be handled, even in boards with little RAM.
+ * 
+ * It also shows a custom "sink" function, that receives the data as it is read
+ * from the tag, to calculate a simple checksum of the file.
+ * 
+ * Hardware: you need an Arduino or Esp8266 connected to a MFRC522 reader, and
+ * at least one Mifare Classic card/tag.
+ * 
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      Arduino       NodeMCU
+ * Reader       Uno           Esp8266
+ * Pin          Pin           Pin    
+ * -----------------------------------------
+ * SDA(SS)      4*            D4*
+ * SCK          13            D5   
+ * MOSI         11            D7
+ * MISO         12            D6
+ * RST          3*            D3*
+ * NC(IRQ)      not used      not used
+ * 3.3V         3.3V          3V
+ * GND          GND           GND
+ * --------------------------------------------------------------------------
+ */
+
+#define BLOCK 1    // initial block, from where the data will be stored in the tag
+
+EasyMFRC522 rfidReader(D4, D3); //the Mifare sensor, with the SDA and RST pins given
+
+int sumBytes(const byte* chunk, int position, int length, void* context);
+
+
+void setup() {
+  Serial.begin(9600);
+  Serial.setTimeout(20000); // to wait for up to 20s in "read" functions
+  
+  while (!Serial)
+    ;
+
+  rfidReader.init(); 
+}
+
+
+void loop() {
+  Serial.println("========================="); Serial.println();
+  Serial.println("CHOOSE an operation: ");
+  Serial.println("  'w' to write the text typed (to a RFID tag)");
+  Serial.println("  'r' to read the text (from a RFID tag)");
+  Serial.println("  'c' to calculate the checksum of the text in the tag");
+
+  while (Serial.available() == 0) // waits for incoming data
+    ;
+
+  char option = Serial.read();
+  int size = 0;
+
+  if (option == 'w') {
+    Serial.println("TYPE the size of the text (in bytes): ");
+    size = Serial.parseInt();
+    while (Serial.available() > 0) {  // clear the end of the line
+      Serial.read();
+    }
+  }
+
+  Serial.println();
+  Serial.println("APPROACH a Mifare tag. Waiting...");
+
+  bool success;
+  do {
+    success = rfidReader.detectTag();    
+    delay(50);
+  } while (!success);
+
+  Serial.println("--> PICC DETECTED!");
+
+  int result = 0;
+
+  if (option == 'w') {
+    Serial.print("TYPE the text, with "); Serial.print(size); Serial.println(" chars:");
+
+    // each block of 16 bytes is written to the tag as soon as it arrives in the serial port
+    result = rfidReader.writeFile(BLOCK, "stream", Serial, size);
+
+  } else if (option == 'r') {
+    // each block is printed as soon as it is read from the tag
+    Serial.print("--> Text: ");
+    result = rfidReader.readFile(BLOCK, "stream", Serial);
+    Serial.println();
+
+  } else if (option == 'c') {
+    unsigned long checksum = 0;
+    result = rfidReader.readFileStream(BLOCK, "stream", sumBytes, &checksum);
+    if (result >= 0) {
+      Serial.print("--> Checksum: ");
+      Serial.println(checksum);
+    }
+  }
+
+  if (result < 0) {
+    Serial.print("--> Error: ");
+    Serial.println(result);
+  }
+
+  while (Serial.available() > 0) {  // clear "garbage" input from serial
+    Serial.read();
+  }
+
+  rfidReader.unselectMifareTag();
+  
+  Serial.println();
+  Serial.println("Finished operation!");
+  Serial.println();
+  delay(3000);
+}
+
+// Sink function: called for each block read from the tag (with up to 16 bytes).
+int sumBytes(const byte* chunk, int position, int length, void* context) {
+  unsigned long* checksum = (unsigned long*)context;
+  for (int i = 0; i < length; i ++) {
+    *checksum += chunk[i];
+  }
+  return 0;  // a negative value would stop the reading
+}
@@ -0,0 +1,123 @@
+
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - Packed Data - Example #1
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ * 
+ * -----------------------------------------
+ * Example of storing tiny values (of a few bytes) in the tag with less blocks.
+ * 
+ * A usual file takes a block for its header and another one for its data. With 
+ * setFilePacking(true), files of 1 or 2 bytes are kept inside their headers, so
+ * they take a single block. And several tiny values may share a single block with
+ * writePackedValue(). In both cases, each value is read with a single block read.
+ * 
+ * Hardware: you need an Arduino or Esp8266 connected to a MFRC522 reader, and
+ * at least one Mifare Classic card/tag.
+ * 
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      Arduino       NodeMCU
+ * Reader       Uno           Esp8266
+ * Pin          Pin           Pin    
+ * -----------------------------------------
+ * SDA(SS)      4*            D4*
+ * SCK          13            D5   
+ * MOSI         11            D7
+ * MISO         12            D6
+ * RST          3*            D3*
+ * NC(IRQ)      not used      not used
+ * 3.3V         3.3V          3V
+ * GND          GND           GND
+ * -----------------------------------------
+ * Other boards: connect the non-configurable pins to the corresponding 
+ * SPI-related pins (MISO, MOSI). Connect the configurable pins to any
+ * general-purpose IO digital ports and adjust the declaration below.
+ * --------------------------------------------------------------------------
+ */
+
+#define FILE_BLOCK    1   // block of the file with the level (1 byte)
+#define PACKED_BLOCK  2   // block shared by the values "hp", "mp" and "xp"
+
+EasyMFRC522 rfidReader(D4, D3); //the Mifare sensor, with the SDA and RST pins given
+
+// printf-style function for serial output
+void printfSerial(const char *fmt, ...);
+
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial)
+    ;
+
+  // you must call this initialization function!
+  rfidReader.init();
+
+  // files of 1 or 2 bytes are written inside their headers (a single block)
+  rfidReader.setFilePacking(true);
+}
+
+void loop() {
+  Serial.println();
+  Serial.println("APPROACH a Mifare tag. Waiting...");
+
+  while (!rfidReader.detectTag()) {
+    delay(50); //0.05s
+  }
+  Serial.println("--> PICC DETECTED!");
+
+  int result;
+  byte level = 0;
+  byte points[2] = { 0, 0 };   // "hp" and "mp"
+  uint16_t xp = 0;
+
+  // reads the values (possibly not written yet)
+  result = rfidReader.readFile(FILE_BLOCK, "level", &level, 1);
+  printfSerial("level: %d (result: %d)\n", level, result);
+
+  result = rfidReader.readPackedValue(PACKED_BLOCK, "hp", &points[0], 1);
+  printfSerial("hp: %d (result: %d)\n", points[0], result);
+  result = rfidReader.readPackedValue(PACKED_BLOCK, "mp", &points[1], 1);
+  printfSerial("mp: %d (result: %d)\n", points[1], result);
+  result = rfidReader.readPackedValue(PACKED_BLOCK, "xp", (byte*)&xp, 2);
+  printfSerial("xp: %u (result: %d)\n", xp, result);
+
+  // changes and writes them back
+  level ++;
+  points[0] += 10;
+  points[1] += 5;
+  xp += 100;
+
+  result = rfidReader.writeFile(FILE_BLOCK, "level", &level, 1);
+  printfSerial("--> writing level, last block used: %d\n", result);
+
+  // the three values share the same block
+  rfidReader.writePackedValue(PACKED_BLOCK, "hp", &points[0], 1);
+  rfidReader.writePackedValue(PACKED_BLOCK, "mp", &points[1], 1);
+  result = rfidReader.writePackedValue(PACKED_BLOCK, "xp", (byte*)&xp, 2);
+  printfSerial("--> writing packed values, result: %d\n", result);
+
+  // call this after doing all desired operations in the tag
+  rfidReader.unselectMifareTag();
+
+  Serial.println();
+  Serial.println("Finished operation!");
+  delay(3000);
+}
+
+
+/**
+ * this function is a substitute  toSerial.printf() function, which was used in the 
+ * first versions of this library, but seems to be unavailable for some operating systems.
+ */
+void printfSerial(const char *fmt, ...) {
+  char buf[128];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  Serial.print(buf);
+}
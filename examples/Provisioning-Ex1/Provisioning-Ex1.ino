@@ -0,0 +1,108 @@
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - Provisioning - Example #1
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ *
+ * -----------------------------------------
+ * Shows how to write the same content to many tags (e.g. to issue new badges)
+ * with a provisioning image. The image is built only once, in setup(), with a
+ * file and a dictionary (readable with RfidDictionaryView). Then, it is applied
+ * to each tag approached, with one authentication per sector and one verification
+ * pass (the blocks that the tag already has are not written again).
+ *
+ * After each tag, the example shows the time to apply the image and the rate of
+ * tags per minute (counting only the time with the tags in the field).
+ *
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      Arduino       NodeMCU
+ * Reader       Uno           Esp8266
+ * Pin          Pin           Pin
+ * -----------------------------------------
+ * SDA(SS)      4*            D4*
+ * SCK          13            D5
+ * MOSI         11            D7
+ * MISO         12            D6
+ * RST          3*            D3*
+ * NC(IRQ)      not used      not used
+ * 3.3V         3.3V          3V
+ * GND          GND           GND
+ * --------------------------------------------------------------------------
+ */
+
+EasyMFRC522 rfidReader(D4, D3); //the MFRC522 reader, with the SDA and RST pins given
+
+RfidProvisioningImage<12> image;
+
+unsigned long tagsWritten = 0;
+unsigned long totalMicros = 0;
+
+
+void setup() {
+  Serial.begin(9600);
+
+  while (!Serial)
+    ;
+
+  rfidReader.init();
+
+  const char* company = "ACME Corporation";
+  const char* keys[]   = { "role", "level" };
+  const char* values[] = { "visitor", "1" };
+
+  int result = image.addFile(1, "company", (const byte*)company, strlen(company) + 1);
+  if (result >= 0) {
+    result = image.addDictionary(8, keys, values, 2);
+  }
+  if (result < 0) {
+    Serial.print("Error building the image: ");
+    Serial.println(result);
+  }
+
+  Serial.print("Image with ");
+  Serial.print(image.getNumBlocks());
+  Serial.print(" blocks, in ");
+  Serial.print(image.getNumSectors());
+  Serial.println(" sectors");
+
+  delay(1000);
+}
+
+
+void loop() {
+  Serial.println();
+  Serial.println("APPROACH a Mifare tag. Waiting...");
+
+  bool success;
+  do {
+    success = rfidReader.detectTag();
+    delay(50);
+  } while (!success);
+
+  unsigned long start = micros();
+  int result = rfidReader.applyImage(image, RFID_IMAGE_VERIFY | RFID_IMAGE_SKIP_UNCHANGED);
+  unsigned long elapsed = micros() - start;
+
+  rfidReader.unselectMifareTag();
+
+  if (result < 0) {
+    Serial.print("--> Error: ");
+    Serial.println(result);
+  } else {
+    tagsWritten ++;
+    totalMicros += elapsed;
+
+    Serial.print("--> Blocks written: ");
+    Serial.print(result);
+    Serial.print(", time: ");
+    Serial.print(elapsed / 1000);
+    Serial.println(" ms");
+    Serial.print("--> Tags per minute (time in the field): ");
+    Serial.println(60000000.0 * tagsWritten / totalMicros);
+  }
+
+  delay(2000);
+}
@@ -0,0 +1,99 @@
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - Reader Service - Example #1
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ *
+ * -----------------------------------------
+ * Shows class RfidReaderService (only for ESP32), which owns the reader in a 
+ * dedicated FreeRTOS task. Other tasks submit requests, that are completed later
+ * in that task. The result may be waited for (as a "future"), or handled by a
+ * callback. Requests pending together are served in a single session with the tag.
+ *
+ * In this example, loop() submits a write request, with a callback, and a read
+ * request of the same block, waiting for its result. Both are served when the
+ * tag is approached, in the same session.
+ *
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      ESP32
+ * Reader       DevKit
+ * Pin          Pin
+ * -----------------------------------------
+ * SDA(SS)      5*
+ * SCK          18
+ * MOSI         23
+ * MISO         19
+ * RST          22*
+ * NC(IRQ)      not used
+ * 3.3V         3.3V
+ * GND          GND
+ * --------------------------------------------------------------------------
+ */
+
+#ifndef RFID_READER_SERVICE_AVAILABLE
+#error "This example requires an ESP32"
+#endif
+
+EasyMFRC522 rfidReader(5, 22); //the MFRC522 reader, with the SDA and RST pins given
+RfidReaderService service(&rfidReader);
+
+#define BLOCK  1
+
+byte counter = 0;
+byte writeBuffer[16];
+byte readBuffer[16];
+RfidRequest writeRequest;
+RfidRequest readRequest;
+
+
+// called in the task of the service
+void onWriteDone(RfidRequest* request, void* context) {
+  Serial.print("   - write completed, result: ");
+  Serial.println(request->result);
+}
+
+void setup() {
+  Serial.begin(9600);
+
+  while (!Serial)
+    ;
+
+  rfidReader.init();
+  service.start();
+  delay(1000);
+}
+
+
+void loop() {
+  Serial.println();
+  Serial.println("APPROACH a Mifare tag. Waiting...");
+
+  counter ++;
+  memset(writeBuffer, counter, 16);
+
+  writeRequest.setWrite(BLOCK, writeBuffer, 16);
+  writeRequest.setCallback(onWriteDone);
+  writeRequest.timeout = 10000;
+  service.submit(&writeRequest);
+
+  readRequest.setRead(BLOCK, readBuffer, 16);
+  readRequest.timeout = 10000;
+  service.submit(&readRequest);
+
+  // the task of loop() is free until here; now, it waits for the result of the reading
+  readRequest.wait();
+  writeRequest.wait();
+
+  if (readRequest.result < 0) {
+    Serial.print("--> Error: ");
+    Serial.println(readRequest.result);
+  } else {
+    Serial.print("--> Read from the tag: ");
+    Serial.println(readBuffer[0]);
+  }
+
+  delay(3000);
+}
@@ -0,0 +1,132 @@
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - Record - Example #1
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ *
+ * -----------------------------------------
+ * Shows how to update single fields of a struct stored in the tag, with class
+ * RfidRecord. The layout of the struct is declared as an array of fields, and
+ * only the blocks of the tag that hold the updated field(s) are written.
+ *
+ * In this example, the struct spans 3 blocks (40 bytes): the name fills the first
+ * two blocks, and the counter and the expiration time share the third block.
+ * Updating the expiration time rewrites only that third block.
+ *
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      Arduino       NodeMCU
+ * Reader       Uno           Esp8266
+ * Pin          Pin           Pin
+ * -----------------------------------------
+ * SDA(SS)      4*            D4*
+ * SCK          13            D5
+ * MOSI         11            D7
+ * MISO         12            D6
+ * RST          3*            D3*
+ * NC(IRQ)      not used      not used
+ * 3.3V         3.3V          3V
+ * GND          GND           GND
+ * --------------------------------------------------------------------------
+ * Obs.: This code may not work if you use different types of boards to alternately
+ * read/write, because of the memory size and alignment of the struct.
+ */
+
+EasyMFRC522 rfidReader(D4, D3); //the MFRC522 reader, with the SDA and RST pins given
+
+#define BLOCK  1    //the initial block of the record
+
+struct Credentials {
+  char personName[32];
+  uint32_t useCounter;
+  int16_t expireHour;    //0-23h
+  int16_t expireMinute;
+};
+
+const RfidField layout[] = {
+  RFID_FIELD(Credentials, personName,   RFID_FIELD_STRING),
+  RFID_FIELD(Credentials, useCounter,   RFID_FIELD_UINT32),
+  RFID_FIELD(Credentials, expireHour,   RFID_FIELD_INT16),
+  RFID_FIELD(Credentials, expireMinute, RFID_FIELD_INT16)
+};
+
+RfidRecord record(&rfidReader, BLOCK, layout, 4);
+
+
+void setup() {
+  Serial.begin(9600);
+
+  while (!Serial)
+    ;
+
+  rfidReader.init();
+  delay(1000);
+}
+
+
+void loop() {
+  Serial.println("=========================");
+  Serial.println("CHOOSE an operation: ");
+  Serial.println("  'w' to write a whole new record");
+  Serial.println("  'e' to update only the expiration time");
+  Serial.println("  'r' to read the name and the expiration time");
+
+  while (Serial.available() == 0) // waits for incoming data
+    ;
+
+  char option = Serial.read();
+
+  Serial.println();
+  Serial.println("APPROACH a Mifare tag. Waiting...");
+
+  bool success;
+  do {
+    success = rfidReader.detectTag();
+    delay(50);
+  } while (!success);
+
+  Serial.println("--> TAG DETECTED!\n");
+  int result = 0;
+
+  if (option == 'w') {
+    Credentials credentials = { "Pablo Sampaio", 0, 23, 59 };
+    result = record.writeRecord(&credentials);
+
+  } else if (option == 'e') {
+    int16_t hour = random(0, 24);
+    int16_t minute = random(0, 60);
+    const char* names[2] = { "expireHour", "expireMinute" };
+    const void* values[2] = { &hour, &minute };
+    result = record.writeFields(names, values, 2);  // both fields are in the same block: a single block is written
+
+  } else if (option == 'r') {
+    char name[32];
+    int16_t hour, minute;
+    result = record.readField("personName", name);
+    if (result >= 0) result = record.readField("expireHour", &hour);
+    if (result >= 0) result = record.readField("expireMinute", &minute);
+    if (result >= 0) {
+      Serial.print("   - Name: ");            Serial.println(name);
+      Serial.print("   - Expiration time: "); Serial.print(hour);
+      Serial.print(":");                      Serial.println(minute);
+    }
+  }
+
+  if (result < 0) {
+    Serial.print("--> Error: ");
+    Serial.println(result);
+  }
+
+  while (Serial.available() > 0) {  // clear "garbage" input from serial
+    Serial.read();
+  }
+
+  rfidReader.unselectMifareTag();
+
+  Serial.println();
+  Serial.println("Finished operation!");
+  Serial.println();
+  delay(3000);
+}
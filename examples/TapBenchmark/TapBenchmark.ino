@@ -0,0 +1,304 @@
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - Tap Benchmark
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ *
+ * -----------------------------------------
+ * Measures the time in the field of each "tap" (detection of the tag, the operations
+ * of the application and the release of the tag) for fixed workloads taken from the
+ * scenarios of the other examples:
+ *   - raw_read:       an unlabeled fixed-size read, as in "Unlabeled Data - Ex1"
+ *   - history_append: the access history of "Labeled Data - Ex2" is read and written
+ *                     back with one more record
+ *   - dict_get, dict_set, dict_mix: a RfidDictionaryView is loaded from the tag and
+ *                     then gets/sets/removes some keys (dict_mix alternates sets with
+ *                     removals), as in the "DictionaryView" examples
+ *
+ * Each workload is run for TAPS taps with the tag kept still over the reader. For each
+ * one, it prints a CSV line (starting with "csv,") with the median (p50) and the 99th
+ * percentile (p99) of the time of the taps, the median of the time spent in the
+ * commands to the tag (as recorded in the trace), the average and maximum number of
+ * commands to the tag (RF transactions) per tap, and the peak heap used in a tap
+ * (only in the ESP8266 and ESP32; -1 in the other boards). So, the lines may be
+ * compared between versions of the library to find regressions.
+ *
+ * The trace must be enabled in the library (see EasyMFRC522Config.h).
+ *
+ * The same workloads run on Linux, against the timing model of the simulated MFRC522
+ * (without the board and the tag), with the tool tools/host/tap_bench.cpp, that prints
+ * these lines with the simulated times.
+ *
+ * Attention: it overwrites the blocks from RAW_BLOCK on, in the tag!
+ *
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      Arduino       NodeMCU
+ * Reader       Uno           Esp8266
+ * Pin          Pin           Pin
+ * -----------------------------------------
+ * SDA(SS)      4*            D4*
+ * SCK          13            D5
+ * MOSI         11            D7
+ * MISO         12            D6
+ * RST          3*            D3*
+ * NC(IRQ)      not used      not used
+ * 3.3V         3.3V          3V
+ * GND          GND           GND
+ * --------------------------------------------------------------------------
+ */
+
+EasyMFRC522 rfidReader(D4, D3); //the MFRC522 reader, with the SDA and RST pins given
+
+#define TAPS          50    // taps of each workload
+
+#define RAW_BLOCK     1     // 48 bytes: blocks 1, 2 and 4
+#define RAW_SIZE      48
+#define HISTORY_BLOCK 8     // the history file: up to 11 blocks
+#define DICT_BLOCK    28    // the dictionary, up to the end of the tag
+
+#define DICT_KEYS     8     // keys used by the dictionary workloads
+
+#ifndef FREE_HEAP    // (defined before, in the host build of tools/host/tap_bench.cpp)
+#if defined(ESP8266) || defined(ESP32)
+  #define FREE_HEAP()  ((long)ESP.getFreeHeap())
+#else
+  #define FREE_HEAP()  (-1L)
+#endif
+#endif
+
+struct AccessRecord {
+  uint32_t time;   // (the unsigned long of the boards, of the same size in the host build)
+  char gate;
+};
+
+#define HISTORY_MAX_SIZE 20
+
+AccessRecord history[HISTORY_MAX_SIZE];
+byte rawData[RAW_SIZE];
+
+RfidTraceRecord trace[128];   // enough for the commands of the longest tap
+
+unsigned long tapMicros[TAPS];
+unsigned long rfMicros[TAPS];
+
+long minFreeHeap;   // the lowest free heap seen in the current tap
+
+typedef int (*Workload)(int tap);
+
+int rawRead(int tap);
+int historyAppend(int tap);
+int dictGet(int tap);
+int dictSet(int tap);
+int dictMix(int tap);
+
+void runWorkload(const char* name, Workload workload);
+bool prepareTag();
+void sampleHeap();
+void sortMicros(unsigned long* values, int size);
+
+
+void setup() {
+  Serial.begin(9600);
+
+  while (!Serial)
+    ;
+
+  rfidReader.init();
+  rfidReader.setTraceBuffer(trace, sizeof(trace) / sizeof(trace[0]));
+  delay(1000);
+}
+
+
+void loop() {
+  Serial.println();
+  Serial.println("APPROACH a Mifare tag and KEEP IT STILL. Waiting...");
+
+  bool success;
+  do {
+    success = rfidReader.detectTag();
+    delay(50);
+  } while (!success);
+
+  Serial.println("--> TAG DETECTED!\n");
+
+  success = prepareTag();
+  rfidReader.unselectMifareTag(true);
+  if (!success) {
+    Serial.println("--> Error: could not write the initial data to the tag");
+    delay(3000);
+    return;
+  }
+
+  Serial.println("csv,workload,taps,errors,p50_micros,p99_micros,rf_p50_micros,transactions_avg,transactions_max,peak_heap");
+  runWorkload("raw_read", rawRead);
+  runWorkload("history_append", historyAppend);
+  runWorkload("dict_get", dictGet);
+  runWorkload("dict_set", dictSet);
+  runWorkload("dict_mix", dictMix);
+
+  Serial.println();
+  Serial.println("Finished benchmark!");
+  delay(3000);
+}
+
+// Writes the data read by the workloads: the raw data, an empty history and a
+// dictionary with all the keys.
+bool prepareTag() {
+  for (int i = 0; i < RAW_SIZE; i ++) {
+    rawData[i] = (byte)i;
+  }
+  if (rfidReader.writeRaw(RAW_BLOCK, rawData, RAW_SIZE) < 0) {
+    return false;
+  }
+  if (rfidReader.writeFile(HISTORY_BLOCK, "history", (byte*)history, 0) < 0) {
+    return false;
+  }
+
+  RfidDictionaryView dict(&rfidReader, DICT_BLOCK);
+  for (int k = 0; k < DICT_KEYS; k ++) {
+    dict.set(String("key") + k, String("initial value"));
+  }
+  return dict.getNumEntries() == DICT_KEYS;
+}
+
+// Runs the taps of the workload and prints its CSV line.
+void runWorkload(const char* name, Workload workload) {
+  int errors = 0;
+  int taps = 0;
+  unsigned long transactionsSum = 0;
+  int transactionsMax = 0;
+  long peakHeap = -1;
+
+  for (int i = 0; i < TAPS; i ++) {
+    long heapBefore = FREE_HEAP();
+    minFreeHeap = heapBefore;
+    rfidReader.clearTrace();
+
+    unsigned long start = micros();
+    if (!rfidReader.detectTag()) {
+      errors ++;  // the tag was moved away (this tap is not counted)
+      delay(50);
+      continue;
+    }
+    int result = workload(i);
+    rfidReader.unselectMifareTag(true);
+    unsigned long elapsed = micros() - start;
+
+    if (result < 0) {
+      errors ++;
+    }
+
+    unsigned long rf = 0;
+    RfidTraceRecord record;
+    for (int r = 0; r < rfidReader.getTraceSize(); r ++) {
+      rfidReader.getTraceRecord(r, &record);
+      rf += record.duration;
+    }
+
+    tapMicros[taps] = elapsed;
+    rfMicros[taps] = rf;
+    taps ++;
+
+    transactionsSum += rfidReader.getTraceSize();
+    if (rfidReader.getTraceSize() > transactionsMax) {
+      transactionsMax = rfidReader.getTraceSize();
+    }
+    if (heapBefore >= 0 && heapBefore - minFreeHeap > peakHeap) {
+      peakHeap = heapBefore - minFreeHeap;
+    }
+  }
+
+  sortMicros(tapMicros, taps);
+  sortMicros(rfMicros, taps);
+
+  Serial.print("csv,");
+  Serial.print(name);                        Serial.print(",");
+  Serial.print(taps);                        Serial.print(",");
+  Serial.print(errors);                      Serial.print(",");
+  Serial.print(taps > 0? tapMicros[(taps - 1) * 50 / 100] : 0); Serial.print(",");
+  Serial.print(taps > 0? tapMicros[(taps - 1) * 99 / 100] : 0); Serial.print(",");
+  Serial.print(taps > 0? rfMicros[(taps - 1) * 50 / 100] : 0);  Serial.print(",");
+  Serial.print(taps > 0? (float)transactionsSum / taps : 0.0);   Serial.print(",");
+  Serial.print(transactionsMax);             Serial.print(",");
+  Serial.println(peakHeap);
+}
+
+
+//---- WORKLOADS (each one runs the operations of a tap; the tag is already detected) ----//
+
+int rawRead(int tap) {
+  return rfidReader.readRaw(RAW_BLOCK, rawData, RAW_SIZE);
+}
+
+int historyAppend(int tap) {
+  int result = rfidReader.readFile(HISTORY_BLOCK, "history", (byte*)history, sizeof(history));
+  if (result < 0) {
+    return result;
+  }
+  int historySize = result / sizeof(AccessRecord);
+
+  if (historySize >= HISTORY_MAX_SIZE) {
+    // discards the first record, as in "Labeled Data - Ex2"
+    for (int i = 0; i < historySize-1; i++) {
+      history[i] = history[i+1];
+    }
+    historySize -= 1;
+  }
+  history[historySize].time = millis();
+  history[historySize].gate = 'A' + (tap % 26);
+  historySize ++;
+
+  sampleHeap();
+  return rfidReader.writeFile(HISTORY_BLOCK, "history", (byte*)history, sizeof(AccessRecord)*historySize);
+}
+
+int dictGet(int tap) {
+  RfidDictionaryView dict(&rfidReader, DICT_BLOCK);
+  String value = dict.get(String("key") + (tap % DICT_KEYS));
+  sampleHeap();
+  return (value.length() > 0)? 0 : -1;
+}
+
+int dictSet(int tap) {
+  RfidDictionaryView dict(&rfidReader, DICT_BLOCK);
+  dict.set(String("key") + (tap % DICT_KEYS), String("value ") + tap);
+  sampleHeap();
+  return (dict.getNumEntries() == DICT_KEYS)? 0 : -1;
+}
+
+int dictMix(int tap) {
+  RfidDictionaryView dict(&rfidReader, DICT_BLOCK);
+  String key = String("key") + ((tap / 2) % DICT_KEYS);
+  if (tap % 2 == 0) {
+    dict.remove(key);
+  } else {
+    dict.set(key, String("value ") + tap);  // the key removed in the last tap is set again
+  }
+  dict.get(String("key") + (tap % DICT_KEYS));
+  sampleHeap();
+  return (dict.getNumEntries() > 0)? 0 : -1;
+}
+
+
+void sampleHeap() {
+  long freeHeap = FREE_HEAP();
+  if (freeHeap < minFreeHeap) {
+    minFreeHeap = freeHeap;
+  }
+}
+
+// insertion sort (the arrays are small)
+void sortMicros(unsigned long* values, int size) {
+  for (int i = 1; i < size; i ++) {
+    unsigned long value = values[i];
+    int j = i - 1;
+    while (j >= 0 && values[j] > value) {
+      values[j + 1] = values[j];
+      j --;
+    }
+    values[j + 1] = value;
+  }
+}
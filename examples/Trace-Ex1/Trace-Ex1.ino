@@ -0,0 +1,148 @@
+#include "EasyMFRC522.h"
+
+/**
+ * ----------------------------------------------------------------------------
+ * Easy MFRC522 library - Trace - Example #1
+ * (Further information: https://github.com/pablo-sampaio/easy_mfrc522)
+ *
+ * -----------------------------------------
+ * Shows how to record the commands issued to the tag (authentications, reads,
+ * writes...) in a trace, with their results and durations, and how to replay 
+ * the trace later, without the tag, to re-run the same operation with the same
+ * retries and timing.
+ *
+ * Choose 'w' to write/read some data in a tag, recording the trace. The trace is
+ * printed as CSV lines (starting with "csv,"). Then, choose 'p' to replay it (no 
+ * tag is needed).
+ *
+ * A trace saved with dumpTrace() may also be replayed on Linux, without the board,
+ * with tools/host/trace_replay.cpp (see "make -C tools/host").
+ *
+ * Attention: it overwrites the blocks starting at BLOCK in the tag!
+ *
+ * -----------------------------------------
+ * Pin layout used (where * indicates configurable pin):
+ * -----------------------------------------
+ * MFRC522      Arduino       NodeMCU
+ * Reader       Uno           Esp8266
+ * Pin          Pin           Pin
+ * -----------------------------------------
+ * SDA(SS)      4*            D4*
+ * SCK          13            D5
+ * MOSI         11            D7
+ * MISO         12            D6
+ * RST          3*            D3*
+ * NC(IRQ)      not used      not used
+ * 3.3V         3.3V          3V
+ * GND          GND           GND
+ * --------------------------------------------------------------------------
+ */
+
+EasyMFRC522 rfidReader(D4, D3); //the MFRC522 reader, with the SDA and RST pins given
+
+#define BLOCK       1     // the initial block of the data
+#define DATA_SIZE   64    // 4 blocks, in 2 sectors
+#define TRACE_SIZE  32    // maximum number of commands recorded (the last ones are kept)
+
+RfidTraceRecord trace[TRACE_SIZE];
+RfidTraceRecord replayed[TRACE_SIZE];   // copy of the trace, to be replayed
+int replayedSize = 0;
+
+byte data[DATA_SIZE];
+
+int runOperation();
+void printTrace();
+
+
+void setup() {
+  Serial.begin(9600);
+
+  while (!Serial)
+    ;
+
+  rfidReader.init();
+  rfidReader.setTraceBuffer(trace, TRACE_SIZE);
+  delay(1000);
+}
+
+
+void loop() {
+  Serial.println("=========================");
+  Serial.println("CHOOSE an operation: ");
+  Serial.println("  'w' to write/read data in a tag, recording the trace");
+  Serial.println("  'p' to replay the last trace recorded (without a tag)");
+
+  while (Serial.available() == 0) // waits for incoming data
+    ;
+
+  char option = Serial.read();
+  int result;
+
+  if (option == 'w') {
+    Serial.println("APPROACH a Mifare tag. Waiting...");
+    bool success;
+    do {
+      success = rfidReader.detectTag();
+      delay(50);
+    } while (!success);
+
+    rfidReader.clearTrace();
+    unsigned long start = micros();
+    result = runOperation();
+    unsigned long elapsed = micros() - start;
+    rfidReader.unselectMifareTag();
+
+    Serial.print("--> Result: "); Serial.print(result);
+    Serial.print(", time (us): "); Serial.println(elapsed);
+    printTrace();
+
+    // keeps a copy of the trace, to be replayed
+    replayedSize = rfidReader.getTraceSize();
+    for (int i = 0; i < replayedSize; i ++) {
+      rfidReader.getTraceRecord(i, &replayed[i]);
+    }
+
+  } else if (option == 'p') {
+    rfidReader.clearTrace();
+    rfidReader.startReplay(replayed, replayedSize);
+    unsigned long start = micros();
+    result = runOperation();
+    unsigned long elapsed = micros() - start;
+    rfidReader.stopReplay();
+
+    Serial.print("--> Result: "); Serial.print(result);
+    Serial.print(", time (us): "); Serial.print(elapsed);
+    Serial.print(", mismatches: "); Serial.println(rfidReader.getReplayMismatches());
+    printTrace();
+  }
+
+  while (Serial.available() > 0) {  // clear "garbage" input from serial
+    Serial.read();
+  }
+  Serial.println();
+}
+
+int runOperation() {
+  for (int i = 0; i < DATA_SIZE; i ++) {
+    data[i] = (byte)i;
+  }
+  int result = rfidReader.writeRaw(BLOCK, data, DATA_SIZE);
+  if (result >= 0) {
+    result = rfidReader.readRaw(BLOCK, data, DATA_SIZE);
+  }
+  return result;
+}
+
+void printTrace() {
+  RfidTraceRecord record;
+  Serial.println("csv,time,duration,command,block,status");
+  for (int i = 0; i < rfidReader.getTraceSize(); i ++) {
+    rfidReader.getTraceRecord(i, &record);
+    Serial.print("csv,");
+    Serial.print(record.time);     Serial.print(",");
+    Serial.print(record.duration); Serial.print(",");
+    Serial.print(record.command);  Serial.print(",");
+    Serial.print(record.block);    Serial.print(",");
+    Serial.println(record.status);
+  }
+}
@@ -3,6 +3,7 @@
 #include <MFRC522.h>
 
 #include "EasyMFRC522.h"
+#include "RfidCipher.h"
 
 /*** 
  * To understand this code, it is necessary to understand the internal architecture of 
@@ -45,36 +46,58 @@
 ////////////////////////////////////////////////////////
 //////// INITIALIZATION/CONFIGURATION FUNCTIONS ////////
 
-EasyMFRC522::EasyMFRC522(byte sda_pin, byte reset_pin) 
+EasyMFRC522::EasyMFRC522(byte sda_pin, byte reset_pin, uint32_t spi_clock) 
   : device(sda_pin, reset_pin) // calls constructor of class MFRC522
 {
   // for keys A and B, we use the default from the factory: FFFFFFFFFFFF (hex) 
   for (int i = 0; i < 6; i ++) {
     this->key.keyByte[i] = 0xFF;
   }
+  this->chipSelectPin = sda_pin;
+  this->setSpiClock(spi_clock);
+  this->resetTransferStats();
+  this->authenticatedSector = -1;
+  this->fileCipher = NULL;
+  this->setNonceSource(NULL);
+  this->fileParityGroup = 0;
+  this->filePacking = false;
+  this->irqPin = EASY_MFRC522_NO_IRQ;
+  this->irqFlag = false;
+  this->requestPending = false;
+#if EASY_MFRC522_ENABLE_PREFETCH
+  this->setPrefetchList(NULL, 0, NULL, 0);
+#endif
+#if EASY_MFRC522_ENABLE_TRACE
+  this->setTraceBuffer(NULL, 0);
+  this->replayTrace = NULL;
+  this->replaySize = 0;
+  this->replayMismatches = 0;
+#endif
+#if EASY_MFRC522_ENABLE_RESUME
+  this->resumeEnabled = true;
+  this->resume.operation = RFID_RESUME_NONE;
+#endif
+#if EASY_MFRC522_ENABLE_DIAGNOSTICS
+  this->setDiagnosticSink(NULL);
+  this->clearDiagnostics();
+#endif
 }
 
 EasyMFRC522::~EasyMFRC522() {
   // there is nothing to free/deallocate
+  if (irqInstance == this) {
+    disableIrq();
+  }
 }
 
 void EasyMFRC522::init() {
   SPI.begin();
   this->device.PCD_Init();
 
-  byte v = this->device.PCD_ReadRegister(this->device.VersionReg); //get the MFRC522 software version
-  Serial.print(F("MFRC522 sw version: "));
-  if (v == 0x91) {
-    Serial.print(F("v1.0"));
-  } else if (v == 0x92) {
-    Serial.print(F("v2.0"));
-  } else if ((v == 0x00) || (v == 0xFF)) {
-    Serial.print(F("communication failure")); //check physical connections and initialization parameters
-  } else {
-    Serial.print(F("unknown "));
-    Serial.print(v, HEX);
-  }
-  Serial.println();
+  // the MFRC522 software version is given in the diagnostics (0x00 or 0xFF indicate a 
+  // communication failure: check physical connections and initialization parameters)
+  byte v = this->device.PCD_ReadRegister(this->device.VersionReg);
+  reportDiagnostic((v == 0x00 || v == 0xFF)? -13 : RFID_DIAG_CHIP_VERSION, -1, v);
 }
 
 void EasyMFRC522::setKeyA(byte keyA[6]) {
@@ -83,19 +106,98 @@ void EasyMFRC522::setKeyA(byte keyA[6]) {
   }
 }
 
+/**
+ * Sets the SPI clock used in the block transfers done by this class (reads and writes of
+ * data blocks). Values above 10 MHz (the maximum supported by the MFRC522) are reduced to
+ * 10 MHz, and zero selects the default clock (4 MHz).
+ * 
+ * Attention: the operations delegated to Balboa's class (e.g. authentication, detection)
+ * use the clock given by the macro MFRC522_SPICLOCK of that library.
+ */
+void EasyMFRC522::setSpiClock(uint32_t clockHz) {
+  if (clockHz == 0) {
+    clockHz = EASY_MFRC522_DEFAULT_SPI_CLOCK;
+  } else if (clockHz > EASY_MFRC522_MAX_SPI_CLOCK) {
+    clockHz = EASY_MFRC522_MAX_SPI_CLOCK;
+  }
+  this->spiClock = clockHz;
+  this->spiSettings = SPISettings(clockHz, MSBFIRST, SPI_MODE0);
+}
+
+void EasyMFRC522::resetTransferStats() {
+  this->stats.spiTransactions = 0;
+  this->stats.spiBytes = 0;
+  this->stats.spiPolls = 0;
+  this->stats.blockOperations = 0;
+  this->stats.blocksRecovered = 0;
+}
+
+// Tells if the tag is a Mifare Classic of a type supported (see EasyMFRC522Config.h).
+static bool isMifareClassic(byte sak) {
+  MFRC522::PICC_Type piccType = MFRC522::PICC_GetType(sak);
+  return (EASY_MFRC522_SUPPORT_MINI && piccType == MFRC522::PICC_TYPE_MIFARE_MINI)
+      || (EASY_MFRC522_SUPPORT_1K && piccType == MFRC522::PICC_TYPE_MIFARE_1K)
+      || (EASY_MFRC522_SUPPORT_4K && piccType == MFRC522::PICC_TYPE_MIFARE_4K);
+}
+
+// Gives the last block of the tag selected. With a single type of tag supported, it is 
+// a constant (and the other branches are not compiled).
+int EasyMFRC522::_lastBlock() {
+#if (EASY_MFRC522_SUPPORT_MINI + EASY_MFRC522_SUPPORT_1K + EASY_MFRC522_SUPPORT_4K) == 1
+  return EASY_MFRC522_MAX_BLOCK;
+#else
+  MFRC522::PICC_Type piccType = MFRC522::PICC_GetType(this->device.uid.sak);
+  if (piccType == MFRC522::PICC_TYPE_MIFARE_MINI) {
+    return 19;
+  } else if (piccType == MFRC522::PICC_TYPE_MIFARE_1K) {
+    return 63;
+  }
+  return EASY_MFRC522_MAX_BLOCK;
+#endif
+}
+
+/**
+ * Detects a tag in the field and selects it. In the IRQ mode (see enableIrq()), this function
+ * doesn't wait for the answer of the tags: it sends a request and returns false, and the 
+ * request is checked only when signaled by the IRQ pin, in a later call.
+ */
 bool EasyMFRC522::detectTag(byte outputTagId[4]) {
-  if (! device.PICC_IsNewCardPresent())
+  if (isIrqEnabled()) {
+    if (! this->requestPending || millis() - this->requestStart > 100) {  // the request may have been cancelled by another command
+      _startRequestA();
+      return false;
+    }
+    if (! this->irqFlag) {
+      return false;  // no answer yet (and no access to the MFRC522)
+    }
+    this->requestPending = false;
+    byte irq = _pcdReadRegister(MFRC522::ComIrqReg);
+    if ((irq & 0x20) == 0) {  // no RxIRq: the timer expired, without answer
+      _startRequestA();       // the next request is already sent
+      return false;
+    }
+    // some tag answered (possibly many, with collisions, that are resolved in the selection)
+
+  } else if (! device.PICC_IsNewCardPresent()) {
     return false;
+  }
+
+  return _selectTag(outputTagId);
+}
 
-  if (! device.PICC_ReadCardSerial())  //selects one of the cards/tags
+// Selects the tag that answered the last request (REQA).
+bool EasyMFRC522::_selectTag(byte outputTagId[4]) {
+  unsigned long start = micros();
+  bool selected = device.PICC_ReadCardSerial();  //selects one of the cards/tags
+  _trace(RFID_TRACE_SELECT, 0, selected? MFRC522::STATUS_OK : MFRC522::STATUS_ERROR, start);
+  if (! selected)
       return false;
 
-  MFRC522::PICC_Type piccType = device.PICC_GetType(device.uid.sak);
-  
+  resetAuthentication();
+  _invalidatePrefetch(0, 0x7FFF);
+
   // accepts only Mifare Classic protocol
-  if (piccType == MFRC522::PICC_TYPE_MIFARE_MINI
-		    || piccType == MFRC522::PICC_TYPE_MIFARE_1K
-		    || piccType == MFRC522::PICC_TYPE_MIFARE_4K) {
+  if (isMifareClassic(device.uid.sak)) {
 
     // copies the tag's ID to the variable provided
     if (outputTagId != NULL) {
@@ -104,6 +206,7 @@ bool EasyMFRC522::detectTag(byte outputTagId[4]) {
       }
     }
 
+    _prefetch();
     return true;
   }
 
@@ -111,7 +214,11 @@ bool EasyMFRC522::detectTag(byte outputTagId[4]) {
 }
 
 void EasyMFRC522::unselectMifareTag(bool allowRedetection) {
+  resetAuthentication();
+  _invalidatePrefetch(0, 0x7FFF);
+  unsigned long start = micros();
   device.PICC_HaltA();
+  _trace(RFID_TRACE_HALT, 0, MFRC522::STATUS_OK, start);
   device.PCD_StopCrypto1();
   if (allowRedetection) {
     device.PCD_AntennaOff();
@@ -119,6 +226,134 @@ void EasyMFRC522::unselectMifareTag(bool allowRedetection) {
   }
 }
 
+bool EasyMFRC522::isSameUid(const MFRC522::Uid& uid1, const MFRC522::Uid& uid2) {
+  if (uid1.size != uid2.size) {
+    return false;
+  }
+  for (byte i = 0; i < uid1.size; i ++) {
+    if (uid1.uidByte[i] != uid2.uidByte[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Finds all the tags in the field, copying their UIDs (of 4, 7 or 10 bytes) to "uidsOut", 
+ * which must have room for "maxTags" UIDs. 
+ * 
+ * The antenna is turned off and on (so that all tags restart), then each tag is found with 
+ * the anticollision loop of ISO 14443-3 (done by MFRC522::PICC_Select()) and halted, so
+ * that the next request is answered only by the remaining tags.
+ * 
+ * After this function, all the tags found are halted: use processTags() to access them.
+ * 
+ * Returns: the number of tags found
+ */
+int EasyMFRC522::inventory(MFRC522::Uid* uidsOut, int maxTags) {
+  resetAuthentication();
+  _invalidatePrefetch(0, 0x7FFF);
+  device.PCD_StopCrypto1();
+  device.PCD_AntennaOff();
+  device.PCD_AntennaOn();
+  delay(5);  // time for the tags to power up
+
+  int numTags = 0;
+  int failures = 0;
+
+  while (numTags < maxTags && failures < READ_WRITE_TRIALS) {
+    byte atqa[2];
+    byte atqaSize = sizeof(atqa);
+    MFRC522::StatusCode status = device.PICC_RequestA(atqa, &atqaSize);
+    if (status == MFRC522::STATUS_TIMEOUT) {
+      break;  // no more tags in the IDLE state
+    }
+    if (status != MFRC522::STATUS_OK && status != MFRC522::STATUS_COLLISION) {
+      failures ++;
+      continue;
+    }
+
+    MFRC522::Uid uid;
+    unsigned long start = micros();
+    status = device.PICC_Select(&uid, 0);  // resolves collisions, selecting a single tag
+    _trace(RFID_TRACE_SELECT, 0, status, start);
+    if (status != MFRC522::STATUS_OK) {
+      failures ++;
+      continue;
+    }
+    device.PICC_HaltA();
+
+    bool alreadyFound = false;
+    for (int i = 0; i < numTags; i ++) {
+      if (isSameUid(uidsOut[i], uid)) {
+        alreadyFound = true;
+        break;
+      }
+    }
+    if (! alreadyFound) {
+      uidsOut[numTags] = uid;
+      numTags ++;
+    }
+  }
+
+  return numTags;
+}
+
+/**
+ * For each UID given (e.g. found with inventory()), selects the tag, calls the operation
+ * and halts the tag. The tags must be in the field, but don't need to be separated.
+ * 
+ * The operation may do any read/write of this class in the tag. Its return value is copied
+ * to "resultsOut" (if not NULL), except if the tag could not be selected (-401) or is not
+ * a Mifare Classic tag (-402).
+ * 
+ * Returns: the number of tags processed (i.e. for which the operation was called)
+ */
+int EasyMFRC522::processTags(const MFRC522::Uid* uids, int numTags, RfidTagOperation operation, void* context, int* resultsOut) {
+  int processed = 0;
+
+  for (int i = 0; i < numTags; i ++) {
+    int result;
+    bool selected = false;
+
+    resetAuthentication();
+    _invalidatePrefetch(0, 0x7FFF);
+
+    for (int trial = 0; trial < READ_WRITE_TRIALS && !selected; trial ++) {
+      byte atqa[2];
+      byte atqaSize = sizeof(atqa);
+      device.PCD_StopCrypto1();
+      device.PICC_WakeupA(atqa, &atqaSize);  // wakes up the halted tags; collisions are expected
+
+      // selects only the tag with the given UID (the other ones go back to idle/halt)
+      this->device.uid = uids[i];
+      unsigned long start = micros();
+      MFRC522::StatusCode status = device.PICC_Select(&this->device.uid, uids[i].size * 8);
+      _trace(RFID_TRACE_SELECT, 0, status, start);
+      selected = (status == MFRC522::STATUS_OK);
+    }
+
+    if (! selected) {
+      result = -401;
+    } else if (! isMifareClassic(this->device.uid.sak)) {
+      result = -402;
+    } else {
+      result = operation(this, &uids[i], context);
+      processed ++;
+    }
+
+    device.PICC_HaltA();
+    device.PCD_StopCrypto1();
+    resetAuthentication();
+
+    if (resultsOut != NULL) {
+      resultsOut[i] = result;
+    }
+  }
+
+  return processed;
+}
+
 /**
  * Gives the net storage capacity of the currently selected tag, from the given start 
  * block on (i.e. the start block is pottentially considered as user space if it does
@@ -173,9 +408,102 @@ int EasyMFRC522::getUserDataSpace(int startBlock) {
   return (availableSpace < 0)? 0 : availableSpace;
 }
 
+/**
+ * Follows the same sequence of blocks used by writeRaw() (skipping block 0 and the
+ * trailer blocks) to find where the given position (offset) of the data is stored.
+ * 
+ * Returns: negative number -- the position is beyond the tag's memory
+ *          positive number -- the block
+ */
+int EasyMFRC522::getBlockOfOffset(int initialBlock, int offset) {
+  int currBlock = initialBlock;
+  int blocksToSkip = offset / 16;
+
+  while (true) {
+    if (_isTrailerBlock(currBlock) || currBlock == 0) {
+      currBlock ++;
+    }
+    if (currBlock > _lastBlock()) {
+      return -1;
+    }
+    if (blocksToSkip == 0) {
+      return currBlock;
+    }
+    blocksToSkip --;
+    currBlock ++;
+  }
+}
+
+/**
+ * Authenticates (with key A) the sector of the given block, trying up to READ_WRITE_TRIALS times.
+ * 
+ * The authenticated sector is remembered, so that successive operations in the same sector
+ * (e.g. readFileSize() followed by readRaw()) authenticate only once. It is forgotten when a 
+ * command fails (because the tag loses the authentication) or when the tag changes.
+ * 
+ * Attention: if you authenticate directly with the MFRC522 class (see getMFRC522()), call 
+ * resetAuthentication() before using this class again.
+ */
+MFRC522::StatusCode EasyMFRC522::_authenticate(int blockAddr) {
+  int sector = _sectorOf(blockAddr);
+  if (sector == this->authenticatedSector) {
+    return MFRC522::STATUS_OK;
+  }
+
+  dbgPrint("   - Authenticating sector: "); dbgPrintln(sector); 
+  MFRC522::StatusCode status = MFRC522::STATUS_ERROR;
+  for (int i = 0; i < READ_WRITE_TRIALS; i ++) {
+    unsigned long start = micros();
+    if (! _replay(RFID_TRACE_AUTH, blockAddr, &status)) {
+      status = device.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, blockAddr, &key, &(device.uid));
+    }
+    _trace(RFID_TRACE_AUTH, blockAddr, status, start);
+    if (status == MFRC522::STATUS_OK) {
+      break;
+    }
+    dbgPrintln(F("    na"));
+  }
+  if (status != MFRC522::STATUS_OK) {
+    reportDiagnostic(-12, blockAddr, status);
+  }
+
+  this->authenticatedSector = (status == MFRC522::STATUS_OK)? sector : -1;
+  return status;
+}
+
 ///////////////////////////////////////////////////
 ////////// READ/WRITE RAW (multisector) ///////////
 
+/*
+ * writeRaw() and readRaw() are implemented over "streams" of data: the data of each block is 
+ * asked to a source function just before the block is written, and each block read is given 
+ * to a sink function. So, the data may be transformed (e.g. encrypted, see writeFile()) one 
+ * block at a time, as it goes to (or comes from) the tag, without copies of the whole data.
+ * 
+ * The streaming functions (writeRawStream(), readRawStream(), writeFileStream() and 
+ * readFileStream()) are public, so that data of any size may be read/written with no 
+ * buffer for the whole data (e.g. directly from/to the serial port, with the overloads 
+ * that receive a Stream or a Print).
+ */
+
+static int copyFromArray(byte* chunk, int position, int length, void* array) {
+  memcpy(chunk, (byte*)array + position, length);
+  return 0;
+}
+
+static int copyToArray(const byte* chunk, int position, int length, void* array) {
+  memcpy((byte*)array + position, chunk, length);
+  return 0;
+}
+
+static int copyFromStream(byte* chunk, int position, int length, void* input) {
+  return (((Stream*)input)->readBytes(chunk, length) == (size_t)length)? 0 : -1;
+}
+
+static int copyToPrint(const byte* chunk, int position, int length, void* output) {
+  return (((Print*)output)->write(chunk, length) == (size_t)length)? 0 : -1;
+}
+
 /**
  * Writes the given "data" array (with "dataSize" bytes) in the Mifare 1K tag, starting in "initialBlock" (or in the next one, if it is a 
  * trailer block or the block #0) and successively writing to the next non-trailer block, until all data is written. 
@@ -188,71 +516,164 @@ int EasyMFRC522::getUserDataSpace(int startBlock) {
  *          positive number -- last block written
  */
 int EasyMFRC522::writeRaw(int initialBlock, byte* data, int dataSize) {
+  return _writeRawResumable(RFID_RESUME_WRITE_RAW, initialBlock, data, dataSize);
+}
+
+// Same as writeRaw(), but the data is read from the input (e.g. Serial), at most 16 bytes 
+// at a time. If the input times out before "dataSize" bytes, the error -223 is returned.
+int EasyMFRC522::writeRaw(int initialBlock, Stream& input, int dataSize) {
+  return writeRawStream(initialBlock, dataSize, copyFromStream, &input);
+}
+
+/**
+ * Same as writeRaw(), but the data of each block (16 bytes, or less in the last block) is
+ * given by the source, which is called once per block, in order, before writing the block.
+ * A local buffer of 16 bytes is used for each block (the block is read back to blockBuffer, 
+ * to be verified), so the memory used doesn't depend on the size of the data.
+ */
+int EasyMFRC522::writeRawStream(int initialBlock, int dataSize, RfidDataSource source, void* context) {
+  return _writeRawStream(initialBlock, dataSize, source, context, 0, NULL);
+}
+
+// Same as writeRawStream(), but starting from the given position of the data (a multiple of
+// 16), whose block is found as in writeRaw(). Gives the number of bytes written and verified.
+int EasyMFRC522::_writeRawStream(int initialBlock, int dataSize, RfidDataSource source, void* context, int startOffset, int* bytesVerifiedOut) {
   MFRC522::StatusCode status = MFRC522::STATUS_ERROR;
   int statusCode;
+  byte chunk[16];
+  int dummy;
 
-  int bytesWritten = 0;  
-  int currBlock = initialBlock;
-  int currSector = currBlock / 4;
-  bool sectorAuthenticated = false;
+  if (bytesVerifiedOut == NULL) {
+    bytesVerifiedOut = &dummy;
+  }
+  int& bytesWritten = *bytesVerifiedOut;
+  bytesWritten = startOffset;
+  int currBlock = (startOffset > 0)? getBlockOfOffset(initialBlock, startOffset) : initialBlock;
   
   while (bytesWritten < dataSize) {
-    //TODO: this code is for Mifare 1k; adapt to other types
-    if (currBlock % 4 == 3 || currBlock == 0) {
+    if (_isTrailerBlock(currBlock) || currBlock == 0) {
       dbgPrint("   - Ignored block: "); dbgPrintln(currBlock);
       currBlock ++;
-      currSector ++;
-      sectorAuthenticated = false; //because the sector changed
     }
 
-    //TODO: adapt to other types of tag
-    if (currBlock > 63) {
+    if (currBlock > _lastBlock()) {
       dbgPrint("Error writeRaw(): not enough space");
       return -220;
     }
 
-    if (! sectorAuthenticated) {
-      dbgPrint("   - Authenticating sector: "); dbgPrintln(currSector); 
-      for (int i = 0; i < READ_WRITE_TRIALS; i ++) {
-        status = device.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, currBlock, &key, &(device.uid));
-        if (status == MFRC522::STATUS_OK) {
-          break;
-        }
-        dbgPrintln(F("    na"));
-      }
-      if (status != MFRC522::STATUS_OK) {
-        dbgPrint("Error writeRaw(): could not authenticate, block "); dbgPrintln(currBlock);
-        return -221;
-      }
-      sectorAuthenticated = true;
+    if (isValueBlock(currBlock)) {
+      dbgPrint("Error writeRaw(): cannot overwrite value block "); dbgPrintln(currBlock);
+      return -222;
+    }
+
+    status = _authenticate(currBlock);  // only when the sector changes (see _authenticate())
+    if (status != MFRC522::STATUS_OK) {
+      dbgPrint("Error writeRaw(): could not authenticate, block "); dbgPrintln(currBlock);
+      return -221;
     }
 
     int bytes = dataSize - bytesWritten;
     bytes = (bytes < 16)? bytes : 16;
+    if (source(chunk, bytesWritten, bytes, context) < 0) {  // called only once per block (not in the trials)
+      dbgPrintln("Error writeRaw(): data source failed");
+      _invalidatePrefetch(initialBlock, 0x7FFF);
+      return -223;
+    }
+
     for (int i = 0; i < READ_WRITE_TRIALS; i ++) {
-      statusCode = _writeBlockAndVerify(currBlock, data, bytesWritten, bytes);
+      if (i > 0) {
+        _authenticate(currBlock);  // a failure may have reset the authentication
+      }
+      statusCode = _writeBlockAndVerify(currBlock, chunk, 0, bytes);
       if (statusCode >= 0) {
         bytesWritten += bytes;
         break;
       }
     }
     if (statusCode < 0) {
+      _invalidatePrefetch(initialBlock, 0x7FFF);
       return -200 + statusCode;
     }
 
     currBlock ++;
   }
 
+  _invalidatePrefetch(initialBlock, currBlock - 1);
   return currBlock - 1;
 }
 
+/*
+ * RESUMABLE WRITES
+ * 
+ * If the tag leaves the field in the middle of a long write, the blocks already written 
+ * (and verified) don't need to be written again. So, when writeRaw() (or writeFile()) of
+ * an array fails, a resume record keeps the UID of the tag, the operation, the position
+ * and size of the data, its CRC-16 and how much of it was verified. When the same write
+ * (same tag, operation, blocks and data) is called again, it continues from the first 
+ * block not verified, after reading the last verified block to check that the tag was 
+ * not changed meanwhile. Any other write is done from the start, as usual.
+ * 
+ * Only one record is kept (for the last failed write), in RAM. Writes from streams cannot
+ * be resumed, because their sources cannot skip the data already written.
+ */
+
+int EasyMFRC522::_writeRawResumable(byte operation, int initialBlock, byte* data, int dataSize) {
+#if EASY_MFRC522_ENABLE_RESUME
+  if (! this->resumeEnabled) {
+    return _writeRawStream(initialBlock, dataSize, copyFromArray, data, 0, NULL);
+  }
+
+  uint16_t checksum = crc16(0xFFFF, data, dataSize);
+  int startOffset = 0;
+
+  if (this->resume.operation == operation && this->resume.initialBlock == initialBlock 
+      && this->resume.dataSize == dataSize && this->resume.checksum == checksum 
+      && isSameUid(this->resume.uid, this->device.uid)) {
+    int block = this->resume.lastBlockVerified;
+    if (_authenticate(block) == MFRC522::STATUS_OK 
+        && _verifyBlock(block, data + this->resume.bytesVerified - 16, 0, 16) == 0) {
+      dbgPrint("   - Resuming write from byte: "); dbgPrintln(this->resume.bytesVerified);
+      startOffset = this->resume.bytesVerified;
+    }
+  }
+  clearResumeRecord();
+
+  int bytesVerified = 0;
+  int result = _writeRawStream(initialBlock, dataSize, copyFromArray, data, startOffset, &bytesVerified);
+
+  if (result < 0 && bytesVerified >= 16) {
+    this->resume.uid = this->device.uid;
+    this->resume.operation = operation;
+    this->resume.initialBlock = initialBlock;
+    this->resume.dataSize = dataSize;
+    this->resume.checksum = checksum;
+    this->resume.bytesVerified = bytesVerified;
+    this->resume.lastBlockVerified = getBlockOfOffset(initialBlock, bytesVerified - 16);
+  }
+  return result;
+#else
+  (void)operation;
+  return _writeRawStream(initialBlock, dataSize, copyFromArray, data, 0, NULL);
+#endif
+}
+
+uint16_t EasyMFRC522::crc16(uint16_t crc, const byte* data, int length) {
+  for (int i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000)? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
 int EasyMFRC522::_writeBlockAndVerify(int blockAddr, byte* data, int startIndex, int bytesToWrite) {
   MFRC522::StatusCode status;
   if (bytesToWrite == 16) {
-    status = device.MIFARE_Write(blockAddr, data + startIndex, 16);
+    status = _mifareWrite(blockAddr, data + startIndex);
     if (status != MFRC522::STATUS_OK) {
       dbgPrint  ("Error _writeBlockAndVerify(): could not write block ");
       dbgPrintln(blockAddr);
+      reportDiagnostic(-5, blockAddr, status);
       return -5;
     }
 
@@ -267,10 +688,11 @@ int EasyMFRC522::_writeBlockAndVerify(int blockAddr, byte* data, int startIndex,
       blockBuffer[i] = 0;
     }
     
-    status = device.MIFARE_Write(blockAddr, blockBuffer, 16);
+    status = _mifareWrite(blockAddr, blockBuffer);
     if (status != MFRC522::STATUS_OK) {
       dbgPrint  ("Error _writeBlockAndVerify(): could not write block ");
       dbgPrintln(blockAddr);
+      reportDiagnostic(-6, blockAddr, status);
       return -6;
     }
 
@@ -284,10 +706,10 @@ int EasyMFRC522::_writeBlockAndVerify(int blockAddr, byte* data, int startIndex,
 }
 
 int EasyMFRC522::_verifyBlock(int blockAddr, byte* refData, byte startByte, byte bytesToCheck) {
-  byte bufferSize = 18;
-  MFRC522::StatusCode status = device.MIFARE_Read(blockAddr, blockBuffer, &bufferSize);
+  MFRC522::StatusCode status = _mifareRead(blockAddr, blockBuffer);
   if (status != MFRC522::STATUS_OK) {
       dbgPrintln("Error _verifyBlock(): could not read");
+      reportDiagnostic(-3, blockAddr, status);
       return -3;
   }
 
@@ -295,6 +717,7 @@ int EasyMFRC522::_verifyBlock(int blockAddr, byte* refData, byte startByte, byte
       if (blockBuffer[i] != refData[startByte + i]) {
         dbgPrint("Error _verifyBlock(): verification error in byte: ");
         dbgPrintln(i);
+        reportDiagnostic(-4, blockAddr);
         return -4;
       }
   }
@@ -317,43 +740,41 @@ int EasyMFRC522::_verifyBlock(int blockAddr, byte* refData, byte startByte, byte
  *          positive number -- number of bytes read (from the tag to the output array)
  */
 int EasyMFRC522::readRaw(int initialBlock, byte* dataOutput, int dataSize) {
+  return readRawStream(initialBlock, dataSize, copyToArray, dataOutput);
+}
+
+// Same as readRaw(), but the data is written to the output (e.g. Serial) as it is read.
+int EasyMFRC522::readRaw(int initialBlock, Print& output, int dataSize) {
+  return readRawStream(initialBlock, dataSize, copyToPrint, &output);
+}
+
+/**
+ * Same as readRaw(), but each block read (16 bytes, or less in the last block) is given 
+ * to the sink, which is called once per block, in order. The chunk given to the sink is
+ * the internal block buffer, so it is valid only during the call (and the sink must not
+ * call other functions of this class).
+ */
+int EasyMFRC522::readRawStream(int initialBlock, int dataSize, RfidDataSink sink, void* context) {
   MFRC522::StatusCode status;
   int bytesRead = 0;
  
   int currBlock = initialBlock;
-  int currSector = currBlock / 4;
-  bool sectorAuthenticated = false; 
   
   while (bytesRead < dataSize) {      
-    //TODO: support other Mifare Classic tags
-    if (currBlock % 4 == 3) {  //attention: don't exclude block #0 here; excluded only in write operations
+    if (_isTrailerBlock(currBlock)) {  //attention: don't exclude block #0 here; excluded only in write operations
       dbgPrint("   - Ignored block: "); dbgPrintln(currBlock);
       currBlock ++;
-      currSector ++;
-      sectorAuthenticated = false; //because the sector changed
     }
 
-    // TODO: adapt to other types of tags - this is specific of Mifare 1k !
-    if (currBlock > 63) {
+    if (currBlock > _lastBlock()) {
       dbgPrint("Error readRaw(): end of tag's memory reached");
       return -120;
     }
 
-    if (! sectorAuthenticated) {
-      dbgPrint("   - Authenticating sector: "); dbgPrintln(currSector); 
-
-      for (int i = 0; i < READ_WRITE_TRIALS; i ++) {
-        status = device.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, currBlock, &key, &(device.uid));
-        if (status == MFRC522::STATUS_OK) {
-          break;
-        }
-        dbgPrintln(F("    na"));
-      }
-      if (status != MFRC522::STATUS_OK) {
-        dbgPrint("Error readRaw(): could not authenticate block "); dbgPrintln(currBlock);
-        return -121;
-      }
-      sectorAuthenticated = true;
+    status = _authenticate(currBlock);  // only when the sector changes (see _authenticate())
+    if (status != MFRC522::STATUS_OK) {
+      dbgPrint("Error readRaw(): could not authenticate block "); dbgPrintln(currBlock);
+      return -121;
     }
 
     int code;
@@ -361,9 +782,11 @@ int EasyMFRC522::readRaw(int initialBlock, byte* dataOutput, int dataSize) {
     bytes = (bytes < 16)? bytes : 16;
     
     for (int i = 0; i < READ_WRITE_TRIALS; i ++) {
-      code = _readBlock(currBlock, dataOutput, bytesRead, bytes);
+      if (i > 0) {
+        _authenticate(currBlock);  // a failure may have reset the authentication
+      }
+      code = _readBlock(currBlock, NULL, 0, bytes);  // keeps the data in blockBuffer
       if (code >= 0) { // success
-        bytesRead += bytes;
         break;
       }
     }
@@ -372,6 +795,12 @@ int EasyMFRC522::readRaw(int initialBlock, byte* dataOutput, int dataSize) {
       return -100 + code;
     }
 
+    if (sink(blockBuffer, bytesRead, bytes, context) < 0) {
+      dbgPrintln("Error readRaw(): data sink failed");
+      return -122;
+    }
+    bytesRead += bytes;
+
     currBlock ++;
   }
 
@@ -380,11 +809,11 @@ int EasyMFRC522::readRaw(int initialBlock, byte* dataOutput, int dataSize) {
 
 int EasyMFRC522::_readBlock(int block, byte* destiny, byte firstIndex, byte bytesToRead) {
   MFRC522::StatusCode status;
-  byte bufferSize = 18;
 
-  status = device.MIFARE_Read(block, blockBuffer, &bufferSize);
+  status = _mifareRead(block, blockBuffer);
   if (status != MFRC522::STATUS_OK) {
     dbgPrint("Error readBlock(): could not read block ");  dbgPrintln(block);
+    reportDiagnostic(-1, block, status);
     return -1;
   }
 
@@ -393,123 +822,1871 @@ int EasyMFRC522::_readBlock(int block, byte* destiny, byte firstIndex, byte byte
     return -2;
   }
 
-  for (int i = 0; i < bytesToRead; i ++) {
-    destiny[firstIndex + i] = blockBuffer[i];
+  if (destiny != NULL) {
+    for (int i = 0; i < bytesToRead; i ++) {
+      destiny[firstIndex + i] = blockBuffer[i];
+    }
   }
 
   return 0;
 }
 
 
-//////////////////////////////////////////////////////
-////////// READ/WRITE LABELED DATA (files) ///////////
-
-int EasyMFRC522::writeFile(byte initialBlock, const char dataLabel[12], byte* data, int dataSize) {
-  // prepares the buffer with the content for the initial block  
-  blockBuffer[0] = 0x1C; // ASCII FILE SEPARATOR (=28 decimal)
-  for (int i = 0; i < 12; i ++) {
-    blockBuffer[i+1] = dataLabel[i];
-    if (dataLabel[i] == '\0') {
-      break;
-    }
-  }
-  //blockBuffer[13] = flags; //for future use
-
-  if (dataSize < 0) {
-    dataSize = 0;
-  }
-  blockBuffer[14] = byte(dataSize);
-  blockBuffer[15] = byte(dataSize >> 8);
-
-  int lastBlockUsed = this->writeRaw(initialBlock, blockBuffer, 16); // attention: NEVER write less than 16 bytes using the blockBuffer as source (to prevent name aliasing inside writeRaw())
-  if (lastBlockUsed < 0) {
-    //the message should already have been printed by writeRaw, so just return the error code
-    return -2000 + lastBlockUsed; // error code (see comment in the end of this file)
-  }
+///////////////////////////////////////////////////
+//////////////////// PREFETCH /////////////////////
+
+/*
+ * A prefetch list is a list of labeled data chunks (files) that are read as soon as a tag
+ * is detected by detectTag(), while the tag is freshly selected: first, the header of each
+ * file (i.e. its size) and then, if there is room in the prefetch buffer, its content.
+ * The files are read in the order of their blocks, so that each sector is authenticated
+ * only once (see _authenticate()).
+ * 
+ * Then, readFileSize(), existsFile() and readFile() for those files are answered from 
+ * RAM. The data cached is discarded when the tag is unselected (or another tag is 
+ * detected), and when it is overwritten by this class (e.g. with writeRaw()/writeFile()).
+ */
 
-  int status = this->writeRaw(lastBlockUsed+1, data, dataSize);
-  if (status < 0) {
-    return -2500 + status;        // error code (see comment in the end of this file)
-  }
+#define PREFETCH_NONE     0   // nothing cached
+#define PREFETCH_HEADER   1   // "size" holds the result of readFileSize()
+#define PREFETCH_PAYLOAD  2   // the content is cached too, in the prefetch buffer
 
-  return status;
-}
+#if EASY_MFRC522_ENABLE_PREFETCH
 
 /**
- * Reads the identification block, checking if it is properly identified with the given 
- * data label, then parses and returns the size of the data stored in the remaining blocks.
+ * Sets the list of files to be prefetched. Only the fields "block" and "label" of the 
+ * entries must be given. The contents of the files are copied to "buffer", as long as 
+ * they fit, in the order of their blocks (the other files have only their sizes cached).
  * 
- * Returns: negative number -- error
- *          positive number -- the size of the data stored (starting from the next block, not counting trailling blocks)
+ * The list, the labels and the buffer must be kept allocated while used by this class.
+ * Call with numEntries = 0 to disable the prefetching.
  */
-int EasyMFRC522::readFileSize(int initialBlock, const char dataLabel[12]) {
-  MFRC522::StatusCode status = MFRC522::STATUS_ERROR;
-
-  if (initialBlock % 4 == 3) { //it is a trailer block --> go to the next one
-    initialBlock ++;
+void EasyMFRC522::setPrefetchList(RfidPrefetchEntry* entries, byte numEntries, byte* buffer, int bufferSize) {
+  this->prefetchList = entries;
+  this->prefetchListSize = (entries != NULL)? numEntries : 0;
+  this->prefetchBuffer = buffer;
+  this->prefetchBufferSize = (buffer != NULL)? bufferSize : 0;
+
+  for (int i = 0; i < this->prefetchListSize; i ++) {
+    if (_isTrailerBlock(entries[i].block)) { // the same adjustment done in readFileSize()
+      entries[i].block ++;
+    }
+    entries[i].flags = 0;
+    entries[i].state = PREFETCH_NONE;
   }
+}
 
-  for (int i = 0; i < READ_WRITE_TRIALS; i ++) {
-    status = this->device.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, initialBlock, &this->key, &(this->device.uid));
-    if (status == MFRC522::STATUS_OK) {
+void EasyMFRC522::_prefetch() {
+  int bufferUsed = 0;
+  int previousBlock = -1;
+
+  // visits the entries in the order of their blocks (the list is expected to be small)
+  for (int visited = 0; visited < this->prefetchListSize; visited ++) {
+    RfidPrefetchEntry* next = NULL;
+    for (int i = 0; i < this->prefetchListSize; i ++) {
+      RfidPrefetchEntry* entry = &this->prefetchList[i];
+      if (entry->state == PREFETCH_NONE && entry->block >= previousBlock 
+          && (next == NULL || entry->block < next->block)) {
+        next = entry;
+      }
+    }
+    if (next == NULL) {
       break;
     }
-    dbgPrintln(F("    na"));
-  }
-  if (status != MFRC522::STATUS_OK) {
-    dbgPrintln("Error readFileSize(): could not authenticate");
-    return -8;
-  }
+    previousBlock = next->block;
 
-  byte bufferSize = 18;
-  for (int i = 0; i < READ_WRITE_TRIALS; i ++) {
-    status = this->device.MIFARE_Read(initialBlock, blockBuffer, &bufferSize);
-    if (status == MFRC522::STATUS_OK) {
-      break;
+    next->flags = 0;
+    int size = _readFileHeader(next->block, next->label, &next->flags);
+    if (size == -8 || size == -9) {
+      break;  // communication failure: the other entries are not cached
+    }
+    next->size = size;
+    next->state = PREFETCH_HEADER;
+
+    // encrypted files are not cached, to keep the plain data only in the buffer of the caller
+    if (size >= 0 && next->flags == 0 && size <= this->prefetchBufferSize - bufferUsed) {
+      if (readRaw(next->block + 1, this->prefetchBuffer + bufferUsed, size) >= 0) {
+        next->offset = bufferUsed;
+        next->state = PREFETCH_PAYLOAD;
+        bufferUsed += size;
+      }
+    } else if (size >= 0 && (next->flags & EASY_MFRC522_FILE_INLINE) && size <= this->prefetchBufferSize - bufferUsed) {
+      memcpy(this->prefetchBuffer + bufferUsed, blockBuffer + 14, size);  // the header was just read to blockBuffer
+      next->offset = bufferUsed;
+      next->state = PREFETCH_PAYLOAD;
+      bufferUsed += size;
     }
   }
-  if (status != MFRC522::STATUS_OK) {
-    dbgPrintln("Error readFileSize(): could not read");
-    return -9;
-  }
+}
 
-  if (blockBuffer[0] != 0x1C) {
-    dbgPrintln("Error readFileSize(): this block does not start a file");
-    return -10;
+RfidPrefetchEntry* EasyMFRC522::_findPrefetched(int initialBlock, const char dataLabel[12]) {
+  for (int i = 0; i < this->prefetchListSize; i ++) {
+    RfidPrefetchEntry* entry = &this->prefetchList[i];
+    if (entry->state != PREFETCH_NONE && entry->block == initialBlock 
+        && strncmp(entry->label, dataLabel, 12) == 0) {
+      return entry;
+    }
   }
-  
-  // checks if all characters of the data label matches, including the final \0
-  // if the label has more than 12 chars, only the first 12 chars are considered
-  for (int i = 0; i < 12; i++) {
-    if (dataLabel[i] != blockBuffer[i+1]) {
-      dbgPrintln("Error readFileSize(): data label doesn't match");
-      return -11;
+  return NULL;
+}
+
+// Discards the cached files that have any block in the given interval.
+void EasyMFRC522::_invalidatePrefetch(int firstBlock, int lastBlock) {
+  for (int i = 0; i < this->prefetchListSize; i ++) {
+    RfidPrefetchEntry* entry = &this->prefetchList[i];
+    if (entry->state == PREFETCH_NONE) {
+      continue;
+    }
+    int entryLastBlock = entry->block;
+    int extent = (entry->size < 0)? 0 : entry->size;
+    if (entry->flags & EASY_MFRC522_FILE_ENCRYPTED) {
+      extent += 16;  // the block with the nonce and the tag
+    } else if (entry->flags & EASY_MFRC522_FILE_INLINE) {
+      extent = 0;    // only the header
+    } else if ((entry->flags & EASY_MFRC522_FILE_PARITY) && (entry->flags >> 4) > 0) {
+      int dataBlocks = (extent + 15) / 16;
+      extent = 16 * (dataBlocks + (dataBlocks + (entry->flags >> 4) - 1) / (entry->flags >> 4));  // with the parity blocks
+    }
+    if (extent > 0) {
+      entryLastBlock = getBlockOfOffset(entry->block + 1, extent - 1);
+      if (entryLastBlock < 0) {
+        entryLastBlock = 0x7FFF;
+      }
+    }
+    if (entry->block <= lastBlock && firstBlock <= entryLastBlock) {
+      entry->state = PREFETCH_NONE;
     }
-    if (dataLabel[i] == '\0')  //in this situation, we have already confirmed that blockBuffer[i+1] == '\0' in the "if" above
-      break;
   }
+}
 
-  //int flags = blockBuffer[13]; //for future use
+#endif  // EASY_MFRC522_ENABLE_PREFETCH
 
-  int dataSize = ((unsigned int)blockBuffer[15] << 8) | (unsigned int)blockBuffer[14];
-  return dataSize;
-}
+
+///////////////////////////////////////////////////
+//////////////// TRACE AND REPLAY /////////////////
+
+/*
+ * If a trace buffer is given, each command issued to the tag (authentication, read, write, 
+ * selection, halt and value operations) is recorded in it, with the block, the status and 
+ * the time. The buffer is used as a ring: when it is full, the oldest records are replaced.
+ * So, after a problem in the field (e.g. a slow tap, many retries), the trace shows the 
+ * last commands issued. It may be dumped in a compact binary format with dumpTrace(), and 
+ * loaded back with parseTrace().
+ * 
+ * A trace may be replayed with startReplay(): the authentications, reads, writes and value 
+ * operations are not sent to the MFRC522, but get the status recorded in the trace (and, 
+ * optionally, take the time recorded). So, the retries and the timing of writeRaw(), 
+ * readRaw() and the other functions can be re-run without the tag (or the same tag in the
+ * same position), e.g. to profile them. In the replay, a read of the last block written 
+ * gives the data written (to pass the verification done by writeRaw()); other reads give 
+ * zeros. Selections and halts in the trace are skipped.
+ * 
+ * Binary format of the dump: "RFTR", version (1 byte), size of each record (1 byte), 
+ * number of records (2 bytes), then the records from the oldest one, with all fields 
+ * in little-endian order (9 bytes each).
+ */
+
+#if EASY_MFRC522_ENABLE_TRACE
+
+#define TRACE_DUMP_HEADER_SIZE  8
+#define TRACE_DUMP_RECORD_SIZE  9
+
+void EasyMFRC522::setTraceBuffer(RfidTraceRecord* buffer, int capacity) {
+  this->traceBuffer = buffer;
+  this->traceCapacity = (buffer != NULL)? capacity : 0;
+  clearTrace();
+}
+
+void EasyMFRC522::clearTrace() {
+  this->traceSize = 0;
+  this->traceNext = 0;
+}
+
+void EasyMFRC522::_trace(byte command, byte block, MFRC522::StatusCode status, unsigned long startMicros) {
+  if (this->traceCapacity <= 0) {
+    return;
+  }
+  unsigned long duration = micros() - startMicros;
+
+  RfidTraceRecord* record = &this->traceBuffer[this->traceNext];
+  record->time = startMicros;
+  record->duration = (duration > 0xFFFF)? 0xFFFF : (uint16_t)duration;
+  record->command = command;
+  record->block = block;
+  record->status = (byte)status;
+
+  this->traceNext = (this->traceNext + 1) % this->traceCapacity;
+  if (this->traceSize < this->traceCapacity) {
+    this->traceSize ++;
+  }
+}
+
+// Gives the record in the given position of the trace, where 0 is the oldest one.
+bool EasyMFRC522::getTraceRecord(int index, RfidTraceRecord* recordOut) {
+  if (index < 0 || index >= this->traceSize) {
+    return false;
+  }
+  int first = (this->traceNext - this->traceSize + this->traceCapacity) % this->traceCapacity;
+  *recordOut = this->traceBuffer[(first + index) % this->traceCapacity];
+  return true;
+}
+
+/**
+ * Writes the trace to the output (e.g. Serial, or a file), in the binary format described 
+ * above. Returns the number of bytes written.
+ */
+int EasyMFRC522::dumpTrace(Print& output) {
+  byte bytes[TRACE_DUMP_RECORD_SIZE];
+  int written = 0;
+
+  bytes[0] = 'R'; bytes[1] = 'F'; bytes[2] = 'T'; bytes[3] = 'R';
+  bytes[4] = 1;
+  bytes[5] = TRACE_DUMP_RECORD_SIZE;
+  bytes[6] = (byte)this->traceSize;
+  bytes[7] = (byte)(this->traceSize >> 8);
+  written += output.write(bytes, TRACE_DUMP_HEADER_SIZE);
+
+  RfidTraceRecord record;
+  for (int i = 0; i < this->traceSize; i ++) {
+    getTraceRecord(i, &record);
+    for (byte b = 0; b < 4; b ++) {
+      bytes[b] = (byte)(record.time >> (8*b));
+    }
+    bytes[4] = (byte)record.duration;
+    bytes[5] = (byte)(record.duration >> 8);
+    bytes[6] = record.command;
+    bytes[7] = record.block;
+    bytes[8] = record.status;
+    written += output.write(bytes, TRACE_DUMP_RECORD_SIZE);
+  }
+
+  return written;
+}
+
+/**
+ * Reads the records from a dump made by dumpTrace() (e.g. kept in a const array).
+ * 
+ * Returns: negative number -- error (-500: invalid dump)
+ *          positive number -- the number of records copied to "recordsOut"
+ */
+int EasyMFRC522::parseTrace(const byte* dump, int dumpSize, RfidTraceRecord* recordsOut, int maxRecords) {
+  if (dumpSize < TRACE_DUMP_HEADER_SIZE || dump[0] != 'R' || dump[1] != 'F' || dump[2] != 'T' || dump[3] != 'R'
+      || dump[4] != 1 || dump[5] != TRACE_DUMP_RECORD_SIZE) {
+    return -500;
+  }
+  int numRecords = (int)((unsigned int)dump[7] << 8 | dump[6]);
+  if (dumpSize < TRACE_DUMP_HEADER_SIZE + numRecords * TRACE_DUMP_RECORD_SIZE) {
+    return -500;
+  }
+  if (numRecords > maxRecords) {
+    numRecords = maxRecords;
+  }
+
+  for (int i = 0; i < numRecords; i ++) {
+    const byte* bytes = dump + TRACE_DUMP_HEADER_SIZE + i * TRACE_DUMP_RECORD_SIZE;
+    recordsOut[i].time = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    recordsOut[i].duration = (uint16_t)bytes[4] | ((uint16_t)bytes[5] << 8);
+    recordsOut[i].command = bytes[6];
+    recordsOut[i].block = bytes[7];
+    recordsOut[i].status = bytes[8];
+  }
+  return numRecords;
+}
+
+/**
+ * Starts replaying the given trace: the next commands get the results from the trace,
+ * instead of the tag (see the comments above). If "realTime" is true, each command takes
+ * the time recorded. The trace must be kept allocated until stopReplay() is called.
+ * 
+ * Commands different from the ones in the trace (in the same position) are counted as
+ * mismatches (see getReplayMismatches()). After the end of the trace, all the commands
+ * fail with a timeout, as if the tag had left the field.
+ */
+void EasyMFRC522::startReplay(const RfidTraceRecord* trace, int traceSize, bool realTime) {
+  this->replayTrace = trace;
+  this->replaySize = (trace != NULL)? traceSize : 0;
+  this->replayPosition = 0;
+  this->replayMismatches = 0;
+  this->replayRealTime = realTime;
+  this->replayBlockAddr = -1;
+  resetAuthentication();
+  _invalidatePrefetch(0, 0x7FFF);
+}
+
+void EasyMFRC522::stopReplay() {
+  this->replayTrace = NULL;
+  resetAuthentication();
+  _invalidatePrefetch(0, 0x7FFF);
+}
+
+static bool isReplayed(byte command) {
+  return command != RFID_TRACE_SELECT && command != RFID_TRACE_HALT;
+}
+
+// If replaying, gives the status of the next command in the trace and returns true.
+bool EasyMFRC522::_replay(byte command, byte block, MFRC522::StatusCode* status) {
+  if (this->replayTrace == NULL) {
+    return false;
+  }
+
+  while (this->replayPosition < this->replaySize && !isReplayed(this->replayTrace[this->replayPosition].command)) {
+    this->replayPosition ++;
+  }
+  if (this->replayPosition >= this->replaySize) {
+    *status = MFRC522::STATUS_TIMEOUT;
+    return true;
+  }
+
+  const RfidTraceRecord* record = &this->replayTrace[this->replayPosition];
+  this->replayPosition ++;
+  if (record->command != command || record->block != block) {
+    this->replayMismatches ++;
+  }
+  if (this->replayRealTime) {
+    delay(record->duration / 1000);
+    delayMicroseconds(record->duration % 1000);
+  }
+  *status = (MFRC522::StatusCode)record->status;
+  return true;
+}
+
+#endif  // EASY_MFRC522_ENABLE_TRACE
+
+
+///////////////////////////////////////////////////
+/////////////////// DIAGNOSTICS ///////////////////
+
+/*
+ * The library doesn't print anything (printing to Serial blocks for milliseconds, at low
+ * baud rates, in the middle of an operation with the tag). Instead, the errors of the 
+ * commands sent to the tag (and some other events) are kept as structured events (code, 
+ * block and status), in a fixed-size ring buffer. The application takes them with 
+ * popDiagnostic() when it chooses (e.g. after the tag is released), and may also give a
+ * sink, which is called as each event happens (it must not block either).
+ * 
+ * When the ring is full, the oldest event is discarded (see getLostDiagnostics()). Each
+ * failed trial of a command is an event, so the events also show the retries done.
+ */
+
+#if EASY_MFRC522_ENABLE_DIAGNOSTICS
+
+// Records an event (also used by the other classes of the library).
+void EasyMFRC522::reportDiagnostic(int code, int block, byte status) {
+  RfidDiagnostic* event = &this->diagnostics[this->diagnosticsNext];
+  event->time = millis();
+  event->code = code;
+  event->block = block;
+  event->status = status;
+
+  this->diagnosticsNext = (this->diagnosticsNext + 1) % EASY_MFRC522_DIAGNOSTICS_SIZE;
+  if (this->diagnosticsSize < EASY_MFRC522_DIAGNOSTICS_SIZE) {
+    this->diagnosticsSize ++;
+  } else {
+    this->diagnosticsLost ++;
+  }
+
+  if (this->diagnosticSink != NULL) {
+    this->diagnosticSink(*event, this->diagnosticContext);
+  }
+}
+
+// Takes the oldest event kept. Returns false if there is none.
+bool EasyMFRC522::popDiagnostic(RfidDiagnostic* eventOut) {
+  if (this->diagnosticsSize == 0) {
+    return false;
+  }
+  int oldest = (this->diagnosticsNext + EASY_MFRC522_DIAGNOSTICS_SIZE - this->diagnosticsSize) % EASY_MFRC522_DIAGNOSTICS_SIZE;
+  *eventOut = this->diagnostics[oldest];
+  this->diagnosticsSize --;
+  return true;
+}
+
+void EasyMFRC522::clearDiagnostics() {
+  this->diagnosticsNext = 0;
+  this->diagnosticsSize = 0;
+  this->diagnosticsLost = 0;
+}
+
+#endif  // EASY_MFRC522_ENABLE_DIAGNOSTICS
+
+
+///////////////////////////////////////////////////
+////////////////// PROVISIONING ///////////////////
+
+/*
+ * To write the same data to many tags (e.g. new badges), the data may be laid out in blocks
+ * only once, in an image (see RfidProvisioningImage), and then written to each tag with 
+ * applyImage(). The image is applied sector by sector, with one authentication per sector,
+ * and the blocks are written without reading each one back (as writeRaw() does). If option
+ * RFID_IMAGE_VERIFY is given, the blocks of each sector are read back only after all 
+ * blocks of the sector are written (still with the same authentication). A block that
+ * fails the verification is written again.
+ * 
+ * With RFID_IMAGE_SKIP_UNCHANGED, each block is read first, and it is not written if it
+ * already has the data of the image (a read is faster than a write). With 
+ * RFID_IMAGE_SKIP_BLANK, the blocks of the image with only 0s are not written at all 
+ * (which is correct only for blank tags).
+ */
+
+/**
+ * Writes the image in the (selected) tag. 
+ * 
+ * Returns: negative number -- error
+ *          zero or positive -- number of blocks written
+ */
+int EasyMFRC522::applyImage(const RfidImage& image, byte options) {
+  static const byte zeros[16] = { 0 };
+  MFRC522::StatusCode status = MFRC522::STATUS_ERROR;
+  int numBlocks = image.getNumBlocks();
+  int blocksWritten = 0;
+  int first = 0;
+
+  while (first < numBlocks) {
+    // the blocks of the image in the same sector are: first, first+1, ..., last-1
+    int sector = _sectorOf(image.getBlock(first).block);
+    int last = first + 1;
+    while (last < numBlocks && _sectorOf(image.getBlock(last).block) == sector) {
+      last ++;
+    }
+
+    status = _authenticate(image.getBlock(first).block);
+    if (status != MFRC522::STATUS_OK) {
+      dbgPrint("Error applyImage(): could not authenticate, block "); dbgPrintln(image.getBlock(first).block);
+      _invalidatePrefetch(0, 0x7FFF);
+      return -601;
+    }
+
+    uint16_t written = 0;   // bit i is set if the block first+i was written (a sector has at most 16 blocks)
+
+    for (int i = first; i < last; i ++) {
+      const RfidImageBlock& entry = image.getBlock(i);
+      if (isValueBlock(entry.block)) {
+        dbgPrint("Error applyImage(): cannot overwrite value block "); dbgPrintln(entry.block);
+        _invalidatePrefetch(0, 0x7FFF);
+        return -602;
+      }
+      if ((options & RFID_IMAGE_SKIP_BLANK) && memcmp(entry.data, zeros, 16) == 0) {
+        continue;
+      }
+      if ((options & RFID_IMAGE_SKIP_UNCHANGED) && _mifareRead(entry.block, blockBuffer) == MFRC522::STATUS_OK
+          && memcmp(entry.data, blockBuffer, 16) == 0) {
+        continue;
+      }
+
+      for (int t = 0; t < READ_WRITE_TRIALS; t ++) {
+        if (t > 0 || this->authenticatedSector != sector) {
+          _authenticate(entry.block);  // a failure may have reset the authentication
+        }
+        status = _mifareWrite(entry.block, entry.data);
+        if (status == MFRC522::STATUS_OK) {
+          break;
+        }
+      }
+      if (status != MFRC522::STATUS_OK) {
+        dbgPrint("Error applyImage(): could not write block "); dbgPrintln(entry.block);
+        _invalidatePrefetch(0, 0x7FFF);
+        return -603;
+      }
+      written |= (uint16_t)1 << (i - first);
+      blocksWritten ++;
+    }
+
+    if (options & RFID_IMAGE_VERIFY) {
+      for (int i = first; i < last; i ++) {
+        if ((written & ((uint16_t)1 << (i - first))) == 0) {
+          continue;
+        }
+        const RfidImageBlock& entry = image.getBlock(i);
+        int code = -3;
+        for (int t = 0; t < READ_WRITE_TRIALS && code < 0; t ++) {
+          if (t > 0) {
+            _authenticate(entry.block);
+            if (code == -4 && _mifareWrite(entry.block, entry.data) != MFRC522::STATUS_OK) {
+              continue;  // the block is written again, only if it was read with different data
+            }
+          }
+          code = _verifyBlock(entry.block, (byte*)entry.data, 0, 16);
+        }
+        if (code < 0) {
+          _invalidatePrefetch(0, 0x7FFF);
+          return -610 + code;
+        }
+      }
+    }
+
+    first = last;
+  }
+
+  _invalidatePrefetch(0, 0x7FFF);
+  return blocksWritten;
+}
+
+///////////////////////////////////////////////////
+///////////////////// BATCHES /////////////////////
+
+/*
+ * A batch (see RfidBatch) holds reads and writes of raw data and files, which are executed
+ * by executeBatch() in a single pass over the blocks of the tag, in increasing order. So, 
+ * each sector is authenticated only once, however many requests access it, and in any 
+ * order they were added. Requests that overlap (or are adjacent) are merged in the level 
+ * of the blocks: each block is written once (with the data of the last request that writes
+ * it) and read once (for all the requests that read it).
+ * 
+ * All the writes are considered to be done before the reads: a request that reads a block
+ * written in the batch gets the new data (which was already read back, in the verification
+ * of the write). A request fails in the first block with error, and its other blocks are 
+ * not accessed, but the other requests go on. If the authentication fails (e.g. the tag 
+ * left the field), all the requests not completed fail.
+ */
+
+// Gives the block of the data at position "offset", for a data chunk starting at block 
+// "firstBlock" (already valid), skipping only the trailers. Returns -1 if out of the tag.
+static int blockOfBatchOffset(int firstBlock, int offset, int lastBlock) {
+  int block = firstBlock;
+  for (int i = offset / 16; i > 0; i --) {
+    block ++;
+    if (easyMfrc522IsTrailer(block)) {
+      block ++;
+    }
+  }
+  return (block > lastBlock)? -1 : block;
+}
+
+// Gives the position (in the data) of the given block of the request.
+static int offsetOfBatchBlock(const RfidBatchRequest& request, int block) {
+  int offset = (request.type == RFID_BATCH_WRITE_FILE)? -16 : 0;  // the first block of a file is the header
+  for (int b = request.firstBlock; b < block; b ++) {
+    if (!easyMfrc522IsTrailer(b)) {
+      offset += 16;
+    }
+  }
+  return offset;
+}
+
+static inline bool isBatchWrite(const RfidBatchRequest& request) {
+  return request.type == RFID_BATCH_WRITE || request.type == RFID_BATCH_WRITE_FILE;
+}
+
+static inline bool usesBlock(const RfidBatchRequest& request, int block) {
+  return request.result >= 0 && block >= request.firstBlock && block <= request.lastBlock;
+}
+
+/**
+ * Executes the requests of the batch (see the comments above). The result of each request
+ * is given by batch.getResult(), and it is the same that the corresponding function of 
+ * this class would give (the last block written, or the size read), or a negative error.
+ * 
+ * Returns: negative number -- the error of the first request that failed
+ *          positive number -- the number of sectors accessed
+ */
+int EasyMFRC522::executeBatch(RfidBatch& batch) {
+  int numRequests = batch.getNumRequests();
+  int minBlock = 0x7FFF;
+  int maxBlock = -1;
+
+  // finds the blocks of each request
+  for (int i = 0; i < numRequests; i ++) {
+    RfidBatchRequest& request = batch.getRequest(i);
+    int first = request.firstBlock;
+    if (first >= 0 && (_isTrailerBlock(first) || (first == 0 && isBatchWrite(request)))) {  // block 0 is skipped only in writes, as in writeRaw()
+      first ++;
+    }
+    int totalSize = request.size + ((request.type == RFID_BATCH_WRITE_FILE)? 16 : 0);
+    int last = (totalSize > 0)? blockOfBatchOffset(first, totalSize - 1, _lastBlock()) : 0;
+
+    request.result = 0;
+    if (totalSize == 0) {
+      request.firstBlock = 1;  // no block is used
+      request.lastBlock = 0;
+    } else if (request.firstBlock < 0 || first > _lastBlock() || last < 0) {
+      dbgPrint("Error executeBatch(): not enough space, request "); dbgPrintln(i);
+      request.result = -902;
+    } else {
+      request.firstBlock = first;
+      request.lastBlock = last;
+      minBlock = (first < minBlock)? first : minBlock;
+      maxBlock = (last > maxBlock)? last : maxBlock;
+    }
+  }
+
+  int sector = -1;
+  int sectors = 0;
+  byte chunk[16];
+
+  for (int block = minBlock; block <= maxBlock; block ++) {
+    if (_isTrailerBlock(block)) {
+      continue;
+    }
+
+    // finds the last request that writes the block, and if some request reads it
+    int writer = -1;
+    bool read = false;
+    for (int i = 0; i < numRequests; i ++) {
+      RfidBatchRequest& request = batch.getRequest(i);
+      if (usesBlock(request, block)) {
+        if (isBatchWrite(request)) {
+          writer = i;
+        } else {
+          read = true;
+        }
+      }
+    }
+    if (writer < 0 && !read) {
+      continue;
+    }
+
+    if (_sectorOf(block) != sector) {
+      sector = _sectorOf(block);
+      if (_authenticate(block) != MFRC522::STATUS_OK) {
+        dbgPrint("Error executeBatch(): could not authenticate, block "); dbgPrintln(block);
+        for (int i = 0; i < numRequests; i ++) {
+          RfidBatchRequest& request = batch.getRequest(i);
+          if (request.result == 0 && request.lastBlock >= block) {
+            request.result = -904;
+          }
+        }
+        break;
+      }
+      sectors ++;
+    }
+
+    int code = 0;
+    bool hasData = false;  // if "chunk" has the content of the block (in the tag)
+
+    if (writer >= 0) {
+      RfidBatchRequest& request = batch.getRequest(writer);
+      int offset = offsetOfBatchBlock(request, block);
+      int bytes = 16;
+      memset(chunk, 0, 16);
+      if (offset < 0) {
+        fillFileHeader(chunk, request.label, 0, request.size);
+      } else {
+        bytes = request.size - offset;
+        bytes = (bytes < 16)? bytes : 16;
+        memcpy(chunk, request.data + offset, bytes);
+      }
+
+      if (isValueBlock(block)) {
+        dbgPrint("Error executeBatch(): cannot overwrite value block "); dbgPrintln(block);
+        code = -903;
+      } else {
+        for (int t = 0; t < READ_WRITE_TRIALS; t ++) {
+          if (t > 0) {
+            _authenticate(block);  // a failure may have reset the authentication
+          }
+          code = _writeBlockAndVerify(block, chunk, 0, bytes);
+          if (code >= 0) {
+            break;
+          }
+        }
+        code = (code < 0)? -920 + code : 0;
+        _invalidatePrefetch(block, block);
+      }
+
+      // the requests that write the block succeed or fail together
+      for (int i = 0; i < numRequests; i ++) {
+        RfidBatchRequest& other = batch.getRequest(i);
+        if (code < 0 && isBatchWrite(other) && usesBlock(other, block)) {
+          other.result = code;
+        }
+      }
+      hasData = (code == 0);
+    }
+
+    if (read && !hasData) {
+      for (int t = 0; t < READ_WRITE_TRIALS; t ++) {
+        if (t > 0) {
+          _authenticate(block);
+        }
+        code = _readBlock(block, chunk, 0, 16);
+        if (code >= 0) {
+          break;
+        }
+      }
+      code = (code < 0)? -910 + code : 0;
+      hasData = (code == 0);
+    }
+
+    // gives the data of the block to the requests that read it
+    for (int i = 0; read && i < numRequests; i ++) {
+      RfidBatchRequest& request = batch.getRequest(i);
+      if (isBatchWrite(request) || !usesBlock(request, block)) {
+        continue;
+      }
+      if (!hasData) {
+        request.result = code;
+        continue;
+      }
+      int offset = offsetOfBatchBlock(request, block);
+      int bytes = request.size - offset;
+      memcpy(request.data + offset, chunk, (bytes < 16)? bytes : 16);
+    }
+  }
+
+  // the requests not failed are completed
+  int firstError = 0;
+  for (int i = 0; i < numRequests; i ++) {
+    RfidBatchRequest& request = batch.getRequest(i);
+    if (request.result == 0) {
+      request.result = isBatchWrite(request)? request.lastBlock : request.size;
+    } else if (firstError == 0) {
+      firstError = request.result;
+    }
+  }
+  return (firstError < 0)? firstError : sectors;
+}
+
+
+///////////////////////////////////////////////////
+/////////////////// VALUE BLOCKS //////////////////
+
+/*
+ * A value block holds a signed 32-bit integer in the redundant format defined by Mifare
+ * Classic (see section 8.6.2.1 of the datasheet in "docs/"):
+ * 
+ *   bytes  0-3  : value
+ *   bytes  4-7  : value, inverted (bitwise not)
+ *   bytes  8-11 : value
+ *   bytes 12-15 : addr, ~addr, addr, ~addr  (a byte freely used by the application, 
+ *                 e.g. to point to a backup block)
+ * 
+ * The PICC itself increments/decrements the value, keeping the result in an internal 
+ * register, which is then stored in a block with the "transfer" command. So, each 
+ * operation needs no read of the block, and the value in the block is either the old 
+ * or the new one, even if the tag leaves the field in the middle of the operation.
+ * 
+ * Value blocks are declared (in this class) when formatted with formatValueBlock(), or 
+ * with declareValueBlock(). Then, writeRaw() (and the functions that use it) refuse to
+ * write over them. The declaration is kept for all tags, because it is supposed to be 
+ * part of the layout used by the application.
+ */
+
+void EasyMFRC522::declareValueBlock(int blockAddr, bool isValue) {
+  if (blockAddr < 0 || blockAddr >= EASY_MFRC522_VALUE_BLOCKS_MAP_SIZE) {
+    return;
+  }
+  if (isValue) {
+    valueBlocksMap[blockAddr / 8] |= (1 << (blockAddr % 8));
+  } else {
+    valueBlocksMap[blockAddr / 8] &= ~(1 << (blockAddr % 8));
+  }
+}
+
+bool EasyMFRC522::isValueBlock(int blockAddr) {
+  if (blockAddr < 0 || blockAddr >= EASY_MFRC522_VALUE_BLOCKS_MAP_SIZE) {
+    return false;
+  }
+  return (valueBlocksMap[blockAddr / 8] & (1 << (blockAddr % 8))) != 0;
+}
+
+/**
+ * Writes the given value in the format of a value block, and declares the block as a
+ * value block. The byte "addr" is stored with the value (it is not used by this class).
+ * 
+ * Returns: negative number -- error
+ *          zero            -- success
+ */
+int EasyMFRC522::formatValueBlock(int blockAddr, int32_t value, byte addr) {
+  if (_isTrailerBlock(blockAddr) || blockAddr == 0) {
+    return -300;
+  }
+
+  byte formatted[16];
+  for (byte i = 0; i < 4; i ++) {
+    byte b = (byte)(value >> (8*i));
+    formatted[i] = b;
+    formatted[i+4] = ~b;
+    formatted[i+8] = b;
+  }
+  formatted[12] = addr;
+  formatted[13] = ~addr;
+  formatted[14] = addr;
+  formatted[15] = ~addr;
+
+  if (_authenticate(blockAddr) != MFRC522::STATUS_OK) {
+    dbgPrintln("Error formatValueBlock(): could not authenticate");
+    return -301;
+  }
+
+  int code = -1;
+  for (int i = 0; i < READ_WRITE_TRIALS && code < 0; i ++) {
+    code = _writeBlockAndVerify(blockAddr, formatted, 0, 16);
+  }
+  _invalidatePrefetch(blockAddr, blockAddr);
+  if (code < 0) {
+    return -310 + code;
+  }
+
+  declareValueBlock(blockAddr, true);
+  return 0;
+}
+
+/**
+ * Reads the value block, checking its redundant format.
+ * 
+ * Returns: negative number -- error (e.g. -323 if the block is not a valid value block)
+ *          zero            -- success, with the value copied to "valueOut"
+ */
+int EasyMFRC522::readValue(int blockAddr, int32_t* valueOut, byte* addrOut) {
+  if (_authenticate(blockAddr) != MFRC522::STATUS_OK) {
+    dbgPrintln("Error readValue(): could not authenticate");
+    return -321;
+  }
+
+  MFRC522::StatusCode status = MFRC522::STATUS_ERROR;
+  for (int i = 0; i < READ_WRITE_TRIALS; i ++) {
+    status = _mifareRead(blockAddr, blockBuffer);
+    if (status == MFRC522::STATUS_OK) {
+      break;
+    }
+  }
+  if (status != MFRC522::STATUS_OK) {
+    dbgPrintln("Error readValue(): could not read");
+    return -322;
+  }
+
+  for (byte i = 0; i < 4; i ++) {
+    if (blockBuffer[i] != (byte)~blockBuffer[i+4] || blockBuffer[i] != blockBuffer[i+8]) {
+      dbgPrintln("Error readValue(): not a valid value block");
+      return -323;
+    }
+  }
+  if (blockBuffer[12] != blockBuffer[14] || blockBuffer[13] != blockBuffer[15] || blockBuffer[12] != (byte)~blockBuffer[13]) {
+    dbgPrintln("Error readValue(): not a valid value block");
+    return -323;
+  }
+
+  *valueOut = (int32_t)(  (uint32_t)blockBuffer[0]        | ((uint32_t)blockBuffer[1] << 8)
+                       | ((uint32_t)blockBuffer[2] << 16) | ((uint32_t)blockBuffer[3] << 24) );
+  if (addrOut != NULL) {
+    *addrOut = blockBuffer[12];
+  }
+  return 0;
+}
+
+/**
+ * Increments (or decrements, if "increment" is false) the value of the block by "delta"
+ * (a non-negative number), on the PICC. If "transferTo" is a valid block (i.e. non-negative),
+ * the result is stored in it (by default, in the same block). Otherwise, the result is 
+ * kept only in the internal register of the PICC, and transferValue() must be called.
+ * 
+ * The blocks must be in the same sector.
+ */
+int EasyMFRC522::_changeValue(int blockAddr, int32_t delta, bool increment, int transferTo) {
+  if (delta < 0) {
+    return -330;
+  }
+  if (_authenticate(blockAddr) != MFRC522::STATUS_OK) {
+    dbgPrintln("Error _changeValue(): could not authenticate");
+    return -331;
+  }
+
+  // not retried: a second increment could be applied twice
+  MFRC522::StatusCode status;
+  unsigned long start = micros();
+  if (_replay(RFID_TRACE_VALUE, blockAddr, &status)) {
+    // the status comes from the trace
+  } else if (increment) {
+    status = device.MIFARE_Increment(blockAddr, delta);
+  } else {
+    status = device.MIFARE_Decrement(blockAddr, delta);
+  }
+  _trace(RFID_TRACE_VALUE, blockAddr, status, start);
+  if (status != MFRC522::STATUS_OK) {
+    dbgPrintln("Error _changeValue(): operation failed");
+    resetAuthentication();
+    return -332;
+  }
+
+  if (transferTo >= 0) {
+    _invalidatePrefetch(transferTo, transferTo);
+    start = micros();
+    if (! _replay(RFID_TRACE_TRANSFER, transferTo, &status)) {
+      status = device.MIFARE_Transfer(transferTo);
+    }
+    _trace(RFID_TRACE_TRANSFER, transferTo, status, start);
+    if (status != MFRC522::STATUS_OK) {
+      dbgPrintln("Error _changeValue(): transfer failed");
+      resetAuthentication();
+      return -333;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Loads the value of the block into the internal register of the PICC. Then, use 
+ * transferValue() to store it in another block (e.g. to make a backup).
+ */
+int EasyMFRC522::restoreValue(int blockAddr) {
+  if (_authenticate(blockAddr) != MFRC522::STATUS_OK) {
+    dbgPrintln("Error restoreValue(): could not authenticate");
+    return -341;
+  }
+  MFRC522::StatusCode status;
+  unsigned long start = micros();
+  if (! _replay(RFID_TRACE_VALUE, blockAddr, &status)) {
+    status = device.MIFARE_Restore(blockAddr);
+  }
+  _trace(RFID_TRACE_VALUE, blockAddr, status, start);
+  if (status != MFRC522::STATUS_OK) {
+    dbgPrintln("Error restoreValue(): operation failed");
+    resetAuthentication();
+    return -342;
+  }
+  return 0;
+}
+
+/**
+ * Stores the internal register of the PICC (the result of the last increment, decrement
+ * or restore) in the block, which must be in the sector of the last operation.
+ */
+int EasyMFRC522::transferValue(int blockAddr) {
+  _invalidatePrefetch(blockAddr, blockAddr);
+  MFRC522::StatusCode status;
+  unsigned long start = micros();
+  if (! _replay(RFID_TRACE_TRANSFER, blockAddr, &status)) {
+    status = device.MIFARE_Transfer(blockAddr);
+  }
+  _trace(RFID_TRACE_TRANSFER, blockAddr, status, start);
+  if (status != MFRC522::STATUS_OK) {
+    dbgPrintln("Error transferValue(): operation failed");
+    resetAuthentication();
+    return -352;
+  }
+  return 0;
+}
+
+
+///////////////////////////////////////////////////
+//////////////// BURST TRANSFERS //////////////////
+
+/*
+ * Balboa's MIFARE_Read()/MIFARE_Write() access the MFRC522 one register at a time, with
+ * the clock fixed at compile time, and use the coprocessor of the MFRC522 to calculate 
+ * the CRCs (which costs a full command, with its own polling loop, per CRC).
+ * 
+ * The functions below do the same MIFARE commands with less SPI traffic:
+ * - the frame (command or 16 bytes of data) and its CRC_A, calculated in software, are 
+ *   written to the FIFO in one single SPI transaction;
+ * - the response (16 bytes of data plus CRC_A) is read from the FIFO in one single SPI 
+ *   transaction, and the CRC_A is checked in software;
+ * - the status registers read after each command are fetched in one single SPI 
+ *   transaction (the MFRC522 accepts a sequence of addresses in one transaction).
+ * 
+ * They use the SPI clock given to this class (up to 10 MHz), and count the SPI 
+ * transactions and bytes in "stats".
+ */
+
+void EasyMFRC522::_pcdWriteRegister(byte reg, byte value) {
+  SPI.beginTransaction(spiSettings);
+  digitalWrite(chipSelectPin, LOW);
+  SPI.transfer(reg);       // MSB == 0 is for writing; the values of PCD_Register are already shifted
+  SPI.transfer(value);
+  digitalWrite(chipSelectPin, HIGH);
+  SPI.endTransaction();
+
+  stats.spiTransactions ++;
+  stats.spiBytes += 2;
+}
+
+// writes all the values to the same register (used to fill the FIFO)
+void EasyMFRC522::_pcdWriteRegister(byte reg, byte count, const byte* values) {
+  SPI.beginTransaction(spiSettings);
+  digitalWrite(chipSelectPin, LOW);
+  SPI.transfer(reg);
+  for (byte i = 0; i < count; i ++) {
+    SPI.transfer(values[i]);
+  }
+  digitalWrite(chipSelectPin, HIGH);
+  SPI.endTransaction();
+
+  stats.spiTransactions ++;
+  stats.spiBytes += 1 + count;
+}
+
+byte EasyMFRC522::_pcdReadRegister(byte reg) {
+  byte value;
+  _pcdReadRegisters(&reg, 1, &value);
+  return value;
+}
+
+// reads (possibly different) registers in a single transaction: the value of each
+// register comes in the MISO line while the next address is sent in the MOSI line
+void EasyMFRC522::_pcdReadRegisters(const byte* regs, byte count, byte* values) {
+  if (count == 0) {
+    return;
+  }
+  SPI.beginTransaction(spiSettings);
+  digitalWrite(chipSelectPin, LOW);
+  SPI.transfer(0x80 | regs[0]);   // MSB == 1 is for reading
+  for (byte i = 1; i < count; i ++) {
+    values[i-1] = SPI.transfer(0x80 | regs[i]);
+  }
+  values[count-1] = SPI.transfer(0x00);  // stops reading
+  digitalWrite(chipSelectPin, HIGH);
+  SPI.endTransaction();
+
+  stats.spiTransactions ++;
+  stats.spiBytes += 1 + count;
+}
+
+// reads the same register many times (used to empty the FIFO)
+void EasyMFRC522::_pcdReadRegister(byte reg, byte count, byte* values) {
+  if (count == 0) {
+    return;
+  }
+  byte address = 0x80 | reg;
+  SPI.beginTransaction(spiSettings);
+  digitalWrite(chipSelectPin, LOW);
+  SPI.transfer(address);
+  for (byte i = 0; i < count - 1; i ++) {
+    values[i] = SPI.transfer(address);
+  }
+  values[count-1] = SPI.transfer(0x00);
+  digitalWrite(chipSelectPin, HIGH);
+  SPI.endTransaction();
+
+  stats.spiTransactions ++;
+  stats.spiBytes += 1 + count;
+}
+
+/**
+ * Sends the data (already with CRC, if needed) to the PICC and receives the response 
+ * in backData (without checking it). Similar to MFRC522::PCD_TransceiveData(), with
+ * fewer transactions. The timeout (25ms) is given by the timer configured in PCD_Init();
+ * without the IRQ, the polling gives up after 36ms (a fixed number of polls would end
+ * sooner with faster SPI clocks, possibly before the tag answers a write).
+ */
+MFRC522::StatusCode EasyMFRC522::_pcdTransceive(const byte* sendData, byte sendLen, byte* backData, byte* backLen, byte* validBits) {
+  _pcdWriteRegister(MFRC522::CommandReg, MFRC522::PCD_Idle);         // stops any active command
+  _pcdWriteRegister(MFRC522::ComIrqReg, 0x7F);                       // clears all interrupt request bits
+  this->irqFlag = false;
+  this->requestPending = false;                                      // a request of detectTag() is cancelled
+  _pcdWriteRegister(MFRC522::FIFOLevelReg, 0x80);                    // flushes the FIFO
+  _pcdWriteRegister(MFRC522::FIFODataReg, sendLen, sendData);        // whole frame in one burst
+  _pcdWriteRegister(MFRC522::CommandReg, MFRC522::PCD_Transceive);
+  _pcdWriteRegister(MFRC522::BitFramingReg, 0x80);                   // StartSend=1, all bits of the last byte are sent
+
+  // waits for RxIRq or IdleIRq (0x30), or for the timer (0x01)
+  bool completed = false;
+  if (isIrqEnabled()) {
+    // in the IRQ mode, the MFRC522 is read only once, after the interrupt 
+    if (_waitIrq(40)) {
+      byte irq = _pcdReadRegister(MFRC522::ComIrqReg);
+      if (irq & 0x30) {
+        completed = true;
+      } else if (irq & 0x01) {
+        return MFRC522::STATUS_TIMEOUT;
+      }
+    }
+  } else {
+    unsigned long start = millis();
+    do {
+      byte irq = _pcdReadRegister(MFRC522::ComIrqReg);
+      stats.spiPolls ++;
+      if (irq & 0x30) {
+        completed = true;
+        break;
+      }
+      if (irq & 0x01) {
+        return MFRC522::STATUS_TIMEOUT;
+      }
+    } while (millis() - start < 36);
+  }
+  if (! completed) {
+    return MFRC522::STATUS_TIMEOUT;  // communication with the MFRC522 might be down
+  }
+
+  const byte statusRegs[3] = { MFRC522::ErrorReg, MFRC522::FIFOLevelReg, MFRC522::ControlReg };
+  byte statusValues[3];
+  _pcdReadRegisters(statusRegs, 3, statusValues);
+
+  if (statusValues[0] & 0x13) {  // BufferOvfl ParityErr ProtocolErr
+    return MFRC522::STATUS_ERROR;
+  }
+  if (statusValues[0] & 0x08) {  // CollErr
+    return MFRC522::STATUS_COLLISION;
+  }
+
+  byte n = statusValues[1];
+  if (n > *backLen) {
+    return MFRC522::STATUS_NO_ROOM;
+  }
+  *backLen = n;
+  _pcdReadRegister(MFRC522::FIFODataReg, n, backData);  // whole response in one burst
+  *validBits = statusValues[2] & 0x07;                    // RxLastBits; 0 means the whole byte is valid
+
+  return MFRC522::STATUS_OK;
+}
+
+/**
+ * Reads the 16 bytes of the block into the buffer (which must have room for 18 bytes,
+ * because the CRC_A is received too). The sector must be authenticated.
+ */
+MFRC522::StatusCode EasyMFRC522::_mifareRead(byte blockAddr, byte* buffer) {
+  MFRC522::StatusCode status;
+  unsigned long start = micros();
+  stats.blockOperations ++;
+
+  if (_replay(RFID_TRACE_READ, blockAddr, &status)) {
+#if EASY_MFRC522_ENABLE_TRACE
+    for (byte i = 0; i < 16; i ++) {
+      buffer[i] = (blockAddr == this->replayBlockAddr)? this->replayBlock[i] : 0;
+    }
+#endif
+  } else {
+    byte command[4] = { MFRC522::PICC_CMD_MF_READ, blockAddr, 0, 0 };
+    _calculateCrcA(command, 2, &command[2]);
+
+    byte backLen = 18;
+    byte validBits = 0;
+    status = _pcdTransceive(command, 4, buffer, &backLen, &validBits);
+    if (status == MFRC522::STATUS_OK) {
+      if (backLen == 1 && validBits == 4) {  // a 4-bit NAK
+        status = MFRC522::STATUS_MIFARE_NACK;
+      } else if (backLen != 18 || validBits != 0) {
+        status = MFRC522::STATUS_CRC_WRONG;
+      } else {
+        byte crc[2];
+        _calculateCrcA(buffer, 16, crc);
+        if (buffer[16] != crc[0] || buffer[17] != crc[1]) {
+          status = MFRC522::STATUS_CRC_WRONG;
+        }
+      }
+    }
+  }
+
+  _trace(RFID_TRACE_READ, blockAddr, status, start);
+  if (status != MFRC522::STATUS_OK) {
+    this->authenticatedSector = -1;  // the tag may have left the authenticated state
+  }
+  return status;
+}
+
+/**
+ * Writes the 16 bytes of "data" to the block. The sector must be authenticated.
+ * Like in MFRC522::MIFARE_Write(), it is done in two steps, each acknowledged by the PICC.
+ */
+MFRC522::StatusCode EasyMFRC522::_mifareWrite(byte blockAddr, const byte* data) {
+  MFRC522::StatusCode status;
+  unsigned long start = micros();
+  stats.blockOperations ++;
+
+  if (_replay(RFID_TRACE_WRITE, blockAddr, &status)) {
+#if EASY_MFRC522_ENABLE_TRACE
+    if (status == MFRC522::STATUS_OK) {
+      memcpy(this->replayBlock, data, 16);
+      this->replayBlockAddr = blockAddr;
+    }
+#endif
+  } else {
+    byte frame[18];
+    byte ack[1];
+    byte ackLen;
+    byte validBits;
+
+    // step 1: the command
+    frame[0] = MFRC522::PICC_CMD_MF_WRITE;
+    frame[1] = blockAddr;
+    _calculateCrcA(frame, 2, &frame[2]);
+    ackLen = 1;
+    status = _pcdTransceive(frame, 4, ack, &ackLen, &validBits);
+    if (status == MFRC522::STATUS_OK && (ackLen != 1 || validBits != 4 || (ack[0] & 0x0F) != MFRC522::MF_ACK)) {
+      status = MFRC522::STATUS_MIFARE_NACK;
+    }
+
+    // step 2: the data
+    if (status == MFRC522::STATUS_OK) {
+      for (byte i = 0; i < 16; i ++) {
+        frame[i] = data[i];
+      }
+      _calculateCrcA(frame, 16, &frame[16]);
+      ackLen = 1;
+      status = _pcdTransceive(frame, 18, ack, &ackLen, &validBits);
+      if (status == MFRC522::STATUS_OK && (ackLen != 1 || validBits != 4 || (ack[0] & 0x0F) != MFRC522::MF_ACK)) {
+        status = MFRC522::STATUS_MIFARE_NACK;
+      }
+    }
+  }
+
+  _trace(RFID_TRACE_WRITE, blockAddr, status, start);
+  if (status != MFRC522::STATUS_OK) {
+    this->authenticatedSector = -1;  // the tag may have left the authenticated state
+  }
+  return status;
+}
+
+// CRC_A of ISO/IEC 14443-3 (initial value 0x6363), with the low byte first in "result"
+void EasyMFRC522::_calculateCrcA(const byte* data, byte length, byte* result) {
+  uint16_t crc = 0x6363;
+  for (byte i = 0; i < length; i ++) {
+    byte b = data[i] ^ (byte)(crc & 0xFF);
+    b ^= (byte)(b << 4);
+    crc = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ ((uint16_t)b >> 4);
+  }
+  result[0] = (byte)(crc & 0xFF);
+  result[1] = (byte)(crc >> 8);
+}
+
+
+///////////////////////////////////////////////////
+///////////////////// IRQ MODE ////////////////////
+
+/*
+ * By default, the end of each command is found by polling the MFRC522 (i.e. reading its
+ * ComIrqReg register repeatedly, through the SPI bus), and the detection of tags is done
+ * by MFRC522::PICC_IsNewCardPresent(), that also waits (polling) for the answer of the
+ * tags, or the timeout (25ms) if there is no tag.
+ * 
+ * In the IRQ mode, the IRQ pin of the MFRC522 is connected to an interrupt pin of the 
+ * board. The MFRC522 is configured to activate the pin (low level) at the end of the
+ * commands (reception, idle state or timeout), and the interrupt handler just sets a 
+ * flag. Then:
+ * - the block reads/writes wait for the flag, with no traffic in the SPI bus, and read
+ *   the result of the command only once;
+ * - detectTag() doesn't block: it sends a request (REQA) to the tags and returns; the 
+ *   answer (or the timeout, after which a new request is sent) is handled in a later 
+ *   call, when the flag is set. So, the application may sleep (or do other tasks) while
+ *   no tag is present, and call detectTag() as soon as isIrqPending() returns true.
+ * 
+ * Only one instance of the class may use the IRQ mode at a time. The function signalIrq()
+ * does the same as the interrupt handler; it may be called to simulate the IRQ (e.g. in 
+ * tests, or in boards where the IRQ pin is read by other means).
+ */
+
+#if defined(ESP8266) || defined(ESP32)
+  #define IRQ_HANDLER_ATTR IRAM_ATTR   // interrupt handlers must be in RAM
+#else
+  #define IRQ_HANDLER_ATTR
+#endif
+
+EasyMFRC522* EasyMFRC522::irqInstance = NULL;
+
+void IRQ_HANDLER_ATTR EasyMFRC522::_irqHandler() {
+  if (irqInstance != NULL) {
+    irqInstance->irqFlag = true;
+  }
+}
+
+void EasyMFRC522::signalIrq() {
+  this->irqFlag = true;
+}
+
+/**
+ * Enables the IRQ mode, where the given pin (connected to the IRQ pin of the MFRC522) 
+ * signals the end of the commands. Must be called after init().
+ * 
+ * Returns false if the pin is not an interrupt pin, or if another instance uses the IRQ mode.
+ */
+bool EasyMFRC522::enableIrq(byte pin) {
+  int interrupt = digitalPinToInterrupt(pin);
+  if (interrupt < 0 || (irqInstance != NULL && irqInstance != this)) {
+    return false;
+  }
+
+  irqInstance = this;
+  this->irqPin = pin;
+  this->irqFlag = false;
+  this->requestPending = false;
+
+  pinMode(pin, INPUT_PULLUP);
+  _pcdWriteRegister(MFRC522::DivIEnReg, 0x80);                // IRQPushPull: the pin is driven in both levels
+  _pcdWriteRegister(MFRC522::ComIEnReg, 0x80 | 0x20 | 0x10 | 0x01);  // IRqInv (active low), RxIEn, IdleIEn, TimerIEn
+  _pcdWriteRegister(MFRC522::ComIrqReg, 0x7F);                // clears all interrupt request bits
+  attachInterrupt(interrupt, _irqHandler, FALLING);
+  return true;
+}
+
+void EasyMFRC522::disableIrq() {
+  if (! isIrqEnabled()) {
+    return;
+  }
+  detachInterrupt(digitalPinToInterrupt(this->irqPin));
+  _pcdWriteRegister(MFRC522::CommandReg, MFRC522::PCD_Idle);  // cancels a pending request
+  _pcdWriteRegister(MFRC522::ComIEnReg, 0x80);                // reset value: no interrupt enabled
+  this->irqPin = EASY_MFRC522_NO_IRQ;
+  this->requestPending = false;
+  if (irqInstance == this) {
+    irqInstance = NULL;
+  }
+}
+
+// Sends REQA, but doesn't wait for the answer (see detectTag()). The same as done by
+// MFRC522::PICC_IsNewCardPresent(), with the timer of the MFRC522 started automatically.
+void EasyMFRC522::_startRequestA() {
+  const byte request = MFRC522::PICC_CMD_REQA;
+
+  _pcdWriteRegister(MFRC522::TxModeReg, 0x00);                // resets the baud rates
+  _pcdWriteRegister(MFRC522::RxModeReg, 0x00);
+  _pcdWriteRegister(MFRC522::ModWidthReg, 0x26);
+  _pcdWriteRegister(MFRC522::CollReg, 0x00);                  // ValuesAfterColl=0: bits received after a collision are cleared
+  _pcdWriteRegister(MFRC522::CommandReg, MFRC522::PCD_Idle);
+  _pcdWriteRegister(MFRC522::ComIrqReg, 0x7F);
+  this->irqFlag = false;
+  _pcdWriteRegister(MFRC522::FIFOLevelReg, 0x80);
+  _pcdWriteRegister(MFRC522::FIFODataReg, 1, &request);
+  _pcdWriteRegister(MFRC522::CommandReg, MFRC522::PCD_Transceive);
+  _pcdWriteRegister(MFRC522::BitFramingReg, 0x87);            // StartSend=1, only 7 bits of the byte (short frame)
+
+  this->requestPending = true;
+  this->requestStart = millis();
+}
+
+// Waits for the interrupt, yielding the processor (e.g. to other tasks, in Esp8266).
+bool EasyMFRC522::_waitIrq(unsigned long timeoutMillis) {
+  unsigned long start = millis();
+  while (! this->irqFlag) {
+    if (millis() - start > timeoutMillis) {
+      return false;
+    }
+    yield();
+  }
+  return true;
+}
+
+
+//////////////////////////////////////////////////////
+////////// READ/WRITE LABELED DATA (files) ///////////
+
+/*
+ * The first block of a file (its header) has:
+ * 
+ *   byte  0     : 0x1C (ASCII FILE SEPARATOR), or 0x1E (ASCII RECORD SEPARATOR) if the file has flags
+ *   bytes 1-12  : label, completed with 0s
+ *   byte  13    : flags (only if byte 0 is 0x1E; it was not set by older versions of this class)
+ *   bytes 14-15 : size of the data, little-endian
+ * 
+ * The data is written from the next block on. But, in an encrypted file (flag 
+ * EASY_MFRC522_FILE_ENCRYPTED), the next block holds 8 random bytes (that are part of the
+ * nonce) and the 8-byte authentication tag, and the encrypted data comes after it.
+ * 
+ * The encryption uses AES-128 in CCM mode (see RfidCipher), that also authenticates the
+ * data and the bytes 1-13 of the header. The nonce includes the first bytes of the UID,
+ * so that an encrypted file cannot be copied to another tag. Each block is encrypted 
+ * (or decrypted) when it is written to (or read from) the tag, so no extra copy of the
+ * data is needed.
+ * 
+ * In a file with parity (flag EASY_MFRC522_FILE_PARITY, with the size G of the groups in
+ * the 4 high bits of the flags), each group of G data blocks is followed by a parity block,
+ * which is the XOR of the blocks of the group (the last group may have less blocks):
+ * 
+ *   header | D0 D1 .. D(G-1) P0 | DG .. D(2G-1) P1 | ...
+ * 
+ * When reading, each data block is read only once. If one block of a group fails (e.g. 
+ * a CRC error, in a tag at the edge of the field), it is rebuilt from the parity and the
+ * other blocks of the group, instead of being read again. The parity block is only read 
+ * in this case. Only if more than one block of a group fails, they are read again, as 
+ * usual. The space used is 1 block for each G data blocks. Files with parity cannot be
+ * encrypted (the encryption takes precedence, if both are set).
+ * 
+ * If the packing is enabled (see setFilePacking()), a file of 1 or 2 bytes (not encrypted)
+ * is kept in the header block itself: it has the flag EASY_MFRC522_FILE_INLINE, with the 
+ * size in the 4 high bits of the flags, and the data in bytes 14-15 (instead of the size).
+ * So, it is written with a single block write, and read with a single block read.
+ */
+
+// Fills the first block of a file (see the layout above).
+void EasyMFRC522::fillFileHeader(byte header[16], const char dataLabel[12], byte flags, int dataSize) {
+  header[0] = (flags == 0)? 0x1C : 0x1E;
+  bool ended = false;
+  for (int i = 0; i < 12; i ++) {
+    ended = ended || (dataLabel[i] == '\0');
+    header[i+1] = ended? '\0' : dataLabel[i];
+  }
+  header[13] = flags;
+  header[14] = byte(dataSize);
+  header[15] = byte(dataSize >> 8);
+}
+
+static void fillNonce(byte nonce[13], const byte randomPart[8], const MFRC522::Uid& uid) {
+  for (byte i = 0; i < 8; i ++) {
+    nonce[i] = randomPart[i];
+  }
+  for (byte i = 0; i < 5; i ++) {
+    nonce[8+i] = (i < uid.size)? uid.uidByte[i] : 0;
+  }
+}
+
+/*
+ * NONCES
+ * 
+ * The 8 random bytes of the nonce of an encrypted file must never repeat for the same key:
+ * two files with the same nonce reveal the XOR of their data, and allow forging their tags.
+ * If a source was given with setNonceSource() (e.g. a counter kept in EEPROM, or an external
+ * generator), it is used. Otherwise, the ESP32 and the ESP8266 use their hardware random
+ * number generators.
+ * 
+ * The other boards have no hardware generator, and random() gives the same sequence after
+ * each reset. So, in the first encrypted write, a pool of 64 bits is collected from the 
+ * analog noise of EASY_MFRC522_ENTROPY_PIN (which must be left unconnected), mixed with the
+ * timing of the reads. Each nonce is the pool and a counter, encrypted with the file cipher:
+ * the nonces of the same run never repeat, and the ones of different runs repeat only if 
+ * their pools do. If there is no floating analog pin, give a source with setNonceSource().
+ */
+
+#if !defined(ESP32) && !defined(ESP8266)
+static uint32_t noisePool[2];
+static uint32_t nonceCounter = 0;
+static bool noiseCollected = false;
+
+static void collectNoise() {
+  for (int i = 0; i < 128; i ++) {
+    uint32_t sample = (uint32_t)analogRead(EASY_MFRC522_ENTROPY_PIN) ^ micros();
+    uint32_t& word = noisePool[i & 1];
+    word = ((word << 5) | (word >> 27)) ^ sample;  // spreads the noisy low bits of the samples
+  }
+  noiseCollected = true;
+}
+#endif
+
+void EasyMFRC522::_fillNonceRandom(byte randomPart[8]) {
+  if (this->nonceSource != NULL) {
+    this->nonceSource(randomPart, this->nonceContext);
+    return;
+  }
+#if defined(ESP32) || defined(ESP8266)
+  for (int i = 0; i < 8; i += 4) {
+  #if defined(ESP32)
+    uint32_t r = esp_random();    // hardware random number generator
+  #else
+    uint32_t r = RANDOM_REG32;    // hardware random number generator
+  #endif
+    memcpy(randomPart + i, &r, 4);
+  }
+#else
+  if (! noiseCollected) {
+    collectNoise();
+  }
+  byte block[16];
+  uint32_t now = micros();
+  memcpy(block, noisePool, 8);
+  memcpy(block + 8, &nonceCounter, 4);
+  memcpy(block + 12, &now, 4);
+  nonceCounter ++;
+  this->fileCipher->encryptBlock(block, block);
+  memcpy(randomPart, block, 8);
+#endif
+}
+
+// Source/sink that encrypts/decrypts the data of another source/sink
+struct CipherStream {
+  RfidCipher* cipher;
+  RfidDataSource source;
+  RfidDataSink sink;
+  void* context;
+  const byte* header;
+  const MFRC522::Uid* uid;
+  byte nonceAndTag[16];
+};
+
+static int encryptFromSource(byte* chunk, int position, int length, void* context) {
+  CipherStream* stream = (CipherStream*)context;
+  int result = stream->source(chunk, position, length, stream->context);
+  if (result >= 0) {
+    stream->cipher->encrypt(chunk, length);
+  }
+  return result;
+}
+
+static int decryptToSink(const byte* chunk, int position, int length, void* context) {
+  CipherStream* stream = (CipherStream*)context;
+  if (position == 0) {  // the block with the nonce and the tag
+    memcpy(stream->nonceAndTag, chunk, 16);
+    byte nonce[13];
+    fillNonce(nonce, stream->nonceAndTag, *stream->uid);
+    int dataSize = ((unsigned int)stream->header[15] << 8) | (unsigned int)stream->header[14];
+    stream->cipher->begin(nonce, stream->header + 1, 13, dataSize);
+    return 0;
+  }
+  byte plain[16];
+  memcpy(plain, chunk, length);
+  stream->cipher->decrypt(plain, length);
+  return stream->sink(plain, position - 16, length, stream->context);
+}
+
+/**
+ * Writes the data with the given label, starting in the given block. If a cipher was set
+ * with setFileCipher(), the data is encrypted (see the comments above). With the packing
+ * enabled, data of 1 or 2 bytes is written inside the header.
+ * 
+ * Returns: negative number -- error
+ *          positive number -- last block written
+ */
+int EasyMFRC522::writeFile(byte initialBlock, const char dataLabel[12], byte* data, int dataSize) {
+  return writeFileStream(initialBlock, dataLabel, dataSize, copyFromArray, data);
+}
+
+// Same as writeFile(), but the data is read from the input (e.g. Serial), at most 16 bytes 
+// at a time.
+int EasyMFRC522::writeFile(byte initialBlock, const char dataLabel[12], Stream& input, int dataSize) {
+  return writeFileStream(initialBlock, dataLabel, dataSize, copyFromStream, &input);
+}
+
+// Same as writeFile(), but the data is given by the source, one block at a time (see 
+// writeRawStream()).
+int EasyMFRC522::writeFileStream(byte initialBlock, const char dataLabel[12], int dataSize, RfidDataSource source, void* context) {
+  byte header[16];
+  byte flags = 0;
+  if (dataSize < 0) {
+    dataSize = 0;
+  }
+
+  if (this->fileCipher != NULL) {
+    flags = EASY_MFRC522_FILE_ENCRYPTED;
+  } else if (this->filePacking && dataSize > 0 && dataSize <= 2) {
+    flags = EASY_MFRC522_FILE_INLINE | (dataSize << 4);
+  } else if (this->fileParityGroup > 0) {
+    flags = EASY_MFRC522_FILE_PARITY | (this->fileParityGroup << 4);
+  }
+
+  fillFileHeader(header, dataLabel, flags, dataSize);
+  if (flags & EASY_MFRC522_FILE_INLINE) {
+    byte chunk[16];
+    if (source(chunk, 0, dataSize, context) < 0) {
+      return -2620;
+    }
+    header[14] = chunk[0];
+    header[15] = (dataSize == 2)? chunk[1] : 0;
+  }
+
+  // not through writeRaw(): its resume logic would discard the record of the data, below
+  int lastBlockUsed = _writeRawStream(initialBlock, 16, copyFromArray, header, 0, NULL);
+  if (lastBlockUsed < 0) {
+    //the message should already have been printed by writeRaw, so just return the error code
+    return -2000 + lastBlockUsed; // error code (see comment in the end of this file)
+  }
+
+  if (flags & EASY_MFRC522_FILE_INLINE) {
+    return lastBlockUsed;  // the data is already in the header
+  } else if (flags & EASY_MFRC522_FILE_ENCRYPTED) {
+    return _writeEncryptedFile(lastBlockUsed, header, source, context);
+  } else if (flags & EASY_MFRC522_FILE_PARITY) {
+    return _writeParityFile(lastBlockUsed, dataSize, this->fileParityGroup, source, context);
+  }
+
+  // the data given in an array (by writeFile()) may be resumed, as in writeRaw()
+  int status = (source == copyFromArray)? _writeRawResumable(RFID_RESUME_WRITE_FILE, lastBlockUsed+1, (byte*)context, dataSize)
+                                        : this->writeRawStream(lastBlockUsed+1, dataSize, source, context);
+  if (status < 0) {
+    return -2500 + status;        // error code (see comment in the end of this file)
+  }
+
+  return status;
+}
+
+// Writes the encrypted data and, then, the block with the nonce and the tag (so, a write 
+// interrupted in the middle leaves a file that fails the authentication).
+int EasyMFRC522::_writeEncryptedFile(int headerBlock, const byte header[16], RfidDataSource source, void* context) {
+  int dataSize = ((unsigned int)header[15] << 8) | (unsigned int)header[14];
+  int cryptoBlock = getBlockOfOffset(headerBlock + 1, 0);
+  if (cryptoBlock < 0) {
+    dbgPrintln("Error writeFile(): not enough space");
+    return -2600;
+  }
+
+  CipherStream stream;
+  stream.cipher = this->fileCipher;
+  stream.source = source;
+  stream.context = context;
+  stream.header = header;
+  stream.uid = &this->device.uid;
+  _fillNonceRandom(stream.nonceAndTag);
+
+  byte nonce[13];
+  fillNonce(nonce, stream.nonceAndTag, this->device.uid);
+  this->fileCipher->begin(nonce, header + 1, 13, dataSize);
+
+  int lastBlock = cryptoBlock;
+  if (dataSize > 0) {
+    lastBlock = writeRawStream(cryptoBlock + 1, dataSize, encryptFromSource, &stream);
+    if (lastBlock < 0) {
+      return -2500 + lastBlock;
+    }
+  }
+
+  this->fileCipher->finish(stream.nonceAndTag + 8);
+  int status = this->writeRaw(cryptoBlock, stream.nonceAndTag, 16);
+  if (status < 0) {
+    return -2700 + status;
+  }
+
+  return lastBlock;
+}
+
+// Source that gives the data of another source, with a parity block after each group.
+struct ParityStream {
+  RfidDataSource source;
+  void* context;
+  int dataSize;
+  int dataBlocks;
+  byte groupSize;
+  byte parity[16];
+};
+
+static int encodeWithParity(byte* chunk, int position, int length, void* context) {
+  ParityStream* stream = (ParityStream*)context;
+  int index = (position / 16) % (stream->groupSize + 1);     // index of the block in its group
+  int dataBlock = (position / 16) / (stream->groupSize + 1) * stream->groupSize + index;
+
+  if (index == 0) {
+    memset(stream->parity, 0, 16);
+  }
+  if (index == stream->groupSize || dataBlock >= stream->dataBlocks) {
+    memcpy(chunk, stream->parity, 16);  // end of the group
+    return 0;
+  }
+
+  int bytes = stream->dataSize - 16 * dataBlock;
+  memset(chunk, 0, 16);
+  int result = stream->source(chunk, 16 * dataBlock, (bytes < 16)? bytes : 16, stream->context);
+  for (byte i = 0; i < 16; i ++) {
+    stream->parity[i] ^= chunk[i];
+  }
+  return result;
+}
+
+int EasyMFRC522::_writeParityFile(int headerBlock, int dataSize, byte groupSize, RfidDataSource source, void* context) {
+  if (dataSize == 0) {
+    return headerBlock;
+  }
+
+  ParityStream stream;
+  stream.source = source;
+  stream.context = context;
+  stream.dataSize = dataSize;
+  stream.dataBlocks = (dataSize + 15) / 16;
+  stream.groupSize = groupSize;
+
+  int totalBlocks = stream.dataBlocks + (stream.dataBlocks + groupSize - 1) / groupSize;
+  int status = writeRawStream(headerBlock + 1, 16 * totalBlocks, encodeWithParity, &stream);
+  if (status < 0) {
+    return -2500 + status;
+  }
+  return status;
+}
+
+// Reads the block, trying up to the given number of times (with new authentications).
+MFRC522::StatusCode EasyMFRC522::_readBlockTrials(int blockAddr, byte* output, int trials) {
+  MFRC522::StatusCode status = MFRC522::STATUS_ERROR;
+  for (int i = 0; i < trials; i ++) {
+    status = _authenticate(blockAddr);  // only when the sector changes, or after a failure
+    if (status == MFRC522::STATUS_OK) {
+      status = _mifareRead(blockAddr, blockBuffer);
+    }
+    if (status == MFRC522::STATUS_OK) {
+      memcpy(output, blockBuffer, 16);
+      break;
+    }
+  }
+  return status;
+}
+
+// Reads the data of a file with parity, group by group (see the comments above).
+int EasyMFRC522::_readParityFile(int headerBlock, int dataSize, byte groupSize, RfidDataSink sink, void* context) {
+  byte group[EASY_MFRC522_MAX_PARITY_GROUP][16];
+  byte parity[16];
+  int dataBlocks = (dataSize + 15) / 16;
+  int offset = 0;  // position of the current group in the file (with the parity blocks)
+
+  for (int first = 0; first < dataBlocks; first += groupSize) {
+    int count = (dataBlocks - first < groupSize)? dataBlocks - first : groupSize;
+    int failed = -1;
+
+    for (int i = 0; i < count; i ++) {
+      int block = getBlockOfOffset(headerBlock + 1, offset + 16 * i);
+      if (block < 0) {
+        return -1041;
+      }
+      if (_readBlockTrials(block, group[i], 1) != MFRC522::STATUS_OK) {
+        if (failed < 0) {
+          failed = i;  // may be rebuilt
+        } else if (_readBlockTrials(block, group[i], READ_WRITE_TRIALS) != MFRC522::STATUS_OK) {
+          dbgPrintln("Error in readFile(): could not read (nor rebuild) the block");
+          return -1040;
+        }
+      }
+    }
+
+    if (failed >= 0) {
+      int parityBlock = getBlockOfOffset(headerBlock + 1, offset + 16 * count);
+      int failedBlock = getBlockOfOffset(headerBlock + 1, offset + 16 * failed);
+      if (parityBlock >= 0 && _readBlockTrials(parityBlock, parity, READ_WRITE_TRIALS) == MFRC522::STATUS_OK) {
+        for (int i = 0; i < count; i ++) {
+          if (i != failed) {
+            for (byte j = 0; j < 16; j ++) {
+              parity[j] ^= group[i][j];
+            }
+          }
+        }
+        memcpy(group[failed], parity, 16);
+        this->stats.blocksRecovered ++;
+      } else if (_readBlockTrials(failedBlock, group[failed], READ_WRITE_TRIALS) != MFRC522::STATUS_OK) {
+        dbgPrintln("Error in readFile(): could not read (nor rebuild) the block");
+        return -1040;
+      }
+    }
+
+    for (int i = 0; i < count; i ++) {
+      int position = 16 * (first + i);
+      int bytes = (dataSize - position < 16)? dataSize - position : 16;
+      if (sink(group[i], position, bytes, context) < 0) {
+        return -1000 - 122;
+      }
+    }
+    offset += 16 * (count + 1);
+  }
+
+  return dataSize;
+}
+
+/**
+ * Reads the identification block, checking if it is properly identified with the given 
+ * data label, then parses and returns the size of the data stored in the remaining blocks.
+ * 
+ * Returns: negative number -- error
+ *          positive number -- the size of the data stored (starting from the next block, not counting trailling blocks)
+ */
+int EasyMFRC522::readFileSize(int initialBlock, const char dataLabel[12]) {
+  return _readFileHeader(initialBlock, dataLabel, NULL);
+}
+
+// Same as readFileSize(), also giving the flags of the file.
+int EasyMFRC522::_readFileHeader(int initialBlock, const char dataLabel[12], byte* flagsOut) {
+  MFRC522::StatusCode status = MFRC522::STATUS_ERROR;
+
+  if (_isTrailerBlock(initialBlock)) { //it is a trailer block --> go to the next one
+    initialBlock ++;
+  }
+
+  RfidPrefetchEntry* cached = _findPrefetched(initialBlock, dataLabel);
+  if (cached != NULL) {
+    if (flagsOut != NULL) {
+      *flagsOut = cached->flags;
+    }
+    return cached->size;
+  }
+
+  status = this->_authenticate(initialBlock);
+  if (status != MFRC522::STATUS_OK) {
+    dbgPrintln("Error readFileSize(): could not authenticate");
+    return -8;
+  }
+
+  for (int i = 0; i < READ_WRITE_TRIALS; i ++) {
+    status = this->_mifareRead(initialBlock, blockBuffer);
+    if (status == MFRC522::STATUS_OK) {
+      break;
+    }
+  }
+  if (status != MFRC522::STATUS_OK) {
+    dbgPrintln("Error readFileSize(): could not read");
+    return -9;
+  }
+
+  if (blockBuffer[0] != 0x1C && blockBuffer[0] != 0x1E) {
+    dbgPrintln("Error readFileSize(): this block does not start a file");
+    return -10;
+  }
+  
+  // checks if all characters of the data label matches, including the final \0
+  // if the label has more than 12 chars, only the first 12 chars are considered
+  for (int i = 0; i < 12; i++) {
+    if (dataLabel[i] != blockBuffer[i+1]) {
+      dbgPrintln("Error readFileSize(): data label doesn't match");
+      return -11;
+    }
+    if (dataLabel[i] == '\0')  //in this situation, we have already confirmed that blockBuffer[i+1] == '\0' in the "if" above
+      break;
+  }
+
+  byte flags = (blockBuffer[0] == 0x1E)? blockBuffer[13] : 0;
+  if (flagsOut != NULL) {
+    *flagsOut = flags;
+  }
+  if (flags & EASY_MFRC522_FILE_INLINE) {
+    return flags >> 4;  // the header is kept in blockBuffer, for _readFile()
+  }
+
+  int dataSize = ((unsigned int)blockBuffer[15] << 8) | (unsigned int)blockBuffer[14];
+  return dataSize;
+}
 
 int EasyMFRC522::readFile(byte initialBlock, const char dataLabel[12], byte* dataOut, int dataOutCapacity) {
-  if (initialBlock % 4 == 3) { //it is a sector's trailing block --> go to the next (attention: this is done in readFileSize(), but should be kept here too, because of special cases, e.g. initialBlock = 3) and these functions are called successively)
+  int status = _readFile(initialBlock, dataLabel, copyToArray, dataOut, dataOutCapacity);
+  if (status == -1030) {
+    memset(dataOut, 0, dataOutCapacity);  // no unauthenticated data is given to the caller
+  }
+  return status;
+}
+
+// Same as readFile(), but the data is written to the output (e.g. Serial) as it is read.
+// Attention: in encrypted files, the data is only authenticated at the end (see readFileStream()).
+int EasyMFRC522::readFile(byte initialBlock, const char dataLabel[12], Print& output) {
+  return _readFile(initialBlock, dataLabel, copyToPrint, &output, 0x7FFF);
+}
+
+/**
+ * Same as readFile(), but the data is given to the sink, one block at a time (see 
+ * readRawStream()), with no need of a buffer for the whole data.
+ * 
+ * Attention: in encrypted files, the sink receives the data decrypted before it is 
+ * authenticated (which is possible only at the end). If the error -1030 is returned,
+ * the data given to the sink must be discarded.
+ * 
+ * Returns: negative number -- error
+ *          positive number -- the size of the data
+ */
+int EasyMFRC522::readFileStream(byte initialBlock, const char dataLabel[12], RfidDataSink sink, void* context) {
+  return _readFile(initialBlock, dataLabel, sink, context, 0x7FFF);
+}
+
+int EasyMFRC522::_readFile(byte initialBlock, const char dataLabel[12], RfidDataSink sink, void* context, int capacity) {
+  if (_isTrailerBlock(initialBlock)) { //it is a sector's trailing block --> go to the next (attention: this is done in readFileSize(), but should be kept here too, because of special cases, e.g. initialBlock = 3) and these functions are called successively)
     initialBlock ++;
   }
 
-  int dataSize = this->readFileSize(initialBlock, dataLabel);
+  byte flags = 0;
+  int dataSize = this->_readFileHeader(initialBlock, dataLabel, &flags);
   if (dataSize < 0) {
     return -1000 + dataSize; // error code (see comment in the end of this file)
-  } else if ((int)dataOutCapacity < dataSize) {
+  } else if (capacity < dataSize) {
     dbgPrintln("Error in readFile(): not enough room in the given output buffer");
     return -1020;
   }
   dbgPrint(" -- data size: "); dbgPrintln(dataSize);
 
-  int status = this->readRaw(initialBlock+1, dataOut, dataSize);
+  if (flags & EASY_MFRC522_FILE_ENCRYPTED) {
+    byte header[16];
+    fillFileHeader(header, dataLabel, flags, dataSize);
+    return _readEncryptedFile(initialBlock, header, sink, context);
+  } else if (flags & EASY_MFRC522_FILE_PARITY) {
+    byte groupSize = flags >> 4;
+    if (groupSize == 0 || groupSize > EASY_MFRC522_MAX_PARITY_GROUP || (flags & 0x0C) != 0) {
+      dbgPrintln("Error in readFile(): unknown flags");
+      return -1032;
+    }
+    return _readParityFile(initialBlock, dataSize, groupSize, sink, context);
+  } else if (flags & EASY_MFRC522_FILE_INLINE) {
+    if (dataSize > 2 || (flags & 0x0B) != 0) {
+      dbgPrintln("Error in readFile(): unknown flags");
+      return -1032;
+    }
+    return _readInlineFile(initialBlock, dataLabel, dataSize, sink, context);
+  } else if (flags != 0) {
+    dbgPrintln("Error in readFile(): unknown flags");
+    return -1032;
+  }
+
+#if EASY_MFRC522_ENABLE_PREFETCH
+  RfidPrefetchEntry* cached = _findPrefetched(initialBlock, dataLabel);
+  if (cached != NULL && cached->state == PREFETCH_PAYLOAD) {
+    int result = sink(this->prefetchBuffer + cached->offset, 0, dataSize, context);  // a single chunk
+    return (result < 0)? -1000 - 122 : dataSize;
+  }
+#endif
+
+  int status = this->readRawStream(initialBlock+1, dataSize, sink, context);
   if (status < 0) { 
     return -1000 + status; // error code (see comment in the end of this file)
   }
@@ -517,6 +2694,205 @@ int EasyMFRC522::readFile(byte initialBlock, const char dataLabel[12], byte* dat
   return status;
 }
 
+// Gives the data kept in the header, which is in blockBuffer (just read by _readFileHeader()), 
+// unless the header came from the prefetch list.
+int EasyMFRC522::_readInlineFile(int initialBlock, const char dataLabel[12], int dataSize, RfidDataSink sink, void* context) {
+  const byte* data = blockBuffer + 14;
+
+#if EASY_MFRC522_ENABLE_PREFETCH
+  byte header[16];
+  RfidPrefetchEntry* cached = _findPrefetched(initialBlock, dataLabel);
+  if (cached != NULL && cached->state == PREFETCH_PAYLOAD) {
+    data = this->prefetchBuffer + cached->offset;
+  } else if (cached != NULL) {
+    int status = readRaw(initialBlock, header, 16);
+    if (status < 0) {
+      return -1000 + status;
+    }
+    data = header + 14;
+  }
+#endif
+
+  if (dataSize > 0 && sink(data, 0, dataSize, context) < 0) {
+    return -1000 - 122;
+  }
+  return dataSize;
+}
+
+// Reads and decrypts the data, checking the authentication tag at the end.
+int EasyMFRC522::_readEncryptedFile(int initialBlock, const byte header[16], RfidDataSink sink, void* context) {
+  if (this->fileCipher == NULL) {
+    dbgPrintln("Error in readFile(): the file is encrypted, but no cipher was given");
+    return -1031;
+  }
+
+  int dataSize = ((unsigned int)header[15] << 8) | (unsigned int)header[14];
+  CipherStream stream;
+  stream.cipher = this->fileCipher;
+  stream.sink = sink;
+  stream.context = context;
+  stream.header = header;
+  stream.uid = &this->device.uid;
+
+  int status = readRawStream(initialBlock+1, 16 + dataSize, decryptToSink, &stream);
+  if (status < 0) {
+    return -1000 + status;
+  }
+
+  byte tag[8];
+  byte difference = 0;
+  this->fileCipher->finish(tag);
+  for (byte i = 0; i < 8; i ++) {
+    difference |= tag[i] ^ stream.nonceAndTag[8+i];
+  }
+  if (difference != 0) {
+    dbgPrintln("Error in readFile(): authentication failed");
+    return -1030;
+  }
+
+  return dataSize;
+}
+
+
+///////////////////////////////////////////////////
+////////////////// PACKED VALUES //////////////////
+
+/*
+ * A packed block holds several tiny labeled values (e.g. a level, a flag, a small counter),
+ * which would need 2 blocks each as files. It starts with 0x1D (ASCII GROUP SEPARATOR), 
+ * followed by the entries, each one with:
+ * 
+ *   1 byte      : length of the label (4 high bits) and size of the value (4 low bits)
+ *   n bytes     : label (1 to 12 chars, without the final \0)
+ *   m bytes     : value (0 to 13 bytes, as the label has at least 1 char)
+ * 
+ * A byte 0 (or the end of the block) ends the list. So, the block has 15 bytes for the 
+ * entries, e.g. 3 values of 1 byte with labels of 3 chars. Each value is read with a 
+ * single block read. Writing a value reads the block, replaces (or adds) the entry of 
+ * the label and writes it back, if it has changed.
+ * 
+ * The container is always a single block: when the entries don't fit in it, the write
+ * fails with -712 (no room), and the other values should go to another packed block. 
+ * (A container spanning several blocks would not keep the single read per value.)
+ */
+
+#define PACKED_BLOCK_MARK  0x1D
+
+// Gives the position of the entry with the label in the packed block (or -1), and the 
+// position where the entries end.
+static int findPackedEntry(const byte content[16], const char* label, byte labelLength, int* endOut) {
+  int found = -1;
+  int position = 1;
+  while (position < 16 && content[position] != 0) {
+    byte length = content[position] >> 4;
+    byte size = content[position] & 0x0F;
+    if (position + 1 + length + size > 16) {
+      break;  // a broken entry is considered the end
+    }
+    if (length == labelLength && memcmp(content + position + 1, label, length) == 0) {
+      found = position;
+    }
+    position += 1 + length + size;
+  }
+  *endOut = position;
+  return found;
+}
+
+/**
+ * Writes the value (0 to 13 bytes) with the given label in the packed block, keeping the 
+ * other values of the block. If the block is not a packed block, it is overwritten with a
+ * new one. The block 0 is rejected (it holds the UID and the data of the manufacturer).
+ * 
+ * Returns: negative number -- error
+ *          positive number -- the block written
+ */
+int EasyMFRC522::writePackedValue(int block, const char* label, const byte* value, byte valueSize) {
+  if (block == 0) {
+    dbgPrintln("Error writePackedValue(): block 0 cannot be a packed block");
+    return -713;
+  }
+  byte labelLength = strnlen(label, 13);
+  if (labelLength == 0 || labelLength > 12 || 1 + labelLength + valueSize > 15) {
+    dbgPrintln("Error writePackedValue(): invalid size of label or value");
+    return -711;
+  }
+
+  byte content[16];
+  int status = readRaw(block, content, 16);
+  if (status < 0) {
+    return -1100 + status;
+  }
+  if (content[0] != PACKED_BLOCK_MARK) {
+    memset(content, 0, 16);
+    content[0] = PACKED_BLOCK_MARK;
+  }
+
+  // builds the new content, without the old entry of the label
+  byte packed[16] = { 0 };
+  int end;
+  int found = findPackedEntry(content, label, labelLength, &end);
+  int used = end;
+  memcpy(packed, content, end);
+  if (found >= 0) {
+    int entrySize = 1 + (content[found] >> 4) + (content[found] & 0x0F);
+    memmove(packed + found, packed + found + entrySize, end - found - entrySize);
+    used -= entrySize;
+    memset(packed + used, 0, 16 - used);
+  }
+
+  if (used + 1 + labelLength + valueSize > 16) {
+    dbgPrintln("Error writePackedValue(): no room in the block");
+    return -712;
+  }
+  packed[used] = (labelLength << 4) | valueSize;
+  memcpy(packed + used + 1, label, labelLength);
+  memcpy(packed + used + 1 + labelLength, value, valueSize);
+
+  if (memcmp(packed, content, 16) == 0) {
+    return getBlockOfOffset(block, 0);  // already in the tag
+  }
+  status = writeRaw(block, packed, 16);
+  if (status < 0) {
+    return -1300 + status;
+  }
+  return status;
+}
+
+/**
+ * Reads the value (0 to 13 bytes) with the given label from the packed block, with a single 
+ * block read.
+ * 
+ * Returns: negative number -- error
+ *          positive number -- the size of the value
+ */
+int EasyMFRC522::readPackedValue(int block, const char* label, byte* valueOut, int valueOutCapacity) {
+  byte content[16];
+  int status = readRaw(block, content, 16);
+  if (status < 0) {
+    return -700 + status;
+  }
+  if (content[0] != PACKED_BLOCK_MARK) {
+    dbgPrintln("Error readPackedValue(): this block is not a packed block");
+    return -701;
+  }
+
+  int end;
+  byte labelLength = strnlen(label, 13);
+  int found = findPackedEntry(content, label, labelLength, &end);
+  if (found < 0) {
+    dbgPrintln("Error readPackedValue(): label not found");
+    return -702;
+  }
+
+  byte size = content[found] & 0x0F;
+  if (size > valueOutCapacity) {
+    dbgPrintln("Error readPackedValue(): not enough room in the given output buffer");
+    return -703;
+  }
+  memcpy(valueOut, content + found + 1 + labelLength, size);
+  return size;
+}
+
 
 /**
  * -----------
@@ -540,17 +2916,56 @@ int EasyMFRC522::readFile(byte initialBlock, const char dataLabel[12], byte* dat
  * readFileSize ->
  * -8 | -9 | -10 | -11
  * 
+ * diagnostics only (see popDiagnostic()) ->
+ * -12 (authentication failed) | -13 (communication failure with the MFRC522, in init())
+ * 
  * readRaw (unlabelled) ->
- * -120 | -121 | (-100 + _readBlock)
+ * -120 | -121 | -122 | (-100 + _readBlock)
  * 
  * writeRaw (unlabelled) ->
- * -220 | -221 | (-200 + _writeBlockAndVerify) 
+ * -220 | -221 | -222 | -223 | (-200 + _writeBlockAndVerify) 
+ * 
+ * formatValueBlock ->
+ * -300 | -301 | (-310 + _writeBlockAndVerify)
+ * 
+ * readValue ->
+ * -321 | -322 | -323
+ * 
+ * incrementValue, decrementValue ->
+ * -330 | -331 | -332 | -333
+ * 
+ * restoreValue ->
+ * -341 | -342
+ * 
+ * transferValue ->
+ * -352
+ * 
+ * processTags (result of each tag) ->
+ * -401 | -402 | (result of the operation)
+ * 
+ * parseTrace ->
+ * -500
+ * 
+ * applyImage ->
+ * -601 | -602 | -603 | (-610 + _verifyBlock)
+ * 
+ * executeBatch (result of each request) ->
+ * -902 | -903 | -904 | (-910 + _readBlock) | (-920 + _writeBlockAndVerify)
+ * 
+ * RfidBatch::addRead, addWrite, addWriteFile ->
+ * -901
+ * 
+ * readPackedValue ->
+ * -701 | -702 | -703 | (-700 + readRaw)
+ * 
+ * writePackedValue ->
+ * -711 | -712 | -713 | (-1100 + readRaw) | (-1300 + writeRaw)
  * 
  * readFile ->
- * -1020 | (-1000 + readFileSize) | readRaw
+ * -1020 | -1030 | -1031 | -1032 | -1040 | -1041 | (-1000 + readFileSize) | (-1000 + readRaw)
  * 
  * writeFile ->
- * (-2000 + writeRaw) | (-2500 + writeRaw)
+ * (-2000 + writeRaw) | (-2500 + writeRaw) | -2600 | -2620 | (-2700 + writeRaw)
  * 
  * Because some functions may call others, and one function may be
  * called in multiple places, we used a combination of values that
@@ -2,7 +2,9 @@
 #ifndef __EASY_MFRC522_H__
 #define __EASY_MFRC522_H__
 
+#include <SPI.h>
 #include <MFRC522.h>
+#include "EasyMFRC522Config.h"
 
 /**
  * This library is a wrapper for <MFRC522.h> that provides two classes to easily read 
@@ -19,6 +21,120 @@
  * Pablo A. Sampaio, 2018, 2021
  */
 
+// The MFRC522 accepts SPI clocks up to 10 MHz (datasheet, section 8.1.2)
+#define EASY_MFRC522_MAX_SPI_CLOCK      10000000UL
+#define EASY_MFRC522_DEFAULT_SPI_CLOCK   4000000UL
+
+// Value of the IRQ pin when the IRQ mode is disabled (see EasyMFRC522::enableIrq())
+#define EASY_MFRC522_NO_IRQ  0xFF
+
+// Number of blocks that can be declared as value blocks (all blocks of the tags supported)
+#define EASY_MFRC522_VALUE_BLOCKS_MAP_SIZE  (EASY_MFRC522_MAX_BLOCK + 1)
+
+
+class EasyMFRC522;
+class RfidCipher;
+class RfidImage;
+class RfidBatch;
+
+// An entry of the prefetch list (see EasyMFRC522::setPrefetchList()). Only the fields 
+// "block" and "label" must be given; the other ones are filled by the class.
+struct RfidPrefetchEntry {
+    byte block;         // start block of the file
+    const char* label;  // label of the file
+    int size;           // result of readFileSize() (negative if the file was not found)
+    int offset;         // position of the content in the prefetch buffer
+    byte flags;         // flags of the file (e.g. EASY_MFRC522_FILE_ENCRYPTED)
+    byte state;
+};
+
+// Functions that give the data written by writeRaw() (source), or receive the data read by
+// readRaw() (sink), one block at a time: "length" bytes (16, except in the last block), that
+// are at the given "position" of the whole data. A negative return value aborts the operation.
+typedef int (*RfidDataSource)(byte* chunk, int position, int length, void* context);
+typedef int (*RfidDataSink)(const byte* chunk, int position, int length, void* context);
+
+// Function that gives the random part (8 bytes) of the nonce of each encrypted file, which
+// must never repeat for the same key (see EasyMFRC522::setNonceSource()).
+typedef void (*RfidNonceSource)(byte randomPart[8], void* context);
+
+// Flags of labeled data (files), stored in their first block
+#define EASY_MFRC522_FILE_ENCRYPTED  0x01
+#define EASY_MFRC522_FILE_PARITY     0x02  // the size of the parity groups is kept in the 4 high bits of the flags
+#define EASY_MFRC522_FILE_INLINE     0x04  // the data (1 or 2 bytes) is in the header, with its size in the 4 high bits of the flags
+
+// Maximum number of data blocks protected by each parity block (see EasyMFRC522::setFileParity())
+#define EASY_MFRC522_MAX_PARITY_GROUP  8
+
+// Options of EasyMFRC522::applyImage() (may be combined with |)
+#define RFID_IMAGE_VERIFY          0x01  // reads back the blocks written (once, after all writes of each sector)
+#define RFID_IMAGE_SKIP_UNCHANGED  0x02  // reads each block first, and doesn't write it if it already has the data
+#define RFID_IMAGE_SKIP_BLANK      0x04  // doesn't write the blocks of the image that are all 0s (for blank tags)
+
+// Commands recorded in the trace (see EasyMFRC522::setTraceBuffer())
+enum RfidTraceCommand {
+    RFID_TRACE_AUTH = 1,   // authentication of the sector of the block
+    RFID_TRACE_READ,
+    RFID_TRACE_WRITE,
+    RFID_TRACE_SELECT,     // selection of a tag (block is 0)
+    RFID_TRACE_HALT,       // block is 0
+    RFID_TRACE_VALUE,      // increment, decrement or restore of a value block
+    RFID_TRACE_TRANSFER    // transfer of the result of a value operation
+};
+
+// A command issued to the tag, with its result. The commands of a trace may be fed back 
+// to the class, to re-run an operation without the tag (see EasyMFRC522::startReplay()).
+struct RfidTraceRecord {
+    uint32_t time;       // micros() at the start of the command
+    uint16_t duration;   // in microseconds (saturates at 65535)
+    byte command;        // RfidTraceCommand
+    byte block;
+    byte status;         // MFRC522::StatusCode
+};
+
+// Operation applied to each tag in EasyMFRC522::processTags(); when it is called, the tag 
+// is selected (as if detected by detectTag()). The result is reported to the caller.
+typedef int (*RfidTagOperation)(EasyMFRC522* reader, const MFRC522::Uid* uid, void* context);
+
+// Writes that may be resumed (see EasyMFRC522::getResumeRecord())
+enum RfidResumeOperation {
+    RFID_RESUME_NONE = 0,
+    RFID_RESUME_WRITE_RAW,   // writeRaw() of an array
+    RFID_RESUME_WRITE_FILE   // the data of a (not encrypted) writeFile() of an array
+};
+
+// Progress of a write interrupted by an error (e.g. the tag left the field), kept to 
+// continue the write when it is repeated in the same tag.
+struct RfidResumeRecord {
+    MFRC522::Uid uid;
+    byte operation;          // RfidResumeOperation
+    int initialBlock;        // where the data starts (for files: the block after the header)
+    int dataSize;
+    uint16_t checksum;       // CRC-16 of the data
+    int bytesVerified;       // the data before this position (a multiple of 16) is verified in the tag
+    int lastBlockVerified;
+};
+
+// Number of events kept by the diagnostics (see EasyMFRC522::popDiagnostic()); when it is 
+// full, the oldest event is discarded
+#ifndef EASY_MFRC522_DIAGNOSTICS_SIZE
+#define EASY_MFRC522_DIAGNOSTICS_SIZE  8
+#endif
+
+// Code of the event given by EasyMFRC522::init(), with the version of the MFRC522 in "status"
+// (0x91 = v1.0, 0x92 = v2.0); the other events are errors, with the negative codes of the .cpp
+#define RFID_DIAG_CHIP_VERSION  1
+
+// An event of the diagnostics: an error (or other notable fact) in an operation of the library
+struct RfidDiagnostic {
+    uint32_t time;       // millis() when it happened
+    int code;            // RFID_DIAG_CHIP_VERSION, or an error code (see the list in the end of the .cpp)
+    int16_t block;       // the block involved, or -1
+    byte status;         // MFRC522::StatusCode of the command that failed (0 if not applicable)
+};
+
+// Function called for each event of the diagnostics, as soon as it happens (it must be quick)
+typedef void (*RfidDiagnosticSink)(const RfidDiagnostic& event, void* context);
 
 /**
  * Allows to read (or write) data chunks from (or to) multiple sequential blocks 
@@ -42,28 +158,267 @@
  * 1 - All sectors use the same key A to authenticate. 
  * 2 - And that all blocks are in "transport configuration" (therefore, read and write
  *     operations can be done using anyone of the keys, but we only use key A).
- * 3 - There is always a single tag in the detection range
+ * 3 - There is always a single tag in the detection range (except for the functions
+ *     inventory() and processTags(), that handle multiple tags)
  */
 class EasyMFRC522 {
+public:
+    // Counters of the SPI traffic generated by the block transfers (reads and writes
+    // of data blocks). Authentication and detection are done by Balboa's class and
+    // are not counted here.
+    struct TransferStats {
+        unsigned long spiTransactions;  // number of chip-select cycles
+        unsigned long spiBytes;         // bytes clocked in the SPI bus (in both directions)
+        unsigned long spiPolls;         // reads of ComIrqReg while waiting for the tag (also counted above, 2 bytes each)
+        unsigned long blockOperations;  // number of MIFARE read/write commands issued
+        unsigned long blocksRecovered;  // blocks of files rebuilt from the parity (see setFileParity())
+    };
+
 private:
     MFRC522 device;
     MFRC522::MIFARE_Key key;
 
+    byte chipSelectPin;
+    uint32_t spiClock;
+    SPISettings spiSettings;
+    TransferStats stats;
+
     byte blockBuffer[18] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 
+    byte valueBlocksMap[(EASY_MFRC522_VALUE_BLOCKS_MAP_SIZE + 7) / 8] = { 0 };  // bit set for each value block
+
+    int authenticatedSector;  // sector currently authenticated in the tag, or -1
+
+#if EASY_MFRC522_ENABLE_PREFETCH
+    RfidPrefetchEntry* prefetchList;
+    byte prefetchListSize;
+    byte* prefetchBuffer;
+    int prefetchBufferSize;
+#endif
+
+    RfidCipher* fileCipher;
+    RfidNonceSource nonceSource;
+    void* nonceContext;
+    byte fileParityGroup;
+    bool filePacking;
+
+    byte irqPin;                   // EASY_MFRC522_NO_IRQ, if the IRQ mode is disabled
+    volatile bool irqFlag;         // set by the interrupt handler (see signalIrq())
+    bool requestPending;           // a REQA was sent by detectTag() in the IRQ mode
+    unsigned long requestStart;    // millis() when the REQA was sent
+
+    static EasyMFRC522* irqInstance;
+    static void _irqHandler();
+    void _startRequestA();
+    bool _waitIrq(unsigned long timeoutMillis);
+    bool _selectTag(byte outputTagId[4]);
+
+#if EASY_MFRC522_ENABLE_TRACE
+    RfidTraceRecord* traceBuffer;  // ring buffer
+    int traceCapacity;
+    int traceSize;
+    int traceNext;                 // position of the next record in the ring
+
+    const RfidTraceRecord* replayTrace;
+    int replaySize;
+    int replayPosition;
+    int replayMismatches;
+    bool replayRealTime;
+    int replayBlockAddr;           // last block written in the replay, kept to answer the verification
+    byte replayBlock[16];
+
+    void _trace(byte command, byte block, MFRC522::StatusCode status, unsigned long startMicros);
+    bool _replay(byte command, byte block, MFRC522::StatusCode* status);
+#else
+    inline void _trace(byte command, byte block, MFRC522::StatusCode status, unsigned long startMicros) {
+    }
+    inline bool _replay(byte command, byte block, MFRC522::StatusCode* status) {
+        return false;
+    }
+#endif
+
+#if EASY_MFRC522_ENABLE_DIAGNOSTICS
+    RfidDiagnostic diagnostics[EASY_MFRC522_DIAGNOSTICS_SIZE];  // ring buffer
+    byte diagnosticsNext;          // position of the next event in the ring
+    byte diagnosticsSize;
+    unsigned int diagnosticsLost;  // events discarded because the ring was full
+    RfidDiagnosticSink diagnosticSink;
+    void* diagnosticContext;
+#endif
+
+#if EASY_MFRC522_ENABLE_RESUME
+    RfidResumeRecord resume;
+    bool resumeEnabled;
+#endif
+
+    int _writeRawResumable(byte operation, int initialBlock, byte* data, int dataSize);
+    int _writeRawStream(int initialBlock, int dataSize, RfidDataSource source, void* context, int startOffset, int* bytesVerifiedOut);
+
+    int _readFileHeader(int initialBlock, const char dataLabel[12], byte* flagsOut);
+    int _readFile(byte initialBlock, const char dataLabel[12], RfidDataSink sink, void* context, int capacity);
+    int _readEncryptedFile(int initialBlock, const byte header[16], RfidDataSink sink, void* context);
+    int _writeEncryptedFile(int headerBlock, const byte header[16], RfidDataSource source, void* context);
+    void _fillNonceRandom(byte randomPart[8]);
+    int _writeParityFile(int headerBlock, int dataSize, byte groupSize, RfidDataSource source, void* context);
+    int _readParityFile(int headerBlock, int dataSize, byte groupSize, RfidDataSink sink, void* context);
+    int _readInlineFile(int initialBlock, const char dataLabel[12], int dataSize, RfidDataSink sink, void* context);
+    MFRC522::StatusCode _readBlockTrials(int blockAddr, byte* output, int trials);
+
+    MFRC522::StatusCode _authenticate(int blockAddr);
+#if EASY_MFRC522_ENABLE_PREFETCH
+    void _prefetch();
+    RfidPrefetchEntry* _findPrefetched(int initialBlock, const char dataLabel[12]);
+    void _invalidatePrefetch(int firstBlock, int lastBlock);
+#else
+    inline void _prefetch() {
+    }
+    inline RfidPrefetchEntry* _findPrefetched(int initialBlock, const char dataLabel[12]) {
+        return NULL;
+    }
+    inline void _invalidatePrefetch(int firstBlock, int lastBlock) {
+    }
+#endif
+    int _changeValue(int blockAddr, int32_t delta, bool increment, int transferTo);
+
     int _writeBlockAndVerify(int blockAddr, byte* data, int startIndex, int bytesToWrite);
     int _readBlock(int blockAddr, byte* destiny, byte firstIndex, byte bytesToRead);
     int _verifyBlock(int blockAddr, byte* refData, byte startByte, byte bytesToCheck);
 
+    inline bool _isTrailerBlock(int blockAddr) {
+        return easyMfrc522IsTrailer(blockAddr);
+    }
+    inline int _sectorOf(int blockAddr) {
+        return easyMfrc522SectorOf(blockAddr);
+    }
+    int _lastBlock();
+
+    // SPI transfer layer, used for the block reads/writes (see "BURST TRANSFERS" in the .cpp)
+    void _pcdWriteRegister(byte reg, byte value);
+    void _pcdWriteRegister(byte reg, byte count, const byte* values);
+    byte _pcdReadRegister(byte reg);
+    void _pcdReadRegisters(const byte* regs, byte count, byte* values);
+    void _pcdReadRegister(byte reg, byte count, byte* values);
+    MFRC522::StatusCode _pcdTransceive(const byte* sendData, byte sendLen, byte* backData, byte* backLen, byte* validBits);
+    MFRC522::StatusCode _mifareRead(byte blockAddr, byte* buffer);
+    MFRC522::StatusCode _mifareWrite(byte blockAddr, const byte* data);
+    static void _calculateCrcA(const byte* data, byte length, byte* result);
+
 public:
 
-	EasyMFRC522(byte sdaPin, byte resetPin);
+	EasyMFRC522(byte sdaPin, byte resetPin, uint32_t spiClock = EASY_MFRC522_DEFAULT_SPI_CLOCK);
     virtual ~EasyMFRC522();
 
     // configurations
     void init();
     void setKeyA(byte keyA[6]);
 
+    // the clock is limited to EASY_MFRC522_MAX_SPI_CLOCK (10 MHz)
+    void setSpiClock(uint32_t clockHz);
+    inline uint32_t getSpiClock() {
+        return this->spiClock;
+    }
+
+    // IRQ mode (see "IRQ MODE" in the .cpp); call after init()
+    bool enableIrq(byte irqPin);
+    void disableIrq();
+    inline bool isIrqEnabled() {
+        return this->irqPin != EASY_MFRC522_NO_IRQ;
+    }
+    void signalIrq();  // called by the interrupt handler (or by a simulated IRQ source)
+    inline bool isIrqPending() {
+        return this->irqFlag;
+    }
+
+#if EASY_MFRC522_ENABLE_PREFETCH
+    // files read in advance when a tag is detected (see "PREFETCH" in the .cpp)
+    void setPrefetchList(RfidPrefetchEntry* entries, byte numEntries, byte* buffer, int bufferSize);
+#endif
+
+    // files written from now on are encrypted with the cipher (which is needed to read them
+    // back too); NULL disables the encryption of new files (see writeFile() in the .cpp)
+    inline void setFileCipher(RfidCipher* cipher) {
+        this->fileCipher = cipher;
+    }
+    inline RfidCipher* getFileCipher() {
+        return this->fileCipher;
+    }
+
+    // source of the random part of the nonces of encrypted files (e.g. a counter kept in 
+    // EEPROM); NULL selects the default, which needs a floating analog pin in boards without 
+    // a hardware random generator (see "NONCES" in the .cpp)
+    inline void setNonceSource(RfidNonceSource source, void* context = NULL) {
+        this->nonceSource = source;
+        this->nonceContext = context;
+    }
+
+    // files written from now on have one parity block for each group of "groupSize" data 
+    // blocks (up to EASY_MFRC522_MAX_PARITY_GROUP), so that a block that fails to be read is 
+    // rebuilt from the others; 0 disables it (see writeFile() in the .cpp)
+    inline void setFileParity(byte groupSize) {
+        this->fileParityGroup = (groupSize > EASY_MFRC522_MAX_PARITY_GROUP)? EASY_MFRC522_MAX_PARITY_GROUP : groupSize;
+    }
+    inline byte getFileParity() {
+        return this->fileParityGroup;
+    }
+
+    // files of 1 or 2 bytes written from now on are kept inside their headers, using a 
+    // single block (see writeFile() in the .cpp); disabled by default
+    inline void setFilePacking(bool enabled) {
+        this->filePacking = enabled;
+    }
+
+    // to be called if you authenticate directly with the MFRC522 class (see getMFRC522())
+    inline void resetAuthentication() {
+        this->authenticatedSector = -1;
+    }
+
+#if EASY_MFRC522_ENABLE_TRACE
+    // recording of the commands issued to the tag (see "TRACE AND REPLAY" in the .cpp)
+    void setTraceBuffer(RfidTraceRecord* buffer, int capacity);
+    void clearTrace();
+    inline int getTraceSize() {
+        return this->traceSize;
+    }
+    bool getTraceRecord(int index, RfidTraceRecord* recordOut);
+    int dumpTrace(Print& output);
+    static int parseTrace(const byte* dump, int dumpSize, RfidTraceRecord* recordsOut, int maxRecords);
+
+    void startReplay(const RfidTraceRecord* trace, int traceSize, bool realTime = true);
+    void stopReplay();
+    inline bool isReplaying() {
+        return this->replayTrace != NULL;
+    }
+    inline int getReplayMismatches() {
+        return this->replayMismatches;
+    }
+#endif
+
+    // events of errors, kept to be read when the application chooses (see "DIAGNOSTICS" in 
+    // the .cpp); the library never prints to Serial
+#if EASY_MFRC522_ENABLE_DIAGNOSTICS
+    void reportDiagnostic(int code, int block = -1, byte status = 0);
+    bool popDiagnostic(RfidDiagnostic* eventOut);
+    void clearDiagnostics();
+    inline int getNumDiagnostics() {
+        return this->diagnosticsSize;
+    }
+    inline unsigned int getLostDiagnostics() {
+        return this->diagnosticsLost;
+    }
+    inline void setDiagnosticSink(RfidDiagnosticSink sink, void* context = NULL) {
+        this->diagnosticSink = sink;
+        this->diagnosticContext = context;
+    }
+#else
+    inline void reportDiagnostic(int code, int block = -1, byte status = 0) {
+    }
+#endif
+
+    inline const TransferStats& getTransferStats() {
+        return this->stats;
+    }
+    void resetTransferStats();
+
     inline MFRC522* getMFRC522() {
         return &this->device;
     }
@@ -71,15 +426,32 @@ public:
         return &this->key;
     }
 
-    // detection of tags
+    // detection of tags (non-blocking in the IRQ mode)
     bool detectTag(byte outputTagId[4] = NULL);
 
     // parameter indicates if the same tag should be detectable immediately
     // again (withou having to move away and back again)
     void unselectMifareTag(bool allowRedetection = true);
 
+    // detection of multiple tags in the field at once (see details in the .cpp)
+    int inventory(MFRC522::Uid* uidsOut, int maxTags);
+    int processTags(const MFRC522::Uid* uids, int numTags, RfidTagOperation operation, void* context, int* resultsOut);
+
+    static bool isSameUid(const MFRC522::Uid& uid1, const MFRC522::Uid& uid2);
+    static uint16_t crc16(uint16_t crc, const byte* data, int length);  // CRC-16/CCITT (use 0xFFFF as the initial crc)
+
     int getUserDataSpace(int startBlock = 0);
 
+    // writes a pre-built image (see RfidProvisioningImage) with one authentication per sector
+    int applyImage(const RfidImage& image, byte options = RFID_IMAGE_VERIFY);
+
+    // executes the reads/writes of the batch in a single pass, sector by sector (see "BATCHES" in the .cpp)
+    int executeBatch(RfidBatch& batch);
+
+    // Gives the block where the byte at position "offset" of a data chunk written from 
+    // "initialBlock" (with writeRaw) is stored, or a negative number if it is out of the tag.
+    int getBlockOfOffset(int initialBlock, int offset);
+
     /* The functions below read/write labeled labeled (name) data, that are somewhat 
      * similar to "files", where the file name (data label) AND the start block
      * must be provided either to read the size of the data (with readSize()) or 
@@ -113,7 +485,15 @@ public:
         return readFile(initialBlock, buffer, dataOut, dataOutCapacity);
     }
 
+    // streaming versions: the data goes from/to the source/sink (or the Stream/Print), 
+    // one block at a time, with no buffer for the whole data
+    int writeFileStream(byte initialBlock, const char fileName[13], int dataSize, RfidDataSource source, void* context);
+    int readFileStream(byte initialBlock, const char fileName[13], RfidDataSink sink, void* context);
+    int writeFile(byte initialBlock, const char fileName[13], Stream& input, int dataSize);
+    int readFile(byte initialBlock, const char fileName[13], Print& output);
+
     int readFileSize(int initialBlock, const char fileName[13]);
+    static void fillFileHeader(byte header[16], const char dataLabel[12], byte flags, int dataSize);
     inline int readFileSize(int initialBlock, String fileName) {
         char buffer[13];
         fileName.toCharArray(buffer, 13);
@@ -127,6 +507,11 @@ public:
         return readFileSize(initialBlock, fileName) >= 0;
     }
 
+    // tiny labeled values that share a single block (see "PACKED VALUES" in the .cpp); each 
+    // one is read with a single block read, and a value that doesn't fit in the block gives -712
+    int writePackedValue(int block, const char* label, const byte* value, byte valueSize);
+    int readPackedValue(int block, const char* label, byte* valueOut, int valueOutCapacity);
+
     /* These member functions don't assign labels to the data, so the size of 
      * the data cannot be properly retrieved by this class (with readSize). 
      * 
@@ -142,12 +527,70 @@ public:
     
     int readRaw(int initialBlock, byte* dataOutput, int dataSize);
 
+#if EASY_MFRC522_ENABLE_RESUME
+    // writes of arrays interrupted by errors are continued when repeated (see "RESUMABLE 
+    // WRITES" in the .cpp); enabled by default
+    inline void setResumeEnabled(bool enabled) {
+        this->resumeEnabled = enabled;
+        clearResumeRecord();
+    }
+    inline const RfidResumeRecord& getResumeRecord() {
+        return this->resume;
+    }
+    inline void clearResumeRecord() {
+        this->resume.operation = RFID_RESUME_NONE;
+    }
+#endif
+
+    // streaming versions (see the comments to writeFileStream()/readFileStream() above)
+    int writeRawStream(int initialBlock, int dataSize, RfidDataSource source, void* context);
+    int readRawStream(int initialBlock, int dataSize, RfidDataSink sink, void* context);
+    int writeRaw(int initialBlock, Stream& input, int dataSize);
+    int readRaw(int initialBlock, Print& output, int dataSize);
+
+    /* The member functions below handle Mifare Classic "value blocks", which store a 
+     * signed 32-bit integer that the tag itself can increment/decrement. They are useful
+     * for counters and balances: each change is a single command (no need to read the 
+     * value before) and is safe if the tag leaves the field during the operation.
+     * 
+     * A block must be formatted as a value block before the other operations. Value 
+     * blocks are protected from writeRaw() and writeFile(), which return an error 
+     * instead of overwriting them.
+     */
+
+    int formatValueBlock(int blockAddr, int32_t value, byte addr = 0);
+    int readValue(int blockAddr, int32_t* valueOut, byte* addrOut = NULL);
+
+    // the result is stored in block "transferTo" (by default, the same block); give -1 to keep 
+    // it only in the internal register of the tag, then call transferValue()
+    inline int incrementValue(int blockAddr, int32_t delta, int transferTo = -2) {
+        return _changeValue(blockAddr, delta, true, (transferTo == -2)? blockAddr : transferTo);
+    }
+    inline int decrementValue(int blockAddr, int32_t delta, int transferTo = -2) {
+        return _changeValue(blockAddr, delta, false, (transferTo == -2)? blockAddr : transferTo);
+    }
+
+    int restoreValue(int blockAddr);
+    int transferValue(int blockAddr);
+
+    // to (un)declare a block that was formatted before (e.g. by another program)
+    void declareValueBlock(int blockAddr, bool isValue = true);
+    bool isValueBlock(int blockAddr);
+
 };
 
 
 // Just to make ir easier for the user. 
 // He/she will only need to include one header to use any of the classes.
+#if EASY_MFRC522_ENABLE_DICTIONARY
 #include "RfidDictionaryView.h"
+#include "RfidStaticDictionary.h"
+#endif
+#include "RfidRecord.h"
+#include "RfidCipher.h"
+#include "RfidProvisioningImage.h"
+#include "RfidBatch.h"
+#include "RfidReaderService.h"
 
 
 #endif
@@ -0,0 +1,89 @@
+
+#ifndef __EASY_MFRC522_CONFIG___
+#define __EASY_MFRC522_CONFIG___
+
+/*
+ * Compile-time configuration of the library. Each option may be given as a build flag
+ * (e.g. "-D EASY_MFRC522_ENABLE_TRACE=0" in platformio.ini), to strip the subsystems 
+ * not used by the application, or to choose the types of tag supported. The defaults
+ * keep all the functionalities, for all the Mifare Classic tags (mini, 1k and 4k).
+ * 
+ * The functions of the library that are not called are already removed by the linker. 
+ * But some subsystems are reached by the basic operations (e.g. detectTag() reads the 
+ * prefetch list, and each command to the tag is traced) and they also keep members in 
+ * the EasyMFRC522 objects, so they cost flash and RAM even if never used. Disabling them
+ * removes their functions from the class (it is a compile error to call them), except
+ * reportDiagnostic(), which is kept doing nothing.
+ * 
+ * To compare the flash and RAM used by each configuration, see tools/size_report.py.
+ */
+
+// Types of tags supported; the others are rejected by detectTag(). With a single type,
+// the geometry of the tag (e.g. its last block) is a constant, and the arrays sized by the
+// biggest tag supported (e.g. the map of value blocks) are smaller.
+#ifndef EASY_MFRC522_SUPPORT_MINI
+#define EASY_MFRC522_SUPPORT_MINI  1   // 20 blocks, in 5 sectors
+#endif
+#ifndef EASY_MFRC522_SUPPORT_1K
+#define EASY_MFRC522_SUPPORT_1K    1   // 64 blocks, in 16 sectors
+#endif
+#ifndef EASY_MFRC522_SUPPORT_4K
+#define EASY_MFRC522_SUPPORT_4K    1   // 256 blocks, in 32 sectors of 4 blocks and 8 sectors of 16 blocks
+#endif
+
+// Subsystems (1 to compile, 0 to strip)
+#ifndef EASY_MFRC522_ENABLE_PREFETCH
+#define EASY_MFRC522_ENABLE_PREFETCH     1   // setPrefetchList()
+#endif
+#ifndef EASY_MFRC522_ENABLE_TRACE
+#define EASY_MFRC522_ENABLE_TRACE        1   // setTraceBuffer(), startReplay() and the related functions
+#endif
+#ifndef EASY_MFRC522_ENABLE_DIAGNOSTICS
+#define EASY_MFRC522_ENABLE_DIAGNOSTICS  1   // popDiagnostic() and the ring buffer of events
+#endif
+#ifndef EASY_MFRC522_ENABLE_RESUME
+#define EASY_MFRC522_ENABLE_RESUME       1   // resumable writes (setResumeEnabled(), getResumeRecord())
+#endif
+#ifndef EASY_MFRC522_ENABLE_DICTIONARY
+#define EASY_MFRC522_ENABLE_DICTIONARY   1   // classes RfidDictionaryView and RfidStaticDictionary
+#endif
+
+// Unconnected analog pin whose noise seeds the nonces of encrypted files, in the boards 
+// without a hardware random generator (see setNonceSource() in EasyMFRC522.h)
+#ifndef EASY_MFRC522_ENTROPY_PIN
+#define EASY_MFRC522_ENTROPY_PIN  A0
+#endif
+
+
+#if (EASY_MFRC522_SUPPORT_MINI + EASY_MFRC522_SUPPORT_1K + EASY_MFRC522_SUPPORT_4K) == 0
+  #error "EasyMFRC522: at least one type of tag must be supported"
+#endif
+
+// The last block of the biggest tag supported
+#if EASY_MFRC522_SUPPORT_4K
+  #define EASY_MFRC522_MAX_BLOCK  255
+#elif EASY_MFRC522_SUPPORT_1K
+  #define EASY_MFRC522_MAX_BLOCK  63
+#else
+  #define EASY_MFRC522_MAX_BLOCK  19
+#endif
+
+// Tells if the block is the trailer of its sector (the block with the keys and the access bits)
+inline bool easyMfrc522IsTrailer(int block) {
+#if EASY_MFRC522_SUPPORT_4K
+  return (block < 128)? (block % 4 == 3) : (block % 16 == 15);
+#else
+  return block % 4 == 3;
+#endif
+}
+
+// Gives the sector of the block (the 4k tags have 32 sectors of 4 blocks, then 8 of 16 blocks)
+inline int easyMfrc522SectorOf(int block) {
+#if EASY_MFRC522_SUPPORT_4K
+  return (block < 128)? block / 4 : 32 + (block - 128) / 16;
+#else
+  return block / 4;
+#endif
+}
+
+#endif
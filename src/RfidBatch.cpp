@@ -0,0 +1,42 @@
+#include "RfidBatch.h"
+
+RfidBatch::RfidBatch(RfidBatchRequest* requestsStorage, int maxRequests) {
+  this->requests = requestsStorage;
+  this->maxRequests = maxRequests;
+  this->numRequests = 0;
+}
+
+void RfidBatch::clear() {
+  this->numRequests = 0;
+}
+
+// Reads "size" bytes from the initial block on, as readRaw() would do.
+int RfidBatch::addRead(int initialBlock, byte* buffer, int size) {
+  return _add(RFID_BATCH_READ, initialBlock, NULL, buffer, size);
+}
+
+// Writes the data from the initial block on, as writeRaw() would do.
+int RfidBatch::addWrite(int initialBlock, byte* data, int size) {
+  return _add(RFID_BATCH_WRITE, initialBlock, NULL, data, size);
+}
+
+// Writes the data as a file (labeled data), as writeFile() would do (without encryption,
+// parity or packing, even if they are set in the EasyMFRC522).
+int RfidBatch::addWriteFile(int initialBlock, const char dataLabel[12], byte* data, int size) {
+  return _add(RFID_BATCH_WRITE_FILE, initialBlock, dataLabel, data, size);
+}
+
+int RfidBatch::_add(byte type, int initialBlock, const char* label, byte* data, int size) {
+  if (this->numRequests == this->maxRequests) {
+    return -901;
+  }
+  RfidBatchRequest* request = &this->requests[this->numRequests];
+  request->type = type;
+  request->firstBlock = initialBlock;
+  request->lastBlock = initialBlock;
+  request->label = label;
+  request->data = data;
+  request->size = (size < 0)? 0 : size;
+  request->result = 0;
+  return this->numRequests ++;
+}
@@ -0,0 +1,88 @@
+
+#ifndef __RFID_BATCH___
+#define __RFID_BATCH___
+
+#include <EasyMFRC522.h>
+
+// Types of the requests of a batch
+#define RFID_BATCH_READ        1   // as readRaw()
+#define RFID_BATCH_WRITE       2   // as writeRaw()
+#define RFID_BATCH_WRITE_FILE  3   // as writeFile(), without encryption, parity or packing
+
+/**
+ * One request of a batch. The fields "firstBlock", "lastBlock" and "result" are filled
+ * by EasyMFRC522::executeBatch().
+ */
+struct RfidBatchRequest {
+    byte type;
+    int firstBlock;      // first block used (the initial block given, or the next one, if it is a trailer)
+    int lastBlock;       // (int, so that blocks out of the tag are rejected, not wrapped)
+    const char* label;   // for files only
+    byte* data;          // data to write, or buffer to read
+    int size;            // size of the data (for files, not counting the header)
+    int result;          // as in the corresponding function of EasyMFRC522
+};
+
+/**
+ * A batch of reads and writes of the same tag, which are executed together, with 
+ * EasyMFRC522::executeBatch(), in a single pass over the blocks of the tag, in order. 
+ * So, each sector is authenticated only once, and each block is read or written only 
+ * once, even if it is accessed by many requests. The time the tag must stay in the 
+ * field depends on the number of sectors accessed, not on the number of requests.
+ * 
+ * This class doesn't have storage for the requests; use RfidStaticBatch, below.
+ * 
+ * Example:
+ *   RfidStaticBatch<4> batch;
+ *   batch.addWriteFile(1, "name", (byte*)"Pablo", 6);
+ *   batch.addWrite(8, counters, sizeof(counters));
+ *   batch.addRead(12, history, sizeof(history));
+ *   rfidReader.executeBatch(batch);
+ *   ... batch.getResult(i) gives the result of the i-th request
+ * 
+ * The functions to add requests return the index of the request, or -901 if the batch 
+ * is full. The data (and the labels) must be kept allocated until the batch is executed.
+ */
+class RfidBatch {
+private:
+    RfidBatchRequest* requests;
+    int maxRequests;
+    int numRequests;
+
+public:
+    RfidBatch(RfidBatchRequest* requestsStorage, int maxRequests);
+
+    void clear();
+
+    int addRead(int initialBlock, byte* buffer, int size);
+    int addWrite(int initialBlock, byte* data, int size);
+    int addWriteFile(int initialBlock, const char dataLabel[12], byte* data, int size);
+
+    inline int getNumRequests() const {
+        return this->numRequests;
+    }
+    inline RfidBatchRequest& getRequest(int index) {
+        return this->requests[index];
+    }
+    inline int getResult(int index) const {
+        return this->requests[index].result;
+    }
+
+private:
+    int _add(byte type, int initialBlock, const char* label, byte* data, int size);
+};
+
+/**
+ * A batch with storage for up to MAX_REQUESTS requests.
+ */
+template <int MAX_REQUESTS>
+class RfidStaticBatch : public RfidBatch {
+private:
+    RfidBatchRequest storage[MAX_REQUESTS];
+
+public:
+    RfidStaticBatch() : RfidBatch(storage, MAX_REQUESTS) {
+    }
+};
+
+#endif
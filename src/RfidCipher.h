@@ -0,0 +1,62 @@
+
+#ifndef __RFID_CIPHER___
+#define __RFID_CIPHER___
+
+#include <Arduino.h>
+
+#if defined(ESP32)
+  #include "mbedtls/aes.h"  // uses the AES hardware of the ESP32
+#endif
+
+/**
+ * Authenticated encryption of data streams with AES-128 in CCM mode (RFC 3610), with
+ * a 13-byte nonce, up to 14 bytes of associated data (authenticated, but not encrypted),
+ * and a tag of 8 bytes. It is used by EasyMFRC522 to encrypt/decrypt labeled data 
+ * (files) block by block (see EasyMFRC522::setFileCipher()).
+ * 
+ * The data is processed in chunks of 16 bytes (only the last chunk may be smaller), 
+ * in place, so the memory used is only the one of this object (around 200 bytes), 
+ * independently of the size of the data.
+ * 
+ * The AES block cipher uses the hardware of the ESP32; in other boards, it uses a 
+ * table-based implementation with the tables kept in flash memory (PROGMEM).
+ * 
+ * The nonce must never be repeated with the same key (in CCM, it would reveal the XOR of
+ * the two data, and allow forging their tags). EasyMFRC522 fills it with the UID of the tag
+ * and 8 bytes from its nonce source (see EasyMFRC522::setNonceSource()).
+ * 
+ * Usage:
+ *   cipher.begin(nonce, aad, aadLength, dataSize);
+ *   cipher.encrypt(chunk, 16); ... (or decrypt)
+ *   cipher.finish(tag);
+ */
+class RfidCipher {
+private:
+#if defined(ESP32)
+    mbedtls_aes_context aes;
+#else
+    uint32_t roundKeys[44];
+#endif
+    byte mac[16];       // state of the CBC-MAC
+    byte nonce[13];
+    uint16_t counter;   // index of the next counter block
+
+    void _counterBlock(uint16_t index, byte output[16]);
+    void _macChunk(const byte* chunk, int length);
+
+public:
+    RfidCipher(const byte key[16]);
+    virtual ~RfidCipher();
+
+    void setKey(const byte key[16]);
+
+    // encrypts a single block with AES-128 (ECB); "input" and "output" may be the same
+    void encryptBlock(const byte input[16], byte output[16]);
+
+    void begin(const byte nonce[13], const byte* aad, byte aadLength, uint16_t dataSize);
+    void encrypt(byte* chunk, int length);
+    void decrypt(byte* chunk, int length);
+    void finish(byte tag[8]);
+};
+
+#endif
@@ -1,9 +1,14 @@
 
 #include "RfidDictionaryView.h"
 
+#if EASY_MFRC522_ENABLE_DICTIONARY
+
 #define INITIAL_CAPACITY    30   // must be a non-negative even number; the number of pairs key/value is half this value
 #define CAPACITY_INCREMENT  30   // must be a non-negative even number; when it is necessary to grow, increment by this value
 
+#define LOG_SET     '+'   // type of the log record that sets a value: '+' key '\n' value '\n'
+#define LOG_REMOVE  '-'   // type of the log record that removes a key: '-' key '\n'
+
 
 RfidDictionaryView::RfidDictionaryView(EasyMFRC522* rfidDevice, int startBlock, bool autoDeallocateDevice) {
   this->device = rfidDevice;
@@ -13,9 +18,11 @@ RfidDictionaryView::RfidDictionaryView(EasyMFRC522* rfidDevice, int startBlock,
   this->dictionary = new String[INITIAL_CAPACITY];
   this->size = 0;
   this->loaded = false;
-  for (int i = 0; i < 4; i ++) {
-    this->tag_uid[i] = 0x00;
-  }
+  this->tag_uid.size = 0;
+  this->logCapacity = 0;
+  this->logValid = false;
+  this->logBlock = -1;
+  this->dictCrc = 0xFFFF;
 }
 
 RfidDictionaryView::RfidDictionaryView(byte sdaPin, byte resetPin, int startBlock)
@@ -43,6 +50,15 @@ int RfidDictionaryView::getMaxSpaceInTag() {
   return this->device->getUserDataSpace(this->startBlock) - 16;
 }
 
+/**
+ * Enables the log of changes (see "LOG" below), reserving the given space for it 
+ * after the dictionary. The log is created in the tag in the next change (which will 
+ * rewrite the whole dictionary). Use 0 to disable it.
+ */
+void RfidDictionaryView::setLogCapacity(int bytes) {
+  this->logCapacity = (bytes > 0)? bytes : 0;
+}
+
 //---- RFID **INTERNAL** FUNCTIONS --------------------------------------//
 
 /**
@@ -59,60 +75,46 @@ void RfidDictionaryView::_read_dictionary() {
     this->dictionary[i] = "";
   }
   this->size = 0;
+  this->dictCrc = 0xFFFF;
+  this->logValid = false;
 
-  // subtracts 16 (1 block), which is the space used by EasyMFRC522 to store file information
-  int spaceForDictInTag = getMaxSpaceInTag();
+  // the data is parsed as it is read from the tag, one block at a time (no buffer for the whole data)
+  int result = this->device->readFileStream(this->startBlock, "_rfiddict_", _parse_chunk, this);
 
-  if (! this->device->existsFile(this->startBlock, "_rfiddict_")) {
-    // in this case, it is considered loaded as an empty dictionary
-    this->loaded = true; 
-    // copies the uid of the current tag
-    MFRC522* mfrc522 = this->device->getMFRC522();
-    for (int i = 0; i < 4; i ++) {
-      this->tag_uid[i] = mfrc522->uid.uidByte[i];
-    }
-    return;
-  }
- 
-  byte *buffer = new byte[spaceForDictInTag];
-
-  // Lê e coloca as informações da tag no buffer
-  int result = this->device->readFile(this->startBlock, "_rfiddict_", buffer, spaceForDictInTag);
-  
-  if (result < 0) {
-    Serial.print  ("Error: when reading the RFID tag, got ");
-    Serial.println(result);
+  if (result == -1010 || result == -1011) {
+    // the file doesn't exist: in this case, it is considered loaded as an empty dictionary
+    this->size = 0;
+  } else if (result < 0 || !_read_log(result)) {
+    this->device->reportDiagnostic((result < 0)? result : -3008, this->startBlock);  // error when reading the tag
     this->loaded = false;
-    delete[] buffer;
+    this->size = 0;
     return;
   }
 
-  // Creates the dicionary from the data that was read from the tag
-  // Obs.: result contains the number of bytes that were actually read
-  int pos = 0;
-  
-  for (pos = 0; pos < result; pos ++) {
-    if ((char)buffer[pos] == '\n') {  //mudar para \0
-      this->size++;
-      if (this->size >= this->capacity) {
+  // copies the uid of the current tag
+  this->tag_uid = this->device->getMFRC522()->uid;
+
+  this->loaded = true;
+}
+
+// Sink for readFileStream(): adds the chars of the chunk to the dictionary, where each '\n'
+// ends a string (a key or a value).
+int RfidDictionaryView::_parse_chunk(const byte* chunk, int position, int length, void* dictView) {
+  RfidDictionaryView* self = (RfidDictionaryView*)dictView;
+  self->dictCrc = EasyMFRC522::crc16(self->dictCrc, chunk, length);
+
+  for (int pos = 0; pos < length; pos ++) {
+    if ((char)chunk[pos] == '\n') {
+      self->size++;
+      if (self->size >= self->capacity) {
         //grows to be able to add more strings
-        _grow_dict();
+        self->_grow_dict();
       }
-    
     } else {
-      //isso pode ser mais eficiente... ideia: setar \0 e passar o buffer+contador
-      this->dictionary[this->size].concat((char)buffer[pos]);
+      self->dictionary[self->size].concat((char)chunk[pos]);
     }
   }
-
-  // copies the uid of the current tag
-  MFRC522* mfrc522 = this->device->getMFRC522();
-  for (int i = 0; i < 4; i ++) {
-    this->tag_uid[i] = mfrc522->uid.uidByte[i];
-  }
-
-  this->loaded = true;
-  delete[] buffer;
+  return 0;
 }
 
 // Finds the index of a key; assumes the dictionary is loaded.
@@ -140,7 +142,7 @@ void RfidDictionaryView::_write_dictionary() {
       dictString.concat("\n");
     } else {
       this->loaded = false;
-      Serial.println("Error: Dictionary is too big! Some entries were not written!");
+      this->device->reportDiagnostic(-3004, this->startBlock);  // too big: some entries were not written
       break;
     }
   }
@@ -149,15 +151,304 @@ void RfidDictionaryView::_write_dictionary() {
   char *buffer = new char[stringSize + 1]; // adds +1 space for the '\0' that terminates the string (written by toCharArray)
   dictString.toCharArray(buffer, stringSize+1);
 
+  // written without parity, because the log is located from the size of the dictionary file
+  byte parity = this->device->getFileParity();
+  this->device->setFileParity(0);
   int result = this->device->writeFile(this->startBlock, "_rfiddict_", (byte*)buffer, stringSize);
+  this->device->setFileParity(parity);
+  this->dictCrc = EasyMFRC522::crc16(0xFFFF, (byte*)buffer, stringSize);
   delete[] buffer;
 
   if (result <= 0) {
     this->loaded = false;
-    Serial.print  ("Error: Could not write to the tag, got ");
-    Serial.println(result);
+    this->logValid = false;
+    this->device->reportDiagnostic(result, this->startBlock);  // error when writing to the tag
+    return;
+  }
+
+  _reset_log(result);
+}
+
+// Sets the value of the key in the dictionary (in memory only); assumes it is loaded.
+void RfidDictionaryView::_dict_put(const String& key, const String& value) {
+  int key_index = _dict_find(key);
+
+  if (key_index >= 0) {
+    //if the key exists, updates only the value (kept in the next index)
+    this->dictionary[key_index+1] = value;
+  
+  } else {
+    //if the key does not exist and there is no room, allocates more space
+    if (this->size+2 > this->capacity) {
+      _grow_dict();
+    }
+
+    this->dictionary[this->size] = key;
+    this->dictionary[this->size+1] = value;
+    this->size += 2;
+  }
+}
+
+// Removes the key (given by its index) and its value from the dictionary (in memory only).
+void RfidDictionaryView::_dict_erase(int key_index) {
+  for (int i = key_index; i < this->size - 2; i++) {
+    this->dictionary[i] = this->dictionary[i+2];
+  }
+  this->size -= 2;
+  this->dictionary[this->size] = "";
+  this->dictionary[this->size+1] = "";
+}
+
+// Saves a change already done in memory: appends it to the log, if possible, or rewrites the 
+// whole dictionary (what also compacts the log).
+void RfidDictionaryView::_commit(char type, const String& key, const String& value) {
+  if (! _append_log(type, key, value)) {
+    _write_dictionary();
+  }
+}
+
+//---- LOG OF CHANGES ---------------------------------------------------//
+
+/*
+ * Rewriting the whole dictionary in each change costs a number of block writes that grows 
+ * with the dictionary, and always wears the first blocks. With the log enabled (see 
+ * setLogCapacity()), the dictionary file works as a base snapshot, and each change is 
+ * appended as a small record to a log, which is a file labeled "_rfidlog_" written in the 
+ * blocks just after the dictionary file. The log contains:
+ * - 2 bytes: the CRC-16 of the content of the dictionary file, so that a log that was left 
+ *   behind by an older version of the dictionary is ignored;
+ * - the records: LOG_SET key '\n' value '\n' or LOG_REMOVE key '\n';
+ * - an end mark (any other byte, usually 0), followed by unused space.
+ * 
+ * When loading, the records are applied to the dictionary, in order. A new record is 
+ * written just over the end mark, and is followed by a new end mark. A copy of the block 
+ * where the end mark is (the tail) is kept in memory, so a small record costs only one 
+ * block write (two, if it crosses the boundary of a block). The blocks are written from 
+ * the last one to the first one, so that the record only becomes visible (with the write
+ * of the block of the old end mark) after all its bytes have been written.
+ * 
+ * When the log is full or has RFID_DICT_LOG_MAX_RECORDS records, the whole dictionary is 
+ * rewritten (including the effects of the log), followed by an empty log (compaction). 
+ * If there is not enough space after the dictionary, or if the files are encrypted 
+ * (see EasyMFRC522::setFileCipher()), the changes rewrite the whole dictionary.
+ * 
+ * Both files are always written without parity (see EasyMFRC522::setFileParity()), so that
+ * the blocks of the dictionary file are given by its size, and the records of the log go
+ * straight to the blocks of its data.
+ */
+
+// State of the parsing of the log, done as the log is read from the tag.
+struct RfidLogParser {
+  RfidDictionaryView* dictView;
+  uint16_t crc;      // the CRC stored in the log
+  int end;           // position of the end mark (-1 if not found yet)
+  int records;       // number of records applied
+  char type;         // type of the current record (0 if none)
+  bool inValue;      // true if reading the value of the record (false: reading the key)
+  String key;
+  String value;
+};
+
+// Reads the log that follows the dictionary file (of the given size), applying its records 
+// to the dictionary. Returns false only in case of errors in the communication.
+bool RfidDictionaryView::_read_log(int dictSize) {
+  if (this->device->getFileCipher() != NULL) {
+    return true;   //logs are not used with encrypted files
+  }
+
+  int headerBlock = this->device->getBlockOfOffset(this->startBlock, 0);
+  int lastBlock = (dictSize > 0)? this->device->getBlockOfOffset(headerBlock + 1, dictSize - 1) : headerBlock;
+  int block = (lastBlock > 0)? this->device->getBlockOfOffset(lastBlock + 1, 0) : -1;
+  if (block < 0) {
+    return true;   //no space after the dictionary
+  }
+
+  int fileSize = this->device->readFileSize(block, "_rfidlog_");
+  if (fileSize == -10 || fileSize == -11) {
+    return true;   //there is no log
+  } else if (fileSize < 0) {
+    return false;
+  }
+
+  RfidLogParser parser;
+  parser.dictView = this;
+  parser.crc = 0;
+  parser.end = -1;
+  parser.records = 0;
+  parser.type = 0;
+
+  int result = this->device->readRawStream(this->device->getBlockOfOffset(block + 1, 0), fileSize, _parse_log_chunk, &parser);
+  if (result < 0 && parser.end < 0) {
+    // -122: the sink stopped because the log belongs to an older dictionary (it is ignored)
+    return result == -122;
+  }
+
+  this->logValid = true;
+  this->logBlock = block;
+  this->logSize = fileSize;
+  this->logUsed = (parser.end >= 0)? parser.end : fileSize;
+  this->logRecords = parser.records;
+  return true;
+}
+
+// Sink for readRawStream(): applies each record of the log, until the end mark is found 
+// (then, it returns -1 to stop reading).
+int RfidDictionaryView::_parse_log_chunk(const byte* chunk, int position, int length, void* logParser) {
+  RfidLogParser* parser = (RfidLogParser*)logParser;
+  RfidDictionaryView* self = parser->dictView;
+
+  for (int i = 0; i < length; i ++) {
+    int pos = position + i;
+    char c = (char)chunk[i];
+
+    if (pos < 2) {
+      parser->crc |= (uint16_t)chunk[i] << (8 * pos);
+      if (pos == 1 && parser->crc != self->dictCrc) {
+        return -1;
+      }
+
+    } else if (parser->type == 0) {
+      if (c != LOG_SET && c != LOG_REMOVE) {
+        // end mark: keeps the block where the next record will start
+        parser->end = pos;
+        memset(self->logTail, 0, 16);
+        memcpy(self->logTail, chunk, length);
+        return -1;
+      }
+      parser->type = c;
+      parser->inValue = false;
+      parser->key = "";
+      parser->value = "";
+
+    } else if (c != '\n') {
+      if (parser->inValue) {
+        parser->value.concat(c);
+      } else {
+        parser->key.concat(c);
+      }
+
+    } else if (parser->type == LOG_SET && !parser->inValue) {
+      parser->inValue = true;
+
+    } else {
+      // the record is complete
+      if (parser->type == LOG_SET) {
+        self->_dict_put(parser->key, parser->value);
+      } else {
+        int key_index = self->_dict_find(parser->key);
+        if (key_index >= 0) {
+          self->_dict_erase(key_index);
+        }
+      }
+      parser->records ++;
+      parser->type = 0;
+    }
+  }
+  return 0;
+}
+
+// Creates an empty log after the dictionary file (that ends in the given block), if the log is
+// enabled. Otherwise, invalidates the old log (if any), that doesn't reflect the new dictionary.
+void RfidDictionaryView::_reset_log(int lastDictBlock) {
+  bool hadLog = this->logValid;
+  int block = this->device->getBlockOfOffset(lastDictBlock + 1, 0);
+  int fileSize = 0;
+
+  this->logValid = false;
+
+  if (block > 0 && this->logCapacity > 0 && this->device->getFileCipher() == NULL) {
+    fileSize = this->device->getUserDataSpace(block) - 16;
+    if (fileSize > this->logCapacity) {
+      fileSize = this->logCapacity;
+    }
+    fileSize -= fileSize % 16;
+  }
+
+  if (fileSize >= 16) {
+    byte* buffer = new byte[fileSize];
+    memset(buffer, 0, fileSize);
+    buffer[0] = this->dictCrc & 0xFF;
+    buffer[1] = this->dictCrc >> 8;
+
+    // without parity, because the records are written in place (in the blocks of its data)
+    byte parity = this->device->getFileParity();
+    this->device->setFileParity(0);
+    int result = this->device->writeFile(block, "_rfidlog_", buffer, fileSize);
+    this->device->setFileParity(parity);
+    if (result > 0) {
+      this->logValid = true;
+      this->logBlock = block;
+      this->logSize = fileSize;
+      this->logUsed = 2;
+      this->logRecords = 0;
+      memcpy(this->logTail, buffer, 16);
+    }
+    delete[] buffer;
+
+  } else if (hadLog && this->logBlock > lastDictBlock) {
+    // overwrites the CRC of the old log (only if it was not overwritten by the new dictionary)
+    byte empty[16] = { 0 };
+    empty[0] = ~this->dictCrc & 0xFF;
+    empty[1] = ~this->dictCrc >> 8;
+    this->device->writeRaw(this->device->getBlockOfOffset(this->logBlock + 1, 0), empty, 16);
+  }
+}
+
+// Appends a record to the log. Returns false if the log is disabled, full or if the record 
+// could not be written (in these cases, the dictionary must be rewritten).
+bool RfidDictionaryView::_append_log(char type, const String& key, const String& value) {
+  if (this->logCapacity == 0 || !this->logValid || this->device->getFileCipher() != NULL
+      || this->logRecords >= RFID_DICT_LOG_MAX_RECORDS) {
+    return false;
+  }
+
+  String record = "";
+  record.concat(type);
+  record.concat(key);
+  record.concat('\n');
+  if (type == LOG_SET) {
+    record.concat(value);
+    record.concat('\n');
   }
 
+  int start = this->logUsed;
+  int end = start + record.length();
+  if (end > this->logSize) {
+    return false;
+  }
+
+  // blocks (given by their index in the log) to be written, including the new end mark
+  int firstIndex = start / 16;
+  int lastIndex = (end < this->logSize)? end / 16 : (end - 1) / 16;
+  byte chunk[16];
+  byte newTail[16] = { 0 };
+
+  for (int index = lastIndex; index >= firstIndex; index --) {
+    for (int i = 0; i < 16; i ++) {
+      int pos = index * 16 + i;
+      if (pos < start) {
+        chunk[i] = this->logTail[i];
+      } else if (pos < end) {
+        chunk[i] = (byte)record[pos - start];
+      } else {
+        chunk[i] = 0;
+      }
+    }
+
+    int block = this->device->getBlockOfOffset(this->logBlock + 1, index * 16);
+    if (this->device->writeRaw(block, chunk, 16) < 0) {
+      this->logValid = false;
+      return false;
+    }
+    if (index == lastIndex) {   // the block of the new end mark (or the last block, if the log is full)
+      memcpy(newTail, chunk, 16);
+    }
+  }
+
+  memcpy(this->logTail, newTail, 16);
+  this->logUsed = end;
+  this->logRecords ++;
+  return true;
 }
 
 void RfidDictionaryView::_grow_dict() {
@@ -175,13 +466,9 @@ void RfidDictionaryView::_grow_dict() {
 void RfidDictionaryView::_ensure_loaded() {
   if (loaded) {
     // checks the uid of the tag
-    MFRC522 *mfrc522 = this->device->getMFRC522();
-    for (int i = 0; i < 4; i ++) {
-      if (this->tag_uid[i] != mfrc522->uid.uidByte[i]) {
-        // the current tag (connected/selected by the device) is different
-        loaded = false;
-        break;
-      }
+    if (! EasyMFRC522::isSameUid(this->tag_uid, this->device->getMFRC522()->uid)) {
+      // the current tag (connected/selected by the device) is different
+      loaded = false;
     }
   }
 
@@ -245,8 +532,7 @@ String RfidDictionaryView::getKey(int key_index) {
   }
 
   if (2*key_index >= this->size) {
-    Serial.print   ("Error: invalid index ");
-    Serial.println(key_index);
+    this->device->reportDiagnostic(-3005, this->startBlock);  // invalid index
     return "";
   }
   return dictionary[2*key_index];
@@ -273,17 +559,14 @@ void RfidDictionaryView::remove(const String& key) {
   int key_index = _dict_find(key);
 
   if (key_index < 0) {
-    Serial.println("Error: key not found!");
+    this->device->reportDiagnostic(-3005, this->startBlock);  // key not found
     return;
   }
 
   //Remove the key and its value from the array
-  for (int i = key_index; i < this->size; i++) {
-    this->dictionary[i] = this->dictionary[i+2];
-  }
-  this->size -= 2;
+  _dict_erase(key_index);
 
-  _write_dictionary();
+  _commit(LOG_REMOVE, key, "");
 }
 
 /**
@@ -316,23 +599,9 @@ void RfidDictionaryView::set(const String& key, const String& value) {
     return ;
   }
 
-  int key_index = _dict_find(key);
-
-  if (key_index >= 0) {
-    //if the key exists, updates only the value (kept in the next index)
-    this->dictionary[key_index+1] = value;
-    _write_dictionary();
-  
-  } else {
-    //if the key does not exist and there is no room, allocates more space
-    if (this->size+2 > this->capacity) {
-      _grow_dict();
-    }
-
-    this->dictionary[this->size] = key;
-    this->dictionary[this->size+1] = value;
-    this->size += 2;
-    _write_dictionary();
-  }
+  _dict_put(key, value);
 
+  _commit(LOG_SET, key, value);
 }
+
+#endif  // EASY_MFRC522_ENABLE_DICTIONARY
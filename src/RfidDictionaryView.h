@@ -4,6 +4,13 @@
 
 #include <EasyMFRC522.h>
 
+#ifndef RFID_DICT_LOG_CAPACITY
+#define RFID_DICT_LOG_CAPACITY     64  // default space (in bytes) reserved for the log, when enabled with setLogCapacity()
+#endif
+#ifndef RFID_DICT_LOG_MAX_RECORDS
+#define RFID_DICT_LOG_MAX_RECORDS  8   // the dictionary is compacted once the log has this number of records
+#endif
+
 /**
  * Allows to access and write each RFID tag as a dictionary (associative array) with 
  * arbitrary number of entries. Each entry is given as a "key-value" pair of strings. 
@@ -29,6 +36,18 @@
  *   detectTag()     - stablishes connection and loads all key-value entries
  *   disconnectTag() - disconnets and unloads the data
  * 
+ * By default, each change rewrites the whole dictionary in the tag. With setLogCapacity(),
+ * changes are appended as small records to a log kept after the dictionary, so that 
+ * changing a single entry usually writes only one or two blocks. The log is merged back 
+ * into the dictionary (compacted) when it gets full. Tags with a log can be read by any
+ * instance of this class, with or without the log enabled.
+ * 
+ * The errors are not printed: they are given as events of the diagnostics of the 
+ * EasyMFRC522 (see EasyMFRC522::popDiagnostic()), with the error code of the operation
+ * on the tag, or with these codes: -3004 (the dictionary is too big for the tag), -3005
+ * (key not found, or invalid index), as in RfidStaticDictionary, and -3008 (the log 
+ * could not be read).
+ * 
  * Assumptions for using this class:
  * 1 - The same for EasyMFRC522 (i.e using the same authentication key A in all blocks, 
  *     existence of single tag in the range)
@@ -45,7 +64,16 @@ private:
     int capacity;        // Maximum size of the array (extended as needed)
     int size;            // Used size of the dictionary
     bool loaded;         // Indicates if the dictionary was already loaded from the currently selected RFID tag
-    byte tag_uid[4];     // UID of the tag from where the data were loaded
+    MFRC522::Uid tag_uid; // UID of the tag from where the data were loaded
+
+    int logCapacity;     // Space (in bytes) to reserve for the log when compacting; 0 disables the log
+    bool logValid;       // Indicates if the tag has a log that belongs to the current dictionary
+    int logBlock;        // Block of the log file, just after the dictionary file
+    int logSize;         // Size of the log file (the whole space reserved)
+    int logUsed;         // Bytes of the log used so far (with the initial checksum)
+    int logRecords;      // Number of records in the log
+    byte logTail[16];    // Copy of the block of the log where the next record will start
+    uint16_t dictCrc;    // Checksum of the dictionary file, that is also stored in the log
 
 public:
 
@@ -70,6 +98,12 @@ public:
 
     int getMaxSpaceInTag();
 
+    // enables the log of changes, reserving this space (in bytes) in the tag; 0 disables it
+    void setLogCapacity(int bytes = RFID_DICT_LOG_CAPACITY);
+    inline int getLogCapacity() {
+        return this->logCapacity;
+    }
+
 private:
     // auxiliary functions
 
@@ -77,11 +111,19 @@ private:
 
     void _read_dictionary();
     void _write_dictionary() ;
+    bool _read_log(int dictSize);
+    void _reset_log(int lastDictBlock);
+    bool _append_log(char type, const String& key, const String& value);
+    void _commit(char type, const String& key, const String& value);
+    void _dict_put(const String& key, const String& value);
+    void _dict_erase(int keyIndex);
     int _dict_find(const String& key);
     inline bool _dict_has_key(const String& key) {
         return _dict_find(key) >= 0;
     }
     void _grow_dict();
+    static int _parse_chunk(const byte* chunk, int position, int length, void* dictView);
+    static int _parse_log_chunk(const byte* chunk, int position, int length, void* logParser);
 
 };
 
@@ -0,0 +1,160 @@
+#include "RfidProvisioningImage.h"
+
+/*
+ * The functions that add data to the image use a "cursor", given by a block and a position
+ * inside that block. The blocks are created in the image (filled with 0s) when the first byte
+ * is put in them, and the trailer blocks and the block 0 are skipped, as in writeRaw().
+ */
+
+static bool isDataBlock(int block) {
+  return block != 0 && !easyMfrc522IsTrailer(block);
+}
+
+RfidImage::RfidImage(RfidImageBlock* blocksStorage, int maxBlocks) {
+  this->blocks = blocksStorage;
+  this->maxBlocks = maxBlocks;
+  this->numBlocks = 0;
+}
+
+void RfidImage::clear() {
+  this->numBlocks = 0;
+}
+
+/**
+ * Adds the data to the image, as writeRaw() would write it in the tag: starting in
+ * "initialBlock" (or in the next one, if it is a trailer block or the block 0), with the
+ * last block completed with 0s. Data added before in the same blocks is overwritten.
+ */
+int RfidImage::addRaw(int initialBlock, const byte* data, int dataSize) {
+  int block = initialBlock;
+  int position = 0;
+  int result = _put(&block, &position, data, dataSize);
+  return (result < 0)? result : block;
+}
+
+/**
+ * Adds the data to the image as a file (labeled data), as writeFile() would write it
+ * (without encryption).
+ */
+int RfidImage::addFile(int initialBlock, const char dataLabel[12], const byte* data, int dataSize) {
+  byte header[16];
+  EasyMFRC522::fillFileHeader(header, dataLabel, 0, dataSize);
+
+  int block = initialBlock;
+  int position = 0;
+  int result = _put(&block, &position, header, 16);
+  if (result >= 0 && dataSize > 0) {
+    block ++;
+    position = 0;
+    result = _put(&block, &position, data, dataSize);
+  }
+  return (result < 0)? result : block;
+}
+
+/**
+ * Adds the dictionary with the given entries to the image, as RfidDictionaryView (or
+ * RfidStaticDictionary) would write it, starting in "startBlock". Keys and values are
+ * C strings, which cannot contain '\n'.
+ */
+int RfidImage::addDictionary(int startBlock, const char* keys[], const char* values[], int numEntries) {
+  int dataSize = 0;
+  for (int i = 0; i < numEntries; i ++) {
+    dataSize += strlen(keys[i]) + strlen(values[i]) + 2;
+  }
+
+  byte header[16];
+  EasyMFRC522::fillFileHeader(header, "_rfiddict_", 0, dataSize);
+
+  int block = startBlock;
+  int position = 0;
+  int result = _put(&block, &position, header, 16);
+  if (result >= 0 && dataSize > 0) {
+    block ++;
+    position = 0;
+  }
+
+  const byte newLine = '\n';
+  for (int i = 0; i < numEntries && result >= 0; i ++) {
+    result = _put(&block, &position, (const byte*)keys[i], strlen(keys[i]));
+    if (result >= 0) result = _put(&block, &position, &newLine, 1);
+    if (result >= 0) result = _put(&block, &position, (const byte*)values[i], strlen(values[i]));
+    if (result >= 0) result = _put(&block, &position, &newLine, 1);
+  }
+  return (result < 0)? result : block;
+}
+
+int RfidImage::getNumSectors() const {
+  int sectors = 0;
+  for (int i = 0; i < this->numBlocks; i ++) {
+    if (i == 0 || easyMfrc522SectorOf(this->blocks[i].block) != easyMfrc522SectorOf(this->blocks[i-1].block)) {
+      sectors ++;
+    }
+  }
+  return sectors;
+}
+
+// Finds the entry of the block, or inserts a new one (with 0s) in its sorted position.
+// Returns NULL if the image is full.
+RfidImageBlock* RfidImage::_blockEntry(int block) {
+  int index = 0;
+  while (index < this->numBlocks && this->blocks[index].block < block) {
+    index ++;
+  }
+  if (index < this->numBlocks && this->blocks[index].block == block) {
+    return &this->blocks[index];
+  }
+
+  if (this->numBlocks == this->maxBlocks) {
+    return NULL;
+  }
+  for (int i = this->numBlocks; i > index; i --) {
+    this->blocks[i] = this->blocks[i-1];
+  }
+  this->numBlocks ++;
+  this->blocks[index].block = block;
+  memset(this->blocks[index].data, 0, 16);
+  return &this->blocks[index];
+}
+
+// Puts the data in the image, from the position of the cursor (block, position) on, and
+// advances the cursor. At the end, the cursor is in the last block used, whose bytes after
+// the data are set to 0 (as writeRaw() writes whole blocks).
+int RfidImage::_put(int* block, int* position, const byte* data, int size) {
+  RfidImageBlock* entry = NULL;
+  for (int i = 0; i < size; i ++) {
+    if (*position == 16) {
+      (*block) ++;
+      *position = 0;
+    }
+    while (!isDataBlock(*block)) {
+      (*block) ++;
+    }
+    if (*block > EASY_MFRC522_MAX_BLOCK) {
+      return -3201;
+    }
+
+    entry = _blockEntry(*block);
+    if (entry == NULL) {
+      return -3202;
+    }
+    entry->data[*position] = data[i];
+    (*position) ++;
+  }
+  if (entry != NULL) {
+    memset(entry->data + *position, 0, 16 - *position);
+  }
+
+  // the cursor must point to a data block, even if no data was put
+  while (!isDataBlock(*block)) {
+    (*block) ++;
+  }
+  return 0;
+}
+
+
+/*
+ * ERROR CODES of the functions that add data to the image:
+ *
+ * -3201 : the data doesn't fit in the tag (from the initial block on)
+ * -3202 : the image is full (there is no room for more blocks)
+ */
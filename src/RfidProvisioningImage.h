@@ -0,0 +1,76 @@
+
+#ifndef __RFID_PROVISIONING_IMAGE___
+#define __RFID_PROVISIONING_IMAGE___
+
+#include <EasyMFRC522.h>
+
+/**
+ * One block of an image: its number in the tag and its content.
+ */
+struct RfidImageBlock {
+    byte block;
+    byte data[16];
+};
+
+/**
+ * A pre-built image of the content of the tag, for writing the same data to many tags
+ * (e.g. when issuing new badges), with EasyMFRC522::applyImage(). The data is laid out
+ * in blocks only once, when building the image, exactly as the corresponding functions
+ * of EasyMFRC522 (or of RfidDictionaryView) would write it. The blocks are kept sorted,
+ * so that the image is applied sector by sector, with one authentication per sector.
+ *
+ * This class doesn't have storage for the blocks; use RfidProvisioningImage, below.
+ *
+ * Example:
+ *   RfidProvisioningImage<8> image;
+ *   image.addFile(1, "name", (byte*)"Pablo", 6);
+ *   image.addFile(8, "level", &level, 1);
+ *   ...
+ *   rfidReader.applyImage(image, RFID_IMAGE_VERIFY);  // for each tag
+ *
+ * The functions to add data return the last block used, or a negative number (see the
+ * list in the end of the .cpp). Files with encryption are not supported, because the
+ * encryption is different in each tag.
+ */
+class RfidImage {
+private:
+    RfidImageBlock* blocks;  // sorted by the number of the block
+    int maxBlocks;
+    int numBlocks;
+
+public:
+    RfidImage(RfidImageBlock* blocksStorage, int maxBlocks);
+
+    void clear();
+
+    int addRaw(int initialBlock, const byte* data, int dataSize);
+    int addFile(int initialBlock, const char dataLabel[12], const byte* data, int dataSize);
+    int addDictionary(int startBlock, const char* keys[], const char* values[], int numEntries);
+
+    inline int getNumBlocks() const {
+        return this->numBlocks;
+    }
+    inline const RfidImageBlock& getBlock(int index) const {
+        return this->blocks[index];
+    }
+    int getNumSectors() const;   // number of authentications needed to apply the image
+
+private:
+    RfidImageBlock* _blockEntry(int block);
+    int _put(int* block, int* position, const byte* data, int size);
+};
+
+/**
+ * An image with storage for up to MAX_BLOCKS blocks (17 bytes each).
+ */
+template <int MAX_BLOCKS>
+class RfidProvisioningImage : public RfidImage {
+private:
+    RfidImageBlock storage[MAX_BLOCKS];
+
+public:
+    RfidProvisioningImage() : RfidImage(storage, MAX_BLOCKS) {
+    }
+};
+
+#endif
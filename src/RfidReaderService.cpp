@@ -0,0 +1,307 @@
+#include "RfidReaderService.h"
+
+#ifdef RFID_READER_SERVICE_AVAILABLE
+
+#if !defined(ESP32)
+  #include <chrono>
+#endif
+
+/*
+ * The service has a single task that uses the EasyMFRC522 (the consumer), and any number
+ * of tasks that submit requests (the producers). The requests go from the producers to
+ * the consumer through the lock-free queue; all other state of the service (e.g. the
+ * list of pending requests) is used only by the consumer. The results go back through
+ * the request itself: the consumer writes the result and then sets the atomic flag
+ * "done" (with release semantics), so a producer that sees the flag also sees the result.
+ *
+ * In each iteration, the task takes all the requests in the queue and, if there is some
+ * request pending, tries to detect a tag. If a tag is detected, all pending requests
+ * that accept this tag are served, including the ones that arrive in the meantime
+ * (a single RF session). Pending requests whose timeout is over are completed with error,
+ * in every iteration. The task sleeps when no request was served (e.g. no tag, or only a
+ * tag that no request accepts, which is detected again in each iteration).
+ *
+ * The producers that are inside submit() are counted in "submitters". When the service
+ * is stopped, the task waits for them to leave before the final drain of the queue, so a 
+ * request pushed by a producer that saw the service running is never left behind.
+ */
+
+// sleeps the current task/thread for about 1 ms (1 tick in FreeRTOS), leaving the CPU to the others
+static void sleepOneMs() {
+#if defined(ESP32)
+  vTaskDelay(1);
+#else
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+}
+
+
+//---- REQUESTS ---------------------------------------------------------//
+
+void RfidRequest::setDetect() {
+  this->type = RFID_REQUEST_DETECT;
+  this->data = NULL;
+  this->size = 0;
+  this->done.store(false);
+}
+
+void RfidRequest::setRead(int initialBlock, byte* buffer, int bufferSize) {
+  this->type = RFID_REQUEST_READ;
+  this->block = initialBlock;
+  this->data = buffer;
+  this->size = bufferSize;
+  this->done.store(false);
+}
+
+void RfidRequest::setWrite(int initialBlock, byte* data, int dataSize) {
+  this->type = RFID_REQUEST_WRITE;
+  this->block = initialBlock;
+  this->data = data;
+  this->size = dataSize;
+  this->done.store(false);
+}
+
+void RfidRequest::setReadFile(int initialBlock, const char* label, byte* buffer, int bufferSize) {
+  this->type = RFID_REQUEST_READ_FILE;
+  this->block = initialBlock;
+  this->label = label;
+  this->data = buffer;
+  this->size = bufferSize;
+  this->done.store(false);
+}
+
+void RfidRequest::setWriteFile(int initialBlock, const char* label, byte* data, int dataSize) {
+  this->type = RFID_REQUEST_WRITE_FILE;
+  this->block = initialBlock;
+  this->label = label;
+  this->data = data;
+  this->size = dataSize;
+  this->done.store(false);
+}
+
+/**
+ * Waits until the request is done, or until the given time (in ms) has passed.
+ * Returns true if the request is done.
+ */
+bool RfidRequest::wait(unsigned long maxWaitTime) {
+  unsigned long waited = 0;
+  while (!isDone()) {
+    if (waited >= maxWaitTime) {
+      return false;
+    }
+    sleepOneMs();
+    waited ++;
+  }
+  return true;
+}
+
+
+//---- SERVICE ----------------------------------------------------------//
+
+RfidReaderService::RfidReaderService(EasyMFRC522* rfidDevice)
+  : running(false), finished(true), submitters(0)
+{
+  this->device = rfidDevice;
+  this->numPending = 0;
+#if defined(ESP32)
+  this->task = NULL;
+#endif
+}
+
+RfidReaderService::~RfidReaderService() {
+  stop();
+}
+
+/**
+ * Creates the task (or thread) of the service. The EasyMFRC522 must be already
+ * initialized.
+ */
+bool RfidReaderService::start(int stackSize, int priority, int core) {
+  if (this->running.load()) {
+    return false;
+  }
+  this->running.store(true);
+  this->finished.store(false);
+
+#if defined(ESP32)
+  if (xTaskCreatePinnedToCore(_taskEntry, "rfid_service", stackSize, this, priority, &this->task, core) != pdPASS) {
+    this->running.store(false);
+    this->finished.store(true);
+    return false;
+  }
+#else
+  (void)stackSize; (void)priority; (void)core;
+  this->thread = std::thread(_taskEntry, this);
+#endif
+  return true;
+}
+
+/**
+ * Stops the service, waiting for the end of the current operation. Requests not served
+ * are completed with error -3302.
+ */
+void RfidReaderService::stop() {
+  this->running.store(false);
+#if defined(ESP32)
+  while (!this->finished.load()) {
+    sleepOneMs();
+  }
+  this->task = NULL;
+#else
+  if (this->thread.joinable()) {
+    this->thread.join();
+  }
+#endif
+}
+
+bool RfidReaderService::submit(RfidRequest* request) {
+  this->submitters.fetch_add(1);
+  if (!this->running.load()) {
+    this->submitters.fetch_sub(1);
+    return false;
+  }
+  request->done.store(false);
+  bool pushed = this->queue.push(request);
+  this->submitters.fetch_sub(1);
+  return pushed;
+}
+
+void RfidReaderService::_taskEntry(void* service) {
+  RfidReaderService* self = (RfidReaderService*)service;
+  self->_run();
+  self->finished.store(true);
+#if defined(ESP32)
+  vTaskDelete(NULL);
+#endif
+}
+
+void RfidReaderService::_run() {
+  while (this->running.load()) {
+    _collect();
+
+    bool served = (this->numPending > 0) && _serveSession();
+    _expire();
+    if (!served) {
+      sleepOneMs();
+    }
+  }
+
+  // completes the requests not served (after the last submit() that saw the service running)
+  while (this->submitters.load() > 0) {
+    sleepOneMs();
+  }
+  _collect();
+  while (this->numPending > 0) {
+    _complete(0, -3302);
+  }
+  RfidRequest* request;
+  while (this->queue.pop(request)) {
+    request->result = -3302;
+    request->done.store(true, std::memory_order_release);
+  }
+}
+
+// Moves the requests from the queue to the list of pending requests (while it has room).
+void RfidReaderService::_collect() {
+  RfidRequest* request;
+  while (this->numPending < RFID_SERVICE_QUEUE_SIZE && this->queue.pop(request)) {
+    request->startTime = millis();
+    this->pending[this->numPending ++] = request;
+  }
+}
+
+// Detects a tag and serves all pending requests that accept it. Returns false if no request
+// was served (no tag was detected, or no request accepts the tag detected).
+bool RfidReaderService::_serveSession() {
+  if (!this->device->detectTag()) {
+    return false;
+  }
+
+  const MFRC522::Uid& tagUid = this->device->getMFRC522()->uid;
+  bool servedAny = false;
+  bool served = true;
+
+  while (served) {
+    served = false;
+    for (int i = 0; i < this->numPending; ) {
+      RfidRequest* request = this->pending[i];
+      if (request->uid.size == 0 || EasyMFRC522::isSameUid(request->uid, tagUid)) {
+        _execute(request);
+        _complete(i, request->result);  // removes it from the list (the next one takes the index i)
+        served = true;
+        servedAny = true;
+      } else {
+        i ++;
+      }
+    }
+    _collect();  // the requests that arrived during the session are served in the same session
+  }
+
+  this->device->unselectMifareTag(true);
+  return servedAny;
+}
+
+void RfidReaderService::_execute(RfidRequest* request) {
+  request->uid = this->device->getMFRC522()->uid;
+
+  switch (request->type) {
+  case RFID_REQUEST_DETECT:
+    request->result = 0;
+    break;
+  case RFID_REQUEST_READ:
+    request->result = this->device->readRaw(request->block, request->data, request->size);
+    break;
+  case RFID_REQUEST_WRITE:
+    request->result = this->device->writeRaw(request->block, request->data, request->size);
+    break;
+  case RFID_REQUEST_READ_FILE:
+    request->result = this->device->readFile(request->block, request->label, request->data, request->size);
+    break;
+  case RFID_REQUEST_WRITE_FILE:
+    request->result = this->device->writeFile(request->block, request->label, request->data, request->size);
+    break;
+  default:
+    request->result = -3303;
+  }
+}
+
+// Gives the result to the pending request of the given index, and removes it from the list.
+void RfidReaderService::_complete(int index, int result) {
+  RfidRequest* request = this->pending[index];
+
+  this->numPending --;
+  for (int i = index; i < this->numPending; i ++) {
+    this->pending[i] = this->pending[i+1];
+  }
+
+  request->result = result;
+  if (request->callback != NULL) {
+    request->callback(request, request->context);
+  }
+  request->done.store(true, std::memory_order_release);
+}
+
+// Completes (with error) the pending requests whose timeouts are over.
+void RfidReaderService::_expire() {
+  unsigned long now = millis();
+  for (int i = 0; i < this->numPending; ) {
+    RfidRequest* request = this->pending[i];
+    if (now - request->startTime >= request->timeout) {
+      _complete(i, -3301);
+    } else {
+      i ++;
+    }
+  }
+}
+
+#endif  // RFID_READER_SERVICE_AVAILABLE
+
+
+/*
+ * ERROR CODES of the service (given in RfidRequest::result, besides the error codes of
+ * the operations of EasyMFRC522):
+ *
+ * -3301 : no tag (accepted by the request) was detected before the timeout of the request
+ * -3302 : the service was stopped before serving the request
+ * -3303 : invalid type of request
+ */
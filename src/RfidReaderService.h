@@ -0,0 +1,200 @@
+
+#ifndef __RFID_READER_SERVICE___
+#define __RFID_READER_SERVICE___
+
+#include <EasyMFRC522.h>
+
+// the service needs threads and atomic operations, so it is only available in these platforms
+#if defined(ESP32) || defined(__linux__)
+
+#define RFID_READER_SERVICE_AVAILABLE
+
+#include <atomic>
+
+#if defined(ESP32)
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+#else
+  #include <thread>
+#endif
+
+#ifndef RFID_SERVICE_QUEUE_SIZE
+#define RFID_SERVICE_QUEUE_SIZE  16   // must be a power of 2
+#endif
+
+/**
+ * Bounded lock-free queue, for many producers (threads/tasks) and a single consumer
+ * (based on the bounded queue of D. Vyukov). The capacity must be a power of 2.
+ * Pushing fails (returns false) when the queue is full, without blocking.
+ */
+template <typename T, unsigned int CAPACITY>
+class RfidLockFreeQueue {
+private:
+    struct Cell {
+        std::atomic<unsigned int> sequence;
+        T data;
+    };
+    Cell cells[CAPACITY];
+    std::atomic<unsigned int> enqueuePos;
+    unsigned int dequeuePos;   // used only by the consumer
+
+public:
+    RfidLockFreeQueue() : enqueuePos(0), dequeuePos(0) {
+        for (unsigned int i = 0; i < CAPACITY; i ++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // may be called by any thread
+    bool push(const T& item) {
+        unsigned int pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & (CAPACITY - 1)];
+            int diff = (int)(cell->sequence.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // must be called only by the consumer
+    bool pop(T& item) {
+        Cell* cell = &cells[dequeuePos & (CAPACITY - 1)];
+        int diff = (int)(cell->sequence.load(std::memory_order_acquire) - (dequeuePos + 1));
+        if (diff < 0) {
+            return false;  // empty
+        }
+        item = cell->data;
+        cell->sequence.store(dequeuePos + CAPACITY, std::memory_order_release);
+        dequeuePos ++;
+        return true;
+    }
+};
+
+
+enum RfidRequestType {
+    RFID_REQUEST_DETECT,      // just detects a tag (and gives its UID)
+    RFID_REQUEST_READ,        // readRaw()
+    RFID_REQUEST_WRITE,       // writeRaw()
+    RFID_REQUEST_READ_FILE,   // readFile()
+    RFID_REQUEST_WRITE_FILE   // writeFile()
+};
+
+struct RfidRequest;
+typedef void (*RfidRequestCallback)(RfidRequest* request, void* context);
+
+/**
+ * A request to the RfidReaderService. It is filled with one of the set...() functions,
+ * then submitted to the service. It works as a "future": the application may wait for
+ * the result (with wait() or isDone()), or be notified by a callback, which is called
+ * in the task of the service.
+ *
+ * The request (and its data) must be kept allocated until it is done.
+ */
+struct RfidRequest {
+    RfidRequestType type;
+    int block;
+    const char* label;        // for files only
+    byte* data;               // data to write, or buffer to read
+    int size;                 // size of the data to write, or capacity of the buffer
+    unsigned long timeout;    // time (ms) waiting for a tag
+    MFRC522::Uid uid;         // UID of the tag required (size 0: any tag); when done, the UID of the tag used
+    RfidRequestCallback callback;
+    void* context;
+
+    // filled by the service
+    int result;               // the result of the operation of EasyMFRC522, or an error of the service
+    unsigned long startTime;
+    std::atomic<bool> done;
+
+    RfidRequest() : type(RFID_REQUEST_DETECT), block(0), label(NULL), data(NULL), size(0), timeout(5000),
+                    callback(NULL), context(NULL), result(0), startTime(0), done(false) {
+        uid.size = 0;
+    }
+
+    void setDetect();
+    void setRead(int initialBlock, byte* buffer, int bufferSize);
+    void setWrite(int initialBlock, byte* data, int dataSize);
+    void setReadFile(int initialBlock, const char* label, byte* buffer, int bufferSize);
+    void setWriteFile(int initialBlock, const char* label, byte* data, int dataSize);
+
+    // restricts the request to the tag with the given UID (by default, any tag is used)
+    inline void setTargetUid(const MFRC522::Uid& tagUid) {
+        this->uid = tagUid;
+    }
+    inline void setCallback(RfidRequestCallback function, void* functionContext = NULL) {
+        this->callback = function;
+        this->context = functionContext;
+    }
+
+    inline bool isDone() {
+        return this->done.load(std::memory_order_acquire);
+    }
+    bool wait(unsigned long maxWaitTime = 0xFFFFFFFF);
+};
+
+
+/**
+ * Owns an EasyMFRC522 in a dedicated task (FreeRTOS) or thread (Linux), serving the
+ * requests of other tasks/threads. The requests are passed through a bounded lock-free
+ * queue, so submit() never blocks.
+ *
+ * Requests that are pending together (for the same tag, or for any tag) are served in a
+ * single RF session: the tag is detected once, all of them are executed, and the tag is
+ * unselected after that. Requests for other tags wait for their tags (up to their timeouts).
+ *
+ * After start(), the EasyMFRC522 must not be used directly by the application (it is not
+ * thread-safe), until stop() is called.
+ */
+class RfidReaderService {
+private:
+    EasyMFRC522* device;
+    RfidLockFreeQueue<RfidRequest*, RFID_SERVICE_QUEUE_SIZE> queue;
+    RfidRequest* pending[RFID_SERVICE_QUEUE_SIZE];  // requests already taken from the queue (used only by the task)
+    int numPending;
+    std::atomic<bool> running;
+    std::atomic<bool> finished;
+    std::atomic<int> submitters;   // threads/tasks inside submit()
+
+#if defined(ESP32)
+    TaskHandle_t task;
+#else
+    std::thread thread;
+#endif
+
+public:
+    RfidReaderService(EasyMFRC522* rfidDevice);
+    virtual ~RfidReaderService();
+
+    bool start(int stackSize = 4096, int priority = 1, int core = 1);  // stackSize, priority and core are used only in the ESP32
+    void stop();
+    inline bool isRunning() {
+        return this->running.load();
+    }
+
+    // called by any thread; returns false if the queue is full or the service is not running
+    bool submit(RfidRequest* request);
+
+private:
+    static void _taskEntry(void* service);
+    void _run();
+    void _collect();
+    bool _serveSession();
+    void _execute(RfidRequest* request);
+    void _complete(int index, int result);
+    void _expire();
+};
+
+#endif  // ESP32 || __linux__
+
+#endif
@@ -0,0 +1,222 @@
+#include "RfidRecord.h"
+
+/*
+ * The record is stored as a data chunk written with EasyMFRC522::writeRaw(), so it is
+ * split in "logical blocks" of 16 bytes (the logical block i holds the bytes 16*i to
+ * 16*i+15 of the record), which are mapped to the physical blocks of the tag skipping
+ * the special blocks (see EasyMFRC522::getBlockOfOffset()).
+ */
+
+RfidRecord::RfidRecord(EasyMFRC522* rfidDevice, int startBlock, const RfidField* fields, byte numFields) {
+  this->device = rfidDevice;
+  this->startBlock = startBlock;
+  this->fields = fields;
+  this->numFields = numFields;
+  this->recordSize = 0;
+  for (int i = 0; i < numFields; i ++) {
+    int fieldEnd = fields[i].offset + fields[i].size;
+    if (fieldEnd > this->recordSize) {
+      this->recordSize = fieldEnd;
+    }
+  }
+}
+
+bool RfidRecord::isLayoutValid() {
+  for (int i = 0; i < this->numFields; i ++) {
+    unsigned short size = this->fields[i].size;
+    switch (this->fields[i].type) {
+      case RFID_FIELD_INT8:
+      case RFID_FIELD_UINT8:
+        if (size != 1) return false;
+        break;
+      case RFID_FIELD_INT16:
+      case RFID_FIELD_UINT16:
+        if (size != 2) return false;
+        break;
+      case RFID_FIELD_INT32:
+      case RFID_FIELD_UINT32:
+      case RFID_FIELD_FLOAT:
+        if (size != 4) return false;
+        break;
+      default:
+        if (size == 0) return false;
+        break;
+    }
+  }
+  return true;
+}
+
+// Returns the index of the field in the layout, or -1.
+int RfidRecord::findField(const char* name) {
+  for (int i = 0; i < this->numFields; i ++) {
+    if (strcmp(this->fields[i].name, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Reads only the blocks where the field is stored, and copies the field to "valueOut"
+ * (that must have room for the size of the field).
+ * 
+ * Returns: negative number -- error
+ *          positive number -- the size of the field
+ */
+int RfidRecord::readField(const char* name, void* valueOut) {
+  int index = findField(name);
+  if (index < 0) {
+    return -4001;
+  }
+  const RfidField& field = this->fields[index];
+  byte* output = (byte*)valueOut;
+
+  int firstLogical = field.offset / 16;
+  int lastLogical = (field.offset + field.size - 1) / 16;
+
+  for (int lb = firstLogical; lb <= lastLogical; lb ++) {
+    int physicalBlock = this->device->getBlockOfOffset(this->startBlock, lb*16);
+    if (physicalBlock < 0) {
+      return -4002;
+    }
+    int result = this->device->readRaw(physicalBlock, this->block, 16);
+    if (result < 0) {
+      return -4100 + result;
+    }
+
+    // copies the intersection of the field with this block
+    int from = (field.offset > lb*16)? field.offset : lb*16;
+    int to = (field.offset + field.size < (lb+1)*16)? field.offset + field.size : (lb+1)*16;
+    for (int pos = from; pos < to; pos ++) {
+      output[pos - field.offset] = this->block[pos - lb*16];
+    }
+  }
+
+  return field.size;
+}
+
+/**
+ * Writes only the blocks where the field is stored. See writeFields().
+ */
+int RfidRecord::writeField(const char* name, const void* value) {
+  const char* names[1] = { name };
+  const void* values[1] = { value };
+  return writeFields(names, values, 1);
+}
+
+/**
+ * Writes the given fields (with values[i] holding the value of the field names[i]),
+ * writing each block involved only once. A block whose 16 bytes are all given by the
+ * fields is written directly; otherwise, the block is read, updated and written back.
+ * 
+ * If the same field appears multiple times, the last value given is written.
+ * 
+ * Returns: negative number -- error (some blocks may have been written)
+ *          zero            -- success
+ */
+int RfidRecord::writeFields(const char* const names[], const void* const values[], byte count) {
+  int firstLogical = -1;
+  int lastLogical = -1;
+
+  for (int i = 0; i < count; i ++) {
+    int index = findField(names[i]);
+    if (index < 0) {
+      return -4001;
+    }
+    int first = this->fields[index].offset / 16;
+    int last = (this->fields[index].offset + this->fields[index].size - 1) / 16;
+    if (firstLogical < 0 || first < firstLogical) {
+      firstLogical = first;
+    }
+    if (last > lastLogical) {
+      lastLogical = last;
+    }
+  }
+
+  for (int lb = firstLogical; lb <= lastLogical; lb ++) {
+    int result = _writeFieldsInBlock(lb, names, values, count);
+    if (result < 0) {
+      return result;
+    }
+  }
+
+  return 0;
+}
+
+int RfidRecord::_writeFieldsInBlock(int logicalBlock, const char* const names[], const void* const values[], byte count) {
+  int blockStart = logicalBlock * 16;
+  uint16_t coveredBytes = 0;  // bit i is set if byte i of the block is given by the fields
+
+  for (int i = 0; i < count; i ++) {
+    const RfidField& field = this->fields[findField(names[i])];
+    for (int pos = field.offset; pos < field.offset + field.size; pos ++) {
+      if (blockStart <= pos && pos < blockStart + 16) {
+        coveredBytes |= ((uint16_t)1 << (pos - blockStart));
+      }
+    }
+  }
+
+  if (coveredBytes == 0) {
+    return 0;  // no field in this block (e.g. fields apart in the record)
+  }
+
+  int physicalBlock = this->device->getBlockOfOffset(this->startBlock, blockStart);
+  if (physicalBlock < 0) {
+    return -4002;
+  }
+
+  int result;
+  if (coveredBytes != 0xFFFF) {
+    result = this->device->readRaw(physicalBlock, this->block, 16);
+    if (result < 0) {
+      return -4100 + result;
+    }
+  }
+
+  // later fields overwrite earlier ones
+  for (int i = 0; i < count; i ++) {
+    const RfidField& field = this->fields[findField(names[i])];
+    const byte* value = (const byte*)values[i];
+    for (int pos = field.offset; pos < field.offset + field.size; pos ++) {
+      if (blockStart <= pos && pos < blockStart + 16) {
+        this->block[pos - blockStart] = value[pos - field.offset];
+      }
+    }
+  }
+
+  result = this->device->writeRaw(physicalBlock, this->block, 16);
+  if (result < 0) {
+    return -4200 + result;
+  }
+  return 0;
+}
+
+/**
+ * Reads/writes the whole record at once (the same as readRaw()/writeRaw()). The read starts
+ * in the first block used by the record, which is not the start block if it is the block 0
+ * (skipped by writeRaw() and by the fields).
+ */
+int RfidRecord::readRecord(void* recordOut) {
+  int firstBlock = this->device->getBlockOfOffset(this->startBlock, 0);
+  if (firstBlock < 0) {
+    return -4002;
+  }
+  int result = this->device->readRaw(firstBlock, (byte*)recordOut, this->recordSize);
+  return (result < 0)? -4100 + result : result;
+}
+
+int RfidRecord::writeRecord(const void* record) {
+  int result = this->device->writeRaw(this->startBlock, (byte*)record, this->recordSize);
+  return (result < 0)? -4200 + result : 0;
+}
+
+
+/**
+ * -----------
+ * ERROR CODES
+ * -----------
+ * -4001 : field not found in the layout
+ * -4002 : the field is beyond the tag's memory
+ * (-4100 + EasyMFRC522::readRaw)  : error when reading a block
+ * (-4200 + EasyMFRC522::writeRaw) : error when writing a block
+ */
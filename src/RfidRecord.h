@@ -0,0 +1,100 @@
+
+#ifndef __RFID_RECORD___
+#define __RFID_RECORD___
+
+#include <stddef.h>
+#include <EasyMFRC522.h>
+
+/**
+ * Types of the fields of a record. The type is used to check the size of the field
+ * (e.g. a RFID_FIELD_INT32 must have 4 bytes); RFID_FIELD_BYTES and RFID_FIELD_STRING
+ * may have any size.
+ */
+enum RfidFieldType {
+    RFID_FIELD_BYTES,
+    RFID_FIELD_STRING,
+    RFID_FIELD_INT8,
+    RFID_FIELD_UINT8,
+    RFID_FIELD_INT16,
+    RFID_FIELD_UINT16,
+    RFID_FIELD_INT32,
+    RFID_FIELD_UINT32,
+    RFID_FIELD_FLOAT
+};
+
+/**
+ * Describes one field of a record: its name, its position (offset) and size in the
+ * record, in bytes, and its type.
+ */
+struct RfidField {
+    const char* name;
+    unsigned short offset;
+    unsigned short size;
+    RfidFieldType type;
+};
+
+// Declares a field with the same name, offset and size of a member of a struct.
+// Example: RFID_FIELD(AccessRecord, time, RFID_FIELD_UINT32)
+#define RFID_FIELD(structType, member, fieldType) \
+    { #member, (unsigned short)offsetof(structType, member), (unsigned short)sizeof(((structType*)0)->member), fieldType }
+
+
+/**
+ * Gives access to the fields of a fixed-layout record (e.g. the contents of a struct)
+ * stored in the tag with EasyMFRC522::writeRaw(), from the given start block. The
+ * layout of the record is given by an array of field descriptions (RfidField).
+ *
+ * The advantage over writeRaw()/readRaw() of the whole record is that only the
+ * physical blocks that hold the field(s) are read/written:
+ * - readField() reads only the blocks where the field is stored
+ * - writeField() writes only the blocks where the field is stored; a block that is
+ *   not fully covered by the field is read first (only that block, not the rest of
+ *   the record), to keep its other bytes
+ * - writeFields() updates many fields, coalescing them per block (i.e. each block
+ *   is written at most once)
+ *
+ * Example:
+ *   const RfidField layout[] = {
+ *     RFID_FIELD(Credentials, personName, RFID_FIELD_STRING),
+ *     RFID_FIELD(Credentials, expireHour, RFID_FIELD_INT16)
+ *   };
+ *   RfidRecord record(&rfidReader, 1, layout, 2);
+ *   record.writeField("expireHour", &hour);
+ *
+ * The layout array (and the names of the fields) must be kept allocated while the
+ * RfidRecord is used. As in EasyMFRC522, the tag must have been detected before.
+ */
+class RfidRecord {
+private:
+    EasyMFRC522* device;
+    int startBlock;
+    const RfidField* fields;
+    byte numFields;
+    int recordSize;
+
+    byte block[16];  // buffer for one block, used in read-modify-write of partially updated blocks
+
+    int _writeFieldsInBlock(int logicalBlock, const char* const names[], const void* const values[], byte count);
+
+public:
+    RfidRecord(EasyMFRC522* rfidDevice, int startBlock, const RfidField* fields, byte numFields);
+
+    // size of the whole record (the maximum offset + size of the fields)
+    inline int getRecordSize() {
+        return this->recordSize;
+    }
+
+    int findField(const char* name);
+
+    int readField(const char* name, void* valueOut);
+    int writeField(const char* name, const void* value);
+    int writeFields(const char* const names[], const void* const values[], byte count);
+
+    int readRecord(void* recordOut);
+    int writeRecord(const void* record);
+
+    // checks if the sizes of the fields are compatible with their types
+    bool isLayoutValid();
+};
+
+#endif
@@ -0,0 +1,616 @@
+
+#ifndef __RFID_STATIC_DICTIONARY___
+#define __RFID_STATIC_DICTIONARY___
+
+#include <EasyMFRC522.h>
+
+/**
+ * Variant of RfidDictionaryView that does no dynamic allocation at all. All the storage
+ * is kept in fixed-size members, sized at compile time by the template parameters:
+ *
+ *   MAX_BYTES   - maximum size of the serialized dictionary (the same format written
+ *                 by RfidDictionaryView: "key\nvalue\n..."), in bytes
+ *   MAX_ENTRIES - maximum number of key-value pairs
+ *
+ * So, the memory used by an instance is a known static number (around MAX_BYTES +
+ * 2*MAX_ENTRIES bytes). Both classes read/write the same data in the tag, so they can
+ * be used interchangeably (as long as the dictionary in the tag fits the capacities).
+ *
+ * If the tag has a log of changes (see RfidDictionaryView::setLogCapacity()), its records
+ * are applied when the dictionary is loaded. This class doesn't append to the log: each
+ * change rewrites the whole dictionary (with the changes of the log), and invalidates the log.
+ * The records of the log are staged in the free part of "data", so a tag with a log needs
+ * MAX_BYTES to hold the dictionary and the longest record of the log.
+ *
+ * Keys and values are null-terminated C strings, which cannot contain '\n'. Instead of
+ * failing silently, the operations return error codes (negative numbers) when the
+ * capacity is exceeded (see the list in the end of this file).
+ *
+ * Example:
+ *   EasyMFRC522 rfidReader(D4, D3);
+ *   RfidStaticDictionary<256, 16> rfidDict(&rfidReader, 1);
+ */
+template <int MAX_BYTES, int MAX_ENTRIES>
+class RfidStaticDictionary {
+private:
+    EasyMFRC522* device;
+    int startBlock;          // Number of block where the dictionary starts
+
+    byte data[MAX_BYTES];    // The dictionary, serialized exactly as stored in the tag
+    int dataSize;            // Used size of "data"
+    unsigned short entryOffset[MAX_ENTRIES];  // Position in "data" where each key starts
+    int numEntries;
+    bool loaded;             // Indicates if the dictionary was already loaded from the currently selected RFID tag
+    MFRC522::Uid tag_uid;    // UID of the tag from where the data were loaded
+    int logBlock;            // Block of the log of changes found after the dictionary (-1 if none)
+
+    // state of the parsing of the log (see _read_log())
+    struct LogParser {
+        RfidStaticDictionary* dict;
+        uint16_t dictCrc;    // CRC-16 of the dictionary file, that must be the one in the log
+        uint16_t crc;        // CRC-16 stored in the log
+        bool ended;          // the end mark was found (or the log belongs to another dictionary)
+        char type;           // type of the current record (0 if none)
+        int recordStart;     // position in "data" where the record is staged
+        int recordEnd;
+        int keyEnd;          // position of the '\n' after the key (-1 if not reached yet)
+        int error;
+    };
+
+public:
+    RfidStaticDictionary(EasyMFRC522* rfidDevice, int startBlock = 1);
+
+    bool detectTag(byte outputTagId[4] = NULL);
+    void disconnectTag(bool allowRedetection = false);
+
+    int set(const char* key, const char* value);
+    int get(const char* key, char* valueOut, int valueOutCapacity);
+
+    int remove(const char* key);
+    bool hasKey(const char* key);
+
+    int getKey(int entryIndex, char* keyOut, int keyOutCapacity);
+    int getNumEntries();
+
+    int getMaxSpaceInTag();
+
+    inline int getCapacityInBytes() {
+        return MAX_BYTES;
+    }
+    inline int getCapacityInEntries() {
+        return MAX_ENTRIES;
+    }
+
+private:
+    int _ensure_loaded();
+    int _read_dictionary();
+    int _write_dictionary();
+    int _read_log(int dictSize, uint16_t dictCrc);
+    void _invalidate_log(int lastDictBlock, uint16_t dictCrc);
+    int _apply_log_record(LogParser* parser);
+    static int _parse_log_chunk(const byte* chunk, int position, int length, void* logParser);
+    int _dict_find(const char* key);
+    int _dict_find(const byte* key, int keyLength);
+    int _string_end(int pos);
+    int _copy_string(int pos, char* output, int outputCapacity);
+};
+
+
+template <int MAX_BYTES, int MAX_ENTRIES>
+RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::RfidStaticDictionary(EasyMFRC522* rfidDevice, int startBlock) {
+  this->device = rfidDevice;
+  this->startBlock = startBlock;
+  this->dataSize = 0;
+  this->numEntries = 0;
+  this->loaded = false;
+  this->tag_uid.size = 0;
+  this->logBlock = -1;
+}
+
+/**
+ * Returns the space in bytes available in the tag for storing the dictionary entries
+ * (not counting space for metadata). The space actually usable is the minimum between
+ * this value and MAX_BYTES.
+ */
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::getMaxSpaceInTag() {
+  // subtracts 16 bytes (1 block), which is the space used by EasyMFRC522 to store file metadata
+  return this->device->getUserDataSpace(this->startBlock) - 16;
+}
+
+//---- RFID **INTERNAL** FUNCTIONS --------------------------------------//
+
+// Returns the position of the '\n' that ends the string starting in "pos".
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_string_end(int pos) {
+  while (pos < this->dataSize && this->data[pos] != '\n') {
+    pos ++;
+  }
+  return pos;
+}
+
+// Copies the string starting in "pos" as a null-terminated string, returning its length.
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_copy_string(int pos, char* output, int outputCapacity) {
+  int end = _string_end(pos);
+  int length = end - pos;
+  if (length + 1 > outputCapacity) {
+    return -3007;
+  }
+  memcpy(output, this->data + pos, length);
+  output[length] = '\0';
+  return length;
+}
+
+/**
+ * Loads the serialized dictionary directly into the "data" array, then indexes the
+ * position of each key.
+ */
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_read_dictionary() {
+  this->dataSize = 0;
+  this->numEntries = 0;
+  this->loaded = false;
+  this->logBlock = -1;
+
+  int result = this->device->readFile(this->startBlock, "_rfiddict_", this->data, MAX_BYTES);
+  bool found = true;
+
+  if (result == -1010 || result == -1011) {
+    // no dictionary in the tag (see the error codes of readFile): it is loaded as an empty dictionary
+    result = 0;
+    found = false;
+  } else if (result == -1020) {
+    return -3003;  // the dictionary in the tag is bigger than MAX_BYTES
+  } else if (result < 0) {
+    return result;
+  }
+
+  // indexes the keys (in even positions of the sequence of strings)
+  bool isKey = true;
+  int stringStart = 0;
+  for (int pos = 0; pos < result; pos ++) {
+    if (this->data[pos] == '\n') {
+      if (isKey) {
+        if (this->numEntries >= MAX_ENTRIES) {
+          this->numEntries = 0;
+          return -3002;
+        }
+        this->entryOffset[this->numEntries] = stringStart;
+        this->numEntries ++;
+      }
+      isKey = !isKey;
+      stringStart = pos + 1;
+    }
+  }
+  uint16_t dictCrc = EasyMFRC522::crc16(0xFFFF, this->data, result);
+  this->dataSize = stringStart;  // discards any incomplete string in the end
+
+  if (found) {
+    int logResult = _read_log(result, dictCrc);
+    if (logResult < 0) {
+      this->dataSize = 0;
+      this->numEntries = 0;
+      return logResult;
+    }
+  }
+
+  // copies the uid of the current tag
+  this->tag_uid = this->device->getMFRC522()->uid;
+
+  this->loaded = true;
+  return 0;
+}
+
+// Writes the dictionary to the tag; assumes the dictionary is loaded.
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_write_dictionary() {
+  // written without parity, as in RfidDictionaryView (the log is located from the size of the file)
+  byte parity = this->device->getFileParity();
+  this->device->setFileParity(0);
+  int result = this->device->writeFile(this->startBlock, "_rfiddict_", this->data, this->dataSize);
+  this->device->setFileParity(parity);
+  if (result < 0) {
+    this->loaded = false;  // forces to reload it in the next operation
+    return result;
+  }
+  _invalidate_log(result, EasyMFRC522::crc16(0xFFFF, this->data, this->dataSize));
+  return 0;
+}
+
+//---- LOG OF CHANGES ---------------------------------------------------//
+
+/*
+ * The log is written by RfidDictionaryView (see "LOG OF CHANGES" in RfidDictionaryView.cpp): 
+ * a file "_rfidlog_" just after the dictionary file, with the CRC-16 of the dictionary file,
+ * the records ('+' key '\n' value '\n' or '-' key '\n') and an end mark. Each record is 
+ * staged in "data", after the dictionary, then applied in place.
+ */
+
+// Reads the log that follows the dictionary file (of the given size and CRC), applying its 
+// records. Returns 0 (also if there is no log), or a negative error code.
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_read_log(int dictSize, uint16_t dictCrc) {
+  if (this->device->getFileCipher() != NULL) {
+    return 0;   //logs are not used with encrypted files
+  }
+
+  int headerBlock = this->device->getBlockOfOffset(this->startBlock, 0);
+  int lastBlock = (dictSize > 0)? this->device->getBlockOfOffset(headerBlock + 1, dictSize - 1) : headerBlock;
+  int block = (lastBlock > 0)? this->device->getBlockOfOffset(lastBlock + 1, 0) : -1;
+  if (block < 0) {
+    return 0;   //no space after the dictionary
+  }
+
+  int fileSize = this->device->readFileSize(block, "_rfidlog_");
+  if (fileSize == -10 || fileSize == -11) {
+    return 0;   //there is no log
+  } else if (fileSize < 0) {
+    return fileSize;
+  }
+
+  LogParser parser;
+  parser.dict = this;
+  parser.dictCrc = dictCrc;
+  parser.crc = 0;
+  parser.ended = false;
+  parser.type = 0;
+  parser.error = 0;
+
+  int result = this->device->readRawStream(this->device->getBlockOfOffset(block + 1, 0), fileSize, _parse_log_chunk, &parser);
+  if (parser.error < 0) {
+    return parser.error;
+  } else if (result < 0 && !parser.ended) {
+    return result;
+  }
+
+  if (parser.crc == dictCrc) {
+    this->logBlock = block;
+  }
+  return 0;
+}
+
+// Sink for readRawStream(): stages and applies each record of the log, until the end mark 
+// is found (then, it returns -1 to stop reading).
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_parse_log_chunk(const byte* chunk, int position, int length, void* logParser) {
+  LogParser* parser = (LogParser*)logParser;
+  RfidStaticDictionary* self = parser->dict;
+
+  for (int i = 0; i < length; i ++) {
+    int pos = position + i;
+    char c = (char)chunk[i];
+
+    if (pos < 2) {
+      parser->crc |= (uint16_t)chunk[i] << (8 * pos);
+      if (pos == 1 && parser->crc != parser->dictCrc) {
+        parser->ended = true;   // the log belongs to an older dictionary: it is ignored
+        return -1;
+      }
+
+    } else if (parser->type == 0) {
+      if (c != '+' && c != '-') {
+        parser->ended = true;   // end mark
+        return -1;
+      }
+      parser->type = c;
+      parser->recordStart = self->dataSize;
+      parser->recordEnd = self->dataSize;
+      parser->keyEnd = -1;
+
+    } else {
+      if (parser->recordEnd >= MAX_BYTES) {
+        parser->error = -3003;
+        return -1;
+      }
+      self->data[parser->recordEnd ++] = chunk[i];
+
+      if (c != '\n') {
+        continue;
+      } else if (parser->keyEnd < 0) {
+        parser->keyEnd = parser->recordEnd - 1;
+        if (parser->type == '+') {
+          continue;
+        }
+      }
+      // the record is complete
+      parser->error = self->_apply_log_record(parser);
+      if (parser->error < 0) {
+        return -1;
+      }
+      parser->type = 0;
+    }
+  }
+  return 0;
+}
+
+// Applies the record staged in "data" (just after the dictionary).
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_apply_log_record(LogParser* parser) {
+  int keyStart = parser->recordStart;
+  int index = _dict_find(this->data + keyStart, parser->keyEnd - keyStart);
+
+  if (parser->type == '-') {
+    if (index >= 0) {
+      int entryStart = this->entryOffset[index];
+      int entryEnd = _string_end(_string_end(entryStart) + 1) + 1;
+      int removed = entryEnd - entryStart;
+      memmove(this->data + entryStart, this->data + entryEnd, this->dataSize - entryEnd);
+      this->dataSize -= removed;
+      for (int i = index; i < this->numEntries - 1; i ++) {
+        this->entryOffset[i] = this->entryOffset[i+1] - removed;
+      }
+      this->numEntries --;
+    }
+
+  } else if (index < 0) {
+    // a new key: the record is already in place, after the last entry
+    if (this->numEntries >= MAX_ENTRIES) {
+      return -3002;
+    }
+    this->entryOffset[this->numEntries] = keyStart;
+    this->numEntries ++;
+    this->dataSize = parser->recordEnd;
+
+  } else {
+    // replaces the value, moving the rest of the dictionary (and the staged record)
+    int newValueStart = parser->keyEnd + 1;
+    int newValueLength = parser->recordEnd - 1 - newValueStart;
+    int valueStart = _string_end(this->entryOffset[index]) + 1;
+    int valueEnd = _string_end(valueStart);
+    int delta = newValueLength - (valueEnd - valueStart);
+    if (parser->recordEnd + delta > MAX_BYTES) {
+      return -3003;
+    }
+    memmove(this->data + valueEnd + delta, this->data + valueEnd, parser->recordEnd - valueEnd);
+    memcpy(this->data + valueStart, this->data + newValueStart + delta, newValueLength);
+    this->dataSize += delta;
+    for (int i = index + 1; i < this->numEntries; i ++) {
+      this->entryOffset[i] += delta;
+    }
+  }
+  return 0;
+}
+
+// After the dictionary is rewritten (ending in the given block), overwrites the CRC of the log 
+// found when loading it (if not overwritten by the dictionary), because its changes are already 
+// in the dictionary, and would be applied again if the new dictionary had the same CRC.
+template <int MAX_BYTES, int MAX_ENTRIES>
+void RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_invalidate_log(int lastDictBlock, uint16_t dictCrc) {
+  if (this->logBlock > lastDictBlock) {
+    byte empty[16] = { 0 };
+    empty[0] = ~dictCrc & 0xFF;
+    empty[1] = ~dictCrc >> 8;
+    this->device->writeRaw(this->device->getBlockOfOffset(this->logBlock + 1, 0), empty, 16);
+  }
+  this->logBlock = -1;
+}
+
+// Finds the index of the entry with the given key; assumes the dictionary is loaded.
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_dict_find(const char* key) {
+  return _dict_find((const byte*)key, strlen(key));
+}
+
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_dict_find(const byte* key, int keyLength) {
+  for (int i = 0; i < this->numEntries; i ++) {
+    int pos = this->entryOffset[i];
+    int k = 0;
+    while (k < keyLength && pos < this->dataSize && this->data[pos] == key[k]) {
+      pos ++;
+      k ++;
+    }
+    if (k == keyLength && pos < this->dataSize && this->data[pos] == '\n') {
+      return i;
+    }
+  }
+  return -1;
+}
+
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::_ensure_loaded() {
+  if (loaded) {
+    // checks the uid of the tag
+    if (! EasyMFRC522::isSameUid(this->tag_uid, this->device->getMFRC522()->uid)) {
+      // the current tag (connected/selected by the device) is different
+      loaded = false;
+    }
+  }
+
+  if (!loaded) { //don't refactor this block as an else!
+    return _read_dictionary();
+  }
+  return 0;
+}
+
+//---- RFID **PUBLIC** FUNCTIONS ----------------------------------------//
+
+/**
+ * Selects and stablishes connection to an RFID tag, like RfidDictionaryView::detectTag().
+ */
+template <int MAX_BYTES, int MAX_ENTRIES>
+bool RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::detectTag(byte outputTagId[4]) {
+  // try at most twice
+  bool tag_detected = this->device->detectTag(outputTagId);
+  if (!tag_detected) {
+    tag_detected = this->device->detectTag(outputTagId);
+  }
+
+  if (tag_detected) {
+    this->loaded = false;  // the data is loaded in the first operation
+  }
+
+  return tag_detected;
+}
+
+template <int MAX_BYTES, int MAX_ENTRIES>
+void RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::disconnectTag(bool allowRedetection) {
+  this->device->unselectMifareTag(allowRedetection);
+  this->loaded = false;
+  this->dataSize = 0;
+  this->numEntries = 0;
+}
+
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::getNumEntries() {
+  int result = _ensure_loaded();
+  if (result < 0) {
+    return result;
+  }
+  return this->numEntries;
+}
+
+/**
+ * Copies the key of the given entry (null-terminated) to "keyOut".
+ * Returns the length of the key, or a negative error code.
+ */
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::getKey(int entryIndex, char* keyOut, int keyOutCapacity) {
+  int result = _ensure_loaded();
+  if (result < 0) {
+    return result;
+  }
+  if (entryIndex < 0 || entryIndex >= this->numEntries) {
+    return -3005;
+  }
+  return _copy_string(this->entryOffset[entryIndex], keyOut, keyOutCapacity);
+}
+
+template <int MAX_BYTES, int MAX_ENTRIES>
+bool RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::hasKey(const char* key) {
+  if (_ensure_loaded() < 0) {
+    return false;
+  }
+  return _dict_find(key) >= 0;
+}
+
+/**
+ * Copies the value associated to the key (null-terminated) to "valueOut".
+ * Returns the length of the value, or a negative error code (e.g. if the key
+ * doesn't exist).
+ */
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::get(const char* key, char* valueOut, int valueOutCapacity) {
+  int result = _ensure_loaded();
+  if (result < 0) {
+    return result;
+  }
+  int index = _dict_find(key);
+  if (index < 0) {
+    return -3005;
+  }
+  int valueStart = _string_end(this->entryOffset[index]) + 1;
+  return _copy_string(valueStart, valueOut, valueOutCapacity);
+}
+
+/**
+ * Removes the key and its value, and writes the dictionary to the tag.
+ * Returns 0 in case of success, or a negative error code.
+ */
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::remove(const char* key) {
+  int result = _ensure_loaded();
+  if (result < 0) {
+    return result;
+  }
+  int index = _dict_find(key);
+  if (index < 0) {
+    return -3005;
+  }
+
+  int entryStart = this->entryOffset[index];
+  int entryEnd = _string_end(_string_end(entryStart) + 1) + 1;  // after the '\n' of the value
+  int removed = entryEnd - entryStart;
+
+  memmove(this->data + entryStart, this->data + entryEnd, this->dataSize - entryEnd);
+  this->dataSize -= removed;
+  for (int i = index; i < this->numEntries - 1; i ++) {
+    this->entryOffset[i] = this->entryOffset[i+1] - removed;
+  }
+  this->numEntries --;
+
+  return _write_dictionary();
+}
+
+/**
+ * If the key exists, overwrites the old value with the new one. Otherwise, the pair
+ * <key : value> is added. Then, the dictionary is written to the tag.
+ * Returns 0 in case of success, or a negative error code. In case of an error
+ * related to capacity, the dictionary is kept unchanged.
+ */
+template <int MAX_BYTES, int MAX_ENTRIES>
+int RfidStaticDictionary<MAX_BYTES, MAX_ENTRIES>::set(const char* key, const char* value) {
+  int result = _ensure_loaded();
+  if (result < 0) {
+    return result;
+  }
+  if (strchr(key, '\n') != NULL || strchr(value, '\n') != NULL) {
+    return -3006;
+  }
+
+  int valueLength = strlen(value);
+  int spaceLimit = getMaxSpaceInTag();
+  if (spaceLimit > MAX_BYTES) {
+    spaceLimit = MAX_BYTES;
+  }
+
+  int index = _dict_find(key);
+
+  if (index >= 0) {
+    // if the key exists, replaces only the value (kept after the key)
+    int valueStart = _string_end(this->entryOffset[index]) + 1;
+    int valueEnd = _string_end(valueStart);
+    int delta = valueLength - (valueEnd - valueStart);
+    if (this->dataSize + delta > spaceLimit) {
+      return (this->dataSize + delta > MAX_BYTES)? -3003 : -3004;
+    }
+
+    memmove(this->data + valueEnd + delta, this->data + valueEnd, this->dataSize - valueEnd);
+    memcpy(this->data + valueStart, value, valueLength);
+    this->dataSize += delta;
+    for (int i = index + 1; i < this->numEntries; i ++) {
+      this->entryOffset[i] += delta;
+    }
+
+  } else {
+    int keyLength = strlen(key);
+    int entrySize = keyLength + valueLength + 2;
+    if (this->numEntries >= MAX_ENTRIES) {
+      return -3002;
+    }
+    if (this->dataSize + entrySize > spaceLimit) {
+      return (this->dataSize + entrySize > MAX_BYTES)? -3003 : -3004;
+    }
+
+    int pos = this->dataSize;
+    this->entryOffset[this->numEntries] = pos;
+    this->numEntries ++;
+    memcpy(this->data + pos, key, keyLength);
+    pos += keyLength;
+    this->data[pos ++] = '\n';
+    memcpy(this->data + pos, value, valueLength);
+    pos += valueLength;
+    this->data[pos ++] = '\n';
+    this->dataSize = pos;
+  }
+
+  return _write_dictionary();
+}
+
+/**
+ * -----------
+ * ERROR CODES
+ * -----------
+ * Besides the error codes of EasyMFRC522::readFile() and EasyMFRC522::writeFile()
+ * (returned when the tag cannot be read or written), the operations may return:
+ *
+ * -3002 : capacity exceeded (more than MAX_ENTRIES entries)
+ * -3003 : capacity exceeded (more than MAX_BYTES bytes, also when applying the log)
+ * -3004 : not enough space in the tag
+ * -3005 : key not found (or invalid entry index)
+ * -3006 : invalid key or value (it contains '\n')
+ * -3007 : the output array is too small for the key or value
+ */
+
+#endif
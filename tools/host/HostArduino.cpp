@@ -0,0 +1,288 @@
+#include <Arduino.h>
+#include <HostArduino.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <random>
+#include <thread>
+
+/*
+ * The Arduino API of the host build (see Arduino.h and HostArduino.h).
+ */
+
+HardwareSerial Serial;
+
+
+//---- CLOCK --------------------------------------------------------------//
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static std::atomic<uint64_t> chargedNanos(0);
+static std::atomic<bool> simulatedClock(false);
+static void (*clockHook)() = NULL;
+
+void hostSetSimulatedClock(bool simulated) {
+  simulatedClock.store(simulated);
+}
+
+bool hostIsSimulatedClock() {
+  return simulatedClock.load();
+}
+
+uint64_t hostNanos() {
+  uint64_t nanos = chargedNanos.load();
+  if (! simulatedClock.load()) {
+    nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+  }
+  return nanos;
+}
+
+void hostAdvanceNanos(uint64_t nanos) {
+  chargedNanos.fetch_add(nanos);
+}
+
+void hostSetClockHook(void (*hook)()) {
+  clockHook = hook;
+}
+
+static void runClockHook() {
+  if (clockHook != NULL) {
+    clockHook();
+  }
+}
+
+unsigned long micros() {
+  return (unsigned long)(hostNanos() / 1000);
+}
+
+unsigned long millis() {
+  return (unsigned long)(hostNanos() / 1000000);
+}
+
+void delay(unsigned long ms) {
+  if (simulatedClock.load()) {
+    hostAdvanceNanos((uint64_t)ms * 1000000);
+  } else {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+  runClockHook();
+}
+
+void delayMicroseconds(unsigned int us) {
+  if (simulatedClock.load()) {
+    hostAdvanceNanos((uint64_t)us * 1000);
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  }
+  runClockHook();
+}
+
+// an iteration of a waiting loop takes about 1 us in the simulated clock
+void yield() {
+  if (simulatedClock.load()) {
+    hostAdvanceNanos(1000);
+  } else {
+    std::this_thread::yield();
+  }
+  runClockHook();
+}
+
+
+//---- PINS AND INTERRUPTS ------------------------------------------------//
+
+static void (*interruptHandlers[256])(void);
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin; (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  (void)pin; (void)value;
+}
+
+int digitalRead(uint8_t pin) {
+  (void)pin;
+  return HIGH;
+}
+
+// a floating analog pin: only noise
+int analogRead(uint8_t pin) {
+  static std::random_device noise;
+  (void)pin;
+  return (int)(noise() & 0x3FF);
+}
+
+int digitalPinToInterrupt(uint8_t pin) {
+  return pin;
+}
+
+void attachInterrupt(int interrupt, void (*handler)(void), int mode) {
+  (void)mode;
+  interruptHandlers[interrupt & 0xFF] = handler;
+}
+
+void detachInterrupt(int interrupt) {
+  interruptHandlers[interrupt & 0xFF] = NULL;
+}
+
+void hostTriggerInterrupt(uint8_t pin) {
+  void (*handler)(void) = interruptHandlers[digitalPinToInterrupt(pin) & 0xFF];
+  if (handler != NULL) {
+    handler();
+  }
+}
+
+void noInterrupts() {
+}
+
+void interrupts() {
+}
+
+
+//---- RANDOM NUMBERS -----------------------------------------------------//
+
+// deterministic, as in the boards (where the sequence is the same after each reset)
+static std::mt19937 generator(1);
+
+long random(long max) {
+  return (max <= 0)? 0 : (long)(generator() % (unsigned long)max);
+}
+
+long random(long min, long max) {
+  return (max <= min)? min : min + random(max - min);
+}
+
+void randomSeed(unsigned long seed) {
+  generator.seed(seed);
+}
+
+
+//---- HEAP ---------------------------------------------------------------//
+
+// each block allocated has a header with its size (the header keeps the alignment of "new")
+static const size_t HEAP_HEADER = 16;
+static std::atomic<long> usedHeap(0);
+static std::atomic<long> peakHeap(0);
+
+long hostUsedHeap() {
+  return usedHeap.load();
+}
+
+long hostPeakHeap() {
+  return peakHeap.load();
+}
+
+void hostResetPeakHeap() {
+  peakHeap.store(usedHeap.load());
+}
+
+static void* heapAllocate(size_t size) {
+  char* block = (char*)malloc(size + HEAP_HEADER);
+  if (block == NULL) {
+    throw std::bad_alloc();
+  }
+  *(size_t*)block = size;
+  long used = usedHeap.fetch_add((long)size) + (long)size;
+  long peak = peakHeap.load();
+  while (used > peak && ! peakHeap.compare_exchange_weak(peak, used)) {
+  }
+  return block + HEAP_HEADER;
+}
+
+static void heapFree(void* pointer) {
+  if (pointer == NULL) {
+    return;
+  }
+  char* block = (char*)pointer - HEAP_HEADER;
+  usedHeap.fetch_sub((long)*(size_t*)block);
+  free(block);
+}
+
+void* operator new(size_t size) {
+  return heapAllocate(size);
+}
+
+void* operator new[](size_t size) {
+  return heapAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+  heapFree(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  heapFree(pointer);
+}
+
+void operator delete(void* pointer, size_t size) noexcept {
+  (void)size;
+  heapFree(pointer);
+}
+
+void operator delete[](void* pointer, size_t size) noexcept {
+  (void)size;
+  heapFree(pointer);
+}
+
+
+//---- STRING, PRINT AND STREAM -------------------------------------------//
+
+void String::trim() {
+  size_t first = 0;
+  while (first < s.size() && isspace((unsigned char)s[first])) {
+    first ++;
+  }
+  size_t last = s.size();
+  while (last > first && isspace((unsigned char)s[last - 1])) {
+    last --;
+  }
+  s = s.substr(first, last - first);
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (size --) {
+    written += write(*buffer ++);
+  }
+  return written;
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char digits[8 * sizeof(long) + 1];
+  char* p = &digits[sizeof(digits) - 1];
+  *p = '\0';
+  if (base < 2) {
+    base = 10;
+  }
+  do {
+    int digit = value % base;
+    *--p = (char)((digit < 10)? '0' + digit : 'A' + digit - 10);
+    value /= base;
+  } while (value > 0);
+  return write(p);
+}
+
+size_t Print::print(long value, int base) {
+  if (value < 0 && base == DEC) {
+    return print('-') + print((unsigned long)(-value), base);
+  }
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[64];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return write(text);
+}
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = read();
+    if (c < 0) {
+      break;
+    }
+    buffer[count ++] = (uint8_t)c;
+  }
+  return count;
+}
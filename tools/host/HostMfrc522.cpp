@@ -0,0 +1,517 @@
+#include <MFRC522.h>
+
+/*
+ * The functions of Balboa's MFRC522 class (version 1.4.8) used by EasyMFRC522, doing the
+ * same accesses to the registers of the MFRC522, in the same order. The only difference
+ * is PICC_Select(), that handles only the cascade level 1 (i.e. UIDs of 4 bytes, as the
+ * ones of the simulated tags).
+ */
+
+MFRC522::MFRC522(byte chipSelectPin, byte resetPowerDownPin) {
+  _chipSelectPin = chipSelectPin;
+  _resetPowerDownPin = resetPowerDownPin;
+  uid.size = 0;
+  uid.sak = 0;
+}
+
+
+//---- REGISTERS ----------------------------------------------------------//
+
+void MFRC522::PCD_WriteRegister(PCD_Register reg, byte value) {
+  SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));
+  digitalWrite(_chipSelectPin, LOW);
+  SPI.transfer(reg);
+  SPI.transfer(value);
+  digitalWrite(_chipSelectPin, HIGH);
+  SPI.endTransaction();
+}
+
+void MFRC522::PCD_WriteRegister(PCD_Register reg, byte count, byte* values) {
+  SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));
+  digitalWrite(_chipSelectPin, LOW);
+  SPI.transfer(reg);
+  for (byte index = 0; index < count; index ++) {
+    SPI.transfer(values[index]);
+  }
+  digitalWrite(_chipSelectPin, HIGH);
+  SPI.endTransaction();
+}
+
+byte MFRC522::PCD_ReadRegister(PCD_Register reg) {
+  byte value;
+  SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));
+  digitalWrite(_chipSelectPin, LOW);
+  SPI.transfer(0x80 | reg);
+  value = SPI.transfer(0);
+  digitalWrite(_chipSelectPin, HIGH);
+  SPI.endTransaction();
+  return value;
+}
+
+void MFRC522::PCD_ReadRegister(PCD_Register reg, byte count, byte* values, byte rxAlign) {
+  if (count == 0) {
+    return;
+  }
+  byte address = 0x80 | reg;
+  byte index = 0;
+  SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));
+  digitalWrite(_chipSelectPin, LOW);
+  count --;
+  SPI.transfer(address);
+  if (rxAlign) {
+    // only the bits from position rxAlign on are updated in values[0]
+    byte mask = (0xFF << rxAlign) & 0xFF;
+    byte value = SPI.transfer(address);
+    values[0] = (values[0] & ~mask) | (value & mask);
+    index ++;
+  }
+  while (index < count) {
+    values[index] = SPI.transfer(address);
+    index ++;
+  }
+  values[index] = SPI.transfer(0);
+  digitalWrite(_chipSelectPin, HIGH);
+  SPI.endTransaction();
+}
+
+void MFRC522::PCD_SetRegisterBitMask(PCD_Register reg, byte mask) {
+  byte tmp = PCD_ReadRegister(reg);
+  PCD_WriteRegister(reg, tmp | mask);
+}
+
+void MFRC522::PCD_ClearRegisterBitMask(PCD_Register reg, byte mask) {
+  byte tmp = PCD_ReadRegister(reg);
+  PCD_WriteRegister(reg, tmp & (~mask));
+}
+
+// Uses the CRC coprocessor of the MFRC522 (polling DivIrqReg for the end of the command).
+MFRC522::StatusCode MFRC522::PCD_CalculateCRC(byte* data, byte length, byte* result) {
+  PCD_WriteRegister(CommandReg, PCD_Idle);
+  PCD_WriteRegister(DivIrqReg, 0x04);          // clears the CRCIRq bit
+  PCD_WriteRegister(FIFOLevelReg, 0x80);
+  PCD_WriteRegister(FIFODataReg, length, data);
+  PCD_WriteRegister(CommandReg, PCD_CalcCRC);
+
+  for (uint16_t i = 5000; i > 0; i --) {
+    byte n = PCD_ReadRegister(DivIrqReg);
+    if (n & 0x04) {
+      PCD_WriteRegister(CommandReg, PCD_Idle);
+      result[0] = PCD_ReadRegister(CRCResultRegL);
+      result[1] = PCD_ReadRegister(CRCResultRegH);
+      return STATUS_OK;
+    }
+  }
+  return STATUS_TIMEOUT;
+}
+
+
+//---- MFRC522 ------------------------------------------------------------//
+
+void MFRC522::PCD_Init() {
+  pinMode(_chipSelectPin, OUTPUT);
+  digitalWrite(_chipSelectPin, HIGH);
+  PCD_Reset();
+
+  PCD_WriteRegister(TxModeReg, 0x00);
+  PCD_WriteRegister(RxModeReg, 0x00);
+  PCD_WriteRegister(ModWidthReg, 0x26);
+
+  // timer of 25ms, started at the end of each transmission (TAuto)
+  PCD_WriteRegister(TModeReg, 0x80);
+  PCD_WriteRegister(TPrescalerReg, 0xA9);
+  PCD_WriteRegister(TReloadRegH, 0x03);
+  PCD_WriteRegister(TReloadRegL, 0xE8);
+
+  PCD_WriteRegister(TxASKReg, 0x40);
+  PCD_WriteRegister(ModeReg, 0x3D);
+  PCD_AntennaOn();
+}
+
+void MFRC522::PCD_Reset() {
+  PCD_WriteRegister(CommandReg, PCD_SoftReset);
+  uint8_t count = 0;
+  do {
+    delay(50);
+  } while ((PCD_ReadRegister(CommandReg) & (1 << 4)) && (++ count) < 3);
+}
+
+void MFRC522::PCD_AntennaOn() {
+  byte value = PCD_ReadRegister(TxControlReg);
+  if ((value & 0x03) != 0x03) {
+    PCD_WriteRegister(TxControlReg, value | 0x03);
+  }
+}
+
+void MFRC522::PCD_AntennaOff() {
+  PCD_ClearRegisterBitMask(TxControlReg, 0x03);
+}
+
+
+//---- PICC ---------------------------------------------------------------//
+
+MFRC522::StatusCode MFRC522::PCD_TransceiveData(byte* sendData, byte sendLen, byte* backData, byte* backLen, byte* validBits, byte rxAlign, bool checkCRC) {
+  byte waitIRq = 0x30;   // RxIRq and IdleIRq
+  return PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, sendData, sendLen, backData, backLen, validBits, rxAlign, checkCRC);
+}
+
+MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(byte command, byte waitIRq, byte* sendData, byte sendLen, byte* backData, byte* backLen, byte* validBits, byte rxAlign, bool checkCRC) {
+  byte txLastBits = validBits? *validBits : 0;
+  byte bitFraming = (rxAlign << 4) + txLastBits;
+
+  PCD_WriteRegister(CommandReg, PCD_Idle);
+  PCD_WriteRegister(ComIrqReg, 0x7F);
+  PCD_WriteRegister(FIFOLevelReg, 0x80);
+  PCD_WriteRegister(FIFODataReg, sendLen, sendData);
+  PCD_WriteRegister(BitFramingReg, bitFraming);
+  PCD_WriteRegister(CommandReg, command);
+  if (command == PCD_Transceive) {
+    PCD_SetRegisterBitMask(BitFramingReg, 0x80);   // StartSend
+  }
+
+  uint16_t i;
+  for (i = 2000; i > 0; i --) {
+    byte n = PCD_ReadRegister(ComIrqReg);
+    if (n & waitIRq) {
+      break;
+    }
+    if (n & 0x01) {
+      return STATUS_TIMEOUT;
+    }
+  }
+  if (i == 0) {
+    return STATUS_TIMEOUT;
+  }
+
+  byte errorRegValue = PCD_ReadRegister(ErrorReg);
+  if (errorRegValue & 0x13) {   // BufferOvfl ParityErr ProtocolErr
+    return STATUS_ERROR;
+  }
+
+  byte _validBits = 0;
+  if (backData && backLen) {
+    byte n = PCD_ReadRegister(FIFOLevelReg);
+    if (n > *backLen) {
+      return STATUS_NO_ROOM;
+    }
+    *backLen = n;
+    PCD_ReadRegister(FIFODataReg, n, backData, rxAlign);
+    _validBits = PCD_ReadRegister(ControlReg) & 0x07;
+    if (validBits) {
+      *validBits = _validBits;
+    }
+  }
+
+  if (errorRegValue & 0x08) {   // CollErr
+    return STATUS_COLLISION;
+  }
+
+  if (backData && backLen && checkCRC) {
+    if (*backLen == 1 && _validBits == 4) {
+      return STATUS_MIFARE_NACK;
+    }
+    if (*backLen < 2 || _validBits != 0) {
+      return STATUS_CRC_WRONG;
+    }
+    byte controlBuffer[2];
+    StatusCode status = PCD_CalculateCRC(&backData[0], *backLen - 2, &controlBuffer[0]);
+    if (status != STATUS_OK) {
+      return status;
+    }
+    if ((backData[*backLen - 2] != controlBuffer[0]) || (backData[*backLen - 1] != controlBuffer[1])) {
+      return STATUS_CRC_WRONG;
+    }
+  }
+
+  return STATUS_OK;
+}
+
+MFRC522::StatusCode MFRC522::PICC_RequestA(byte* bufferATQA, byte* bufferSize) {
+  return PICC_REQA_or_WUPA(PICC_CMD_REQA, bufferATQA, bufferSize);
+}
+
+MFRC522::StatusCode MFRC522::PICC_WakeupA(byte* bufferATQA, byte* bufferSize) {
+  return PICC_REQA_or_WUPA(PICC_CMD_WUPA, bufferATQA, bufferSize);
+}
+
+MFRC522::StatusCode MFRC522::PICC_REQA_or_WUPA(byte command, byte* bufferATQA, byte* bufferSize) {
+  if (bufferATQA == NULL || *bufferSize < 2) {
+    return STATUS_NO_ROOM;
+  }
+  PCD_ClearRegisterBitMask(CollReg, 0x80);   // ValuesAfterColl=1
+  byte validBits = 7;                         // short frame
+  StatusCode status = PCD_TransceiveData(&command, 1, bufferATQA, bufferSize, &validBits);
+  if (status != STATUS_OK) {
+    return status;
+  }
+  if (*bufferSize != 2 || validBits != 0) {
+    return STATUS_ERROR;
+  }
+  return STATUS_OK;
+}
+
+/**
+ * Selects a tag, with the anticollision loop of ISO 14443-3 (cascade level 1 only). If
+ * "validBits" is not 0, the first bits of the UID are given in "uid" (e.g. all 32 bits,
+ * to select a known tag).
+ */
+MFRC522::StatusCode MFRC522::PICC_Select(Uid* uid, byte validBits) {
+  byte buffer[9];   // SEL, NVB, 4 bytes of UID, BCC and CRC_A
+  byte currentLevelKnownBits = (validBits > 32)? 32 : validBits;
+  StatusCode result;
+
+  PCD_ClearRegisterBitMask(CollReg, 0x80);
+
+  buffer[0] = PICC_CMD_SEL_CL1;
+  for (byte i = 0; i < 4; i ++) {
+    buffer[2 + i] = (i < (currentLevelKnownBits + 7) / 8)? uid->uidByte[i] : 0;
+  }
+
+  byte* responseBuffer;
+  byte responseLength;
+  byte txLastBits;
+  bool selectDone = false;
+
+  while (! selectDone) {
+    byte bufferUsed;
+    if (currentLevelKnownBits >= 32) {
+      // SELECT, with the whole UID
+      buffer[1] = 0x70;
+      buffer[6] = buffer[2] ^ buffer[3] ^ buffer[4] ^ buffer[5];
+      result = PCD_CalculateCRC(buffer, 7, &buffer[7]);
+      if (result != STATUS_OK) {
+        return result;
+      }
+      txLastBits = 0;
+      bufferUsed = 9;
+      responseBuffer = &buffer[6];
+      responseLength = 3;
+    } else {
+      // ANTICOLLISION, with the bits known so far
+      txLastBits = currentLevelKnownBits % 8;
+      byte count = currentLevelKnownBits / 8;
+      byte index = 2 + count;
+      buffer[1] = (index << 4) + txLastBits;
+      bufferUsed = index + (txLastBits? 1 : 0);
+      responseBuffer = &buffer[index];
+      responseLength = sizeof(buffer) - index;
+    }
+
+    byte rxAlign = txLastBits;
+    PCD_WriteRegister(BitFramingReg, (rxAlign << 4) + txLastBits);
+
+    result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign);
+    if (result == STATUS_COLLISION) {
+      byte valueOfCollReg = PCD_ReadRegister(CollReg);
+      if (valueOfCollReg & 0x20) {   // CollPosNotValid
+        return STATUS_COLLISION;
+      }
+      byte collisionPos = valueOfCollReg & 0x1F;
+      if (collisionPos == 0) {
+        collisionPos = 32;
+      }
+      if (collisionPos <= currentLevelKnownBits) {
+        return STATUS_INTERNAL_ERROR;
+      }
+      // chooses the tags with the bit 1 in the position of the collision
+      currentLevelKnownBits = collisionPos;
+      byte count = currentLevelKnownBits % 8;
+      byte checkBit = (currentLevelKnownBits - 1) % 8;
+      byte index = 1 + (currentLevelKnownBits / 8) + (count? 1 : 0);
+      buffer[index] |= (1 << checkBit);
+    } else if (result != STATUS_OK) {
+      return result;
+    } else if (currentLevelKnownBits >= 32) {
+      selectDone = true;
+    } else {
+      currentLevelKnownBits = 32;   // the whole UID was received: SELECT in the next iteration
+    }
+  }
+
+  for (byte i = 0; i < 4; i ++) {
+    uid->uidByte[i] = buffer[2 + i];
+  }
+  uid->size = 4;
+
+  // the response to SELECT is the SAK, with its CRC_A
+  if (responseLength != 3 || txLastBits != 0) {
+    return STATUS_ERROR;
+  }
+  result = PCD_CalculateCRC(responseBuffer, 1, &buffer[2]);
+  if (result != STATUS_OK) {
+    return result;
+  }
+  if ((buffer[2] != responseBuffer[1]) || (buffer[3] != responseBuffer[2])) {
+    return STATUS_CRC_WRONG;
+  }
+
+  uid->sak = responseBuffer[0];
+  return STATUS_OK;
+}
+
+MFRC522::StatusCode MFRC522::PICC_HaltA() {
+  byte buffer[4];
+  buffer[0] = PICC_CMD_HLTA;
+  buffer[1] = 0;
+  StatusCode result = PCD_CalculateCRC(buffer, 2, &buffer[2]);
+  if (result != STATUS_OK) {
+    return result;
+  }
+  // the tag doesn't answer (a timeout is the success)
+  result = PCD_TransceiveData(buffer, sizeof(buffer), NULL, 0);
+  if (result == STATUS_TIMEOUT) {
+    return STATUS_OK;
+  }
+  if (result == STATUS_OK) {
+    return STATUS_ERROR;
+  }
+  return result;
+}
+
+
+//---- MIFARE -------------------------------------------------------------//
+
+MFRC522::StatusCode MFRC522::PCD_Authenticate(byte command, byte blockAddr, MIFARE_Key* key, Uid* uid) {
+  byte waitIRq = 0x10;   // IdleIRq
+  byte sendData[12];
+  sendData[0] = command;
+  sendData[1] = blockAddr;
+  for (byte i = 0; i < MF_KEY_SIZE; i ++) {
+    sendData[2 + i] = key->keyByte[i];
+  }
+  // the last 4 bytes of the UID
+  for (byte i = 0; i < 4; i ++) {
+    sendData[8 + i] = uid->uidByte[i + uid->size - 4];
+  }
+  return PCD_CommunicateWithPICC(PCD_MFAuthent, waitIRq, &sendData[0], sizeof(sendData));
+}
+
+void MFRC522::PCD_StopCrypto1() {
+  PCD_ClearRegisterBitMask(Status2Reg, 0x08);   // MFCrypto1On
+}
+
+MFRC522::StatusCode MFRC522::MIFARE_Read(byte blockAddr, byte* buffer, byte* bufferSize) {
+  if (buffer == NULL || *bufferSize < 18) {
+    return STATUS_NO_ROOM;
+  }
+  buffer[0] = PICC_CMD_MF_READ;
+  buffer[1] = blockAddr;
+  StatusCode result = PCD_CalculateCRC(buffer, 2, &buffer[2]);
+  if (result != STATUS_OK) {
+    return result;
+  }
+  return PCD_TransceiveData(buffer, 4, buffer, bufferSize, NULL, 0, true);
+}
+
+MFRC522::StatusCode MFRC522::MIFARE_Write(byte blockAddr, byte* buffer, byte bufferSize) {
+  if (buffer == NULL || bufferSize < 16) {
+    return STATUS_INVALID;
+  }
+  byte cmdBuffer[2];
+  cmdBuffer[0] = PICC_CMD_MF_WRITE;
+  cmdBuffer[1] = blockAddr;
+  StatusCode result = PCD_MIFARE_Transceive(cmdBuffer, 2);
+  if (result != STATUS_OK) {
+    return result;
+  }
+  return PCD_MIFARE_Transceive(buffer, 16);
+}
+
+MFRC522::StatusCode MFRC522::MIFARE_Decrement(byte blockAddr, int32_t delta) {
+  return MIFARE_TwoStepHelper(PICC_CMD_MF_DECREMENT, blockAddr, delta);
+}
+
+MFRC522::StatusCode MFRC522::MIFARE_Increment(byte blockAddr, int32_t delta) {
+  return MIFARE_TwoStepHelper(PICC_CMD_MF_INCREMENT, blockAddr, delta);
+}
+
+MFRC522::StatusCode MFRC522::MIFARE_Restore(byte blockAddr) {
+  return MIFARE_TwoStepHelper(PICC_CMD_MF_RESTORE, blockAddr, 0L);
+}
+
+MFRC522::StatusCode MFRC522::MIFARE_TwoStepHelper(byte command, byte blockAddr, int32_t data) {
+  byte cmdBuffer[2];
+  cmdBuffer[0] = command;
+  cmdBuffer[1] = blockAddr;
+  StatusCode result = PCD_MIFARE_Transceive(cmdBuffer, 2);
+  if (result != STATUS_OK) {
+    return result;
+  }
+  // the tag doesn't answer the operand (a timeout is the success)
+  return PCD_MIFARE_Transceive((byte*)&data, 4, true);
+}
+
+MFRC522::StatusCode MFRC522::MIFARE_Transfer(byte blockAddr) {
+  byte cmdBuffer[2];
+  cmdBuffer[0] = PICC_CMD_MF_TRANSFER;
+  cmdBuffer[1] = blockAddr;
+  return PCD_MIFARE_Transceive(cmdBuffer, 2);
+}
+
+MFRC522::StatusCode MFRC522::PCD_MIFARE_Transceive(byte* sendData, byte sendLen, bool acceptTimeout) {
+  byte cmdBuffer[18];
+  if (sendData == NULL || sendLen > 16) {
+    return STATUS_INVALID;
+  }
+  memcpy(cmdBuffer, sendData, sendLen);
+  StatusCode result = PCD_CalculateCRC(cmdBuffer, sendLen, &cmdBuffer[sendLen]);
+  if (result != STATUS_OK) {
+    return result;
+  }
+  sendLen += 2;
+
+  byte waitIRq = 0x30;
+  byte cmdBufferSize = sizeof(cmdBuffer);
+  byte validBits = 0;
+  result = PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, cmdBuffer, sendLen, cmdBuffer, &cmdBufferSize, &validBits);
+  if (acceptTimeout && result == STATUS_TIMEOUT) {
+    return STATUS_OK;
+  }
+  if (result != STATUS_OK) {
+    return result;
+  }
+  // the answer must be a 4-bit ACK
+  if (cmdBufferSize != 1 || validBits != 4) {
+    return STATUS_ERROR;
+  }
+  if (cmdBuffer[0] != MF_ACK) {
+    return STATUS_MIFARE_NACK;
+  }
+  return STATUS_OK;
+}
+
+MFRC522::PICC_Type MFRC522::PICC_GetType(byte sak) {
+  sak &= 0x7F;
+  switch (sak) {
+  case 0x04: return PICC_TYPE_NOT_COMPLETE;
+  case 0x09: return PICC_TYPE_MIFARE_MINI;
+  case 0x08: return PICC_TYPE_MIFARE_1K;
+  case 0x18: return PICC_TYPE_MIFARE_4K;
+  case 0x00: return PICC_TYPE_MIFARE_UL;
+  case 0x10:
+  case 0x11: return PICC_TYPE_MIFARE_PLUS;
+  case 0x01: return PICC_TYPE_TNP3XXX;
+  case 0x20: return PICC_TYPE_ISO_14443_4;
+  case 0x40: return PICC_TYPE_ISO_18092;
+  default:   return PICC_TYPE_UNKNOWN;
+  }
+}
+
+
+//---- CONVENIENCE --------------------------------------------------------//
+
+bool MFRC522::PICC_IsNewCardPresent() {
+  byte bufferATQA[2];
+  byte bufferSize = sizeof(bufferATQA);
+
+  PCD_WriteRegister(TxModeReg, 0x00);
+  PCD_WriteRegister(RxModeReg, 0x00);
+  PCD_WriteRegister(ModWidthReg, 0x26);
+
+  StatusCode result = PICC_RequestA(bufferATQA, &bufferSize);
+  return (result == STATUS_OK || result == STATUS_COLLISION);
+}
+
+bool MFRC522::PICC_ReadCardSerial() {
+  StatusCode result = PICC_Select(&uid);
+  return (result == STATUS_OK);
+}
@@ -0,0 +1,769 @@
+#include <SPI.h>
+#include <HostArduino.h>
+#include <SimMfrc522.h>
+
+/*
+ * The simulated MFRC522 (see SimMfrc522.h), and the SPI bus of the host, connected to it.
+ */
+
+SimMfrc522 simMfrc522;
+SPIClass SPI;
+
+void SPIClass::beginTransaction(SPISettings settings) {
+  simMfrc522.select(settings.clock);
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  return simMfrc522.transfer(data);
+}
+
+void SPIClass::endTransaction() {
+  simMfrc522.deselect();
+}
+
+
+// registers (addresses not shifted)
+#define REG_COMMAND     0x01
+#define REG_COM_IEN     0x02
+#define REG_DIV_IEN     0x03
+#define REG_COM_IRQ     0x04
+#define REG_DIV_IRQ     0x05
+#define REG_ERROR       0x06
+#define REG_STATUS2     0x08
+#define REG_FIFO_DATA   0x09
+#define REG_FIFO_LEVEL  0x0A
+#define REG_CONTROL     0x0C
+#define REG_BIT_FRAMING 0x0D
+#define REG_COLL        0x0E
+#define REG_TX_CONTROL  0x14
+#define REG_CRC_H       0x21
+#define REG_CRC_L       0x22
+#define REG_T_MODE      0x2A
+#define REG_T_PRESCALER 0x2B
+#define REG_T_RELOAD_H  0x2C
+#define REG_T_RELOAD_L  0x2D
+#define REG_VERSION     0x37
+
+// commands
+#define CMD_IDLE        0x00
+#define CMD_CALC_CRC    0x03
+#define CMD_TRANSCEIVE  0x0C
+#define CMD_MF_AUTHENT  0x0E
+#define CMD_SOFT_RESET  0x0F
+
+// bits of ComIrqReg
+#define IRQ_RX     0x20
+#define IRQ_IDLE   0x10
+#define IRQ_TIMER  0x01
+
+#define ETU_NANOS  9440   // 128 / 13.56 MHz
+
+#define MF_ACK   0x0A
+#define MF_NAK   0x04
+
+void simCrcA(const byte* data, int length, byte* result) {
+  uint16_t crc = 0x6363;
+  for (int i = 0; i < length; i ++) {
+    byte b = data[i] ^ (byte)(crc & 0xFF);
+    b ^= (byte)(b << 4);
+    crc = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ ((uint16_t)b >> 4);
+  }
+  result[0] = (byte)(crc & 0xFF);
+  result[1] = (byte)(crc >> 8);
+}
+
+static bool hasCrcA(const byte* frame, int length) {
+  if (length < 3) {
+    return false;
+  }
+  byte crc[2];
+  simCrcA(frame, length - 2, crc);
+  return frame[length - 2] == crc[0] && frame[length - 1] == crc[1];
+}
+
+// time of a frame in the air: 9 etu per byte (8 bits and parity), plus start and end of frame
+static uint64_t frameNanos(int length, byte lastBits) {
+  if (length <= 0) {
+    return 0;
+  }
+  uint64_t bits = (lastBits == 0)? length * 9 : (length - 1) * 9 + lastBits;
+  return (bits + 2) * ETU_NANOS;
+}
+
+static bool isValueBlock(const byte* block) {
+  for (int i = 0; i < 4; i ++) {
+    if (block[i] != block[i + 8] || block[i] != (byte)~block[i + 4]) {
+      return false;
+    }
+  }
+  return block[12] == block[14] && block[13] == block[15] && block[12] == (byte)~block[13];
+}
+
+static void writeValue(byte* block, int32_t value, byte addr) {
+  for (int i = 0; i < 4; i ++) {
+    block[i] = block[i + 8] = (byte)(value >> (8*i));
+    block[i + 4] = ~block[i];
+  }
+  block[12] = block[14] = addr;
+  block[13] = block[15] = ~addr;
+}
+
+
+//---- TAGS ---------------------------------------------------------------//
+
+SimTag::SimTag(uint32_t uidValue, byte sakValue) : present(true) {
+  for (int i = 0; i < 4; i ++) {
+    this->uid[i] = (byte)(uidValue >> (24 - 8*i));
+  }
+  this->sak = sakValue;
+  for (int i = 0; i < 256; i ++) {
+    this->readFailures[i] = 0;
+  }
+  this->writesBeforeLeaving = -1;
+  this->authFailures = 0;
+  format();
+  powerOff();
+}
+
+void SimTag::format() {
+  memset(this->memory, 0, sizeof(this->memory));
+  for (int i = 0; i < 4; i ++) {
+    this->memory[0][i] = this->uid[i];
+  }
+  this->memory[0][4] = uid[0] ^ uid[1] ^ uid[2] ^ uid[3];
+  this->memory[0][5] = this->sak;
+  this->memory[0][6] = 0x04;
+  this->memory[0][7] = 0x00;
+
+  const byte trailer[16] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x80, 0x69, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+  for (int block = 0; block <= lastBlock(); block ++) {
+    if (isTrailer(block)) {
+      memcpy(this->memory[block], trailer, 16);
+    }
+  }
+}
+
+void SimTag::powerOff() {
+  this->state = IDLE;
+  this->wasHalted = false;
+  this->authSector = -1;
+  this->pendingCommand = 0;
+}
+
+int SimTag::lastBlock() {
+  if (this->sak == SIM_TAG_MINI) {
+    return 19;
+  } else if (this->sak == SIM_TAG_4K) {
+    return 255;
+  }
+  return 63;
+}
+
+int SimTag::sectorOf(int block) {
+  return (block < 128)? block / 4 : 32 + (block - 128) / 16;
+}
+
+bool SimTag::isTrailer(int block) {
+  return (block < 128)? (block % 4 == 3) : (block % 16 == 15);
+}
+
+
+//---- CHIP ---------------------------------------------------------------//
+
+SimMfrc522::SimMfrc522() {
+  this->numTags = 0;
+  this->irqPin = 0xFF;
+  this->spiByteNanos = 2000;
+  this->spiCount = 0;
+  _reset();
+  resetCounters();
+}
+
+void SimMfrc522::_reset() {
+  memset(this->regs, 0, sizeof(this->regs));
+  this->regs[REG_COM_IEN] = 0x80;
+  this->regs[REG_COM_IRQ] = 0x14;
+  this->regs[REG_CONTROL] = 0x10;
+  this->regs[REG_TX_CONTROL] = 0x80;   // antenna off
+  this->regs[REG_CRC_H] = 0xFF;
+  this->regs[REG_CRC_L] = 0xFF;
+  this->fifoLength = 0;
+  this->fifoPosition = 0;
+  this->busy = false;
+  this->irqAsserted = false;
+  for (int i = 0; i < this->numTags; i ++) {
+    this->tags[i]->powerOff();
+  }
+}
+
+void SimMfrc522::addTag(SimTag* tag) {
+  if (this->numTags < MAX_TAGS) {
+    this->tags[this->numTags ++] = tag;
+  }
+}
+
+void SimMfrc522::removeTags() {
+  this->numTags = 0;
+}
+
+void SimMfrc522::setIrqPin(byte pin) {
+  this->irqPin = pin;
+}
+
+void SimMfrc522::resetCounters() {
+  this->spiTransactions = 0;
+  this->spiBytes = 0;
+  this->spiPolls = 0;
+  this->spiNanos = 0;
+  this->rfFrames = 0;
+  this->rfNanos = 0;
+  this->timeouts = 0;
+  this->authentications = 0;
+  this->blockReads = 0;
+  this->blockWrites = 0;
+}
+
+void SimMfrc522::select(uint32_t spiClock) {
+  this->spiByteNanos = 8000000000ULL / spiClock;
+  this->spiCount = 0;
+  this->spiTransactions ++;
+  this->spiNanos += this->timing.spiOverheadNanos;
+  hostAdvanceNanos(this->timing.spiOverheadNanos);
+}
+
+void SimMfrc522::deselect() {
+  if (this->spiRead && this->spiCount == 2 && (this->spiFirstAddress == REG_COM_IRQ || this->spiFirstAddress == REG_DIV_IRQ)) {
+    this->spiPolls ++;
+  }
+  this->spiCount = 0;
+}
+
+// The first byte of a transaction has the address (MSB = 1 for reading). When reading, the
+// value of the register comes in the next byte, while the next address is sent; when
+// writing, all the other bytes are written to the same register.
+uint8_t SimMfrc522::transfer(uint8_t value) {
+  hostAdvanceNanos(this->spiByteNanos);
+  this->spiBytes ++;
+  this->spiNanos += this->spiByteNanos;
+  update();
+
+  if (this->spiCount ++ == 0) {
+    this->spiRead = (value & 0x80) != 0;
+    this->spiAddress = (value >> 1) & 0x3F;
+    this->spiFirstAddress = this->spiAddress;
+    return 0;
+  }
+  if (this->spiRead) {
+    byte result = _readRegister(this->spiAddress);
+    this->spiAddress = (value >> 1) & 0x3F;
+    return result;
+  }
+  _writeRegister(this->spiAddress, value);
+  return 0;
+}
+
+byte SimMfrc522::_readRegister(byte reg) {
+  switch (reg) {
+  case REG_FIFO_DATA:
+    if (this->fifoPosition < this->fifoLength) {
+      return this->fifo[this->fifoPosition ++];
+    }
+    return 0;
+  case REG_FIFO_LEVEL:
+    return (byte)(this->fifoLength - this->fifoPosition);
+  case REG_VERSION:
+    return 0x92;
+  default:
+    return this->regs[reg];
+  }
+}
+
+void SimMfrc522::_writeRegister(byte reg, byte value) {
+  switch (reg) {
+  case REG_COMMAND:
+    if ((value & 0x0F) == CMD_SOFT_RESET) {
+      _reset();
+      return;
+    }
+    this->regs[REG_COMMAND] = value;
+    _startCommand(value & 0x0F);
+    return;
+
+  case REG_COM_IRQ:
+  case REG_DIV_IRQ:
+    // bit 7 tells if the bits marked are set (1) or cleared (0)
+    if (value & 0x80) {
+      this->regs[reg] |= value & 0x7F;
+    } else {
+      this->regs[reg] &= ~value;
+    }
+    _updateIrq();
+    return;
+
+  case REG_FIFO_LEVEL:
+    if (value & 0x80) {   // FlushBuffer
+      this->fifoLength = 0;
+      this->fifoPosition = 0;
+      this->regs[REG_ERROR] &= ~0x10;
+    }
+    return;
+
+  case REG_FIFO_DATA:
+    if (this->fifoLength < (int)sizeof(this->fifo)) {
+      this->fifo[this->fifoLength ++] = value;
+    } else {
+      this->regs[REG_ERROR] |= 0x10;   // BufferOvfl
+    }
+    return;
+
+  case REG_BIT_FRAMING:
+    this->regs[REG_BIT_FRAMING] = value & 0x7F;
+    if ((value & 0x80) && (this->regs[REG_COMMAND] & 0x0F) == CMD_TRANSCEIVE) {
+      _startTransceive();
+    }
+    return;
+
+  case REG_TX_CONTROL: {
+    bool wasOn = _antennaOn();
+    this->regs[REG_TX_CONTROL] = value;
+    if (wasOn && ! _antennaOn()) {
+      for (int i = 0; i < this->numTags; i ++) {
+        this->tags[i]->powerOff();
+      }
+    }
+    return;
+  }
+
+  case REG_COM_IEN:
+  case REG_DIV_IEN:
+    this->regs[reg] = value;
+    _updateIrq();
+    return;
+
+  default:
+    this->regs[reg] = value;
+  }
+}
+
+bool SimMfrc522::_antennaOn() {
+  return (this->regs[REG_TX_CONTROL] & 0x03) != 0;
+}
+
+// The timer started at the end of each transmission (if TAuto is set in TModeReg)
+uint64_t SimMfrc522::_timeoutNanos() {
+  if ((this->regs[REG_T_MODE] & 0x80) == 0) {
+    return 0;   // no timer: the command never ends
+  }
+  uint64_t prescaler = ((uint64_t)(this->regs[REG_T_MODE] & 0x0F) << 8) | this->regs[REG_T_PRESCALER];
+  uint64_t reload = ((uint64_t)this->regs[REG_T_RELOAD_H] << 8) | this->regs[REG_T_RELOAD_L];
+  return (reload + 1) * (2 * prescaler + 1) * 1000 / 13560;   // fc = 13.56 MHz
+}
+
+void SimMfrc522::_startCommand(byte command) {
+  this->busy = false;   // any command in progress is cancelled
+
+  if (command == CMD_CALC_CRC) {
+    int length = this->fifoLength - this->fifoPosition;
+    byte crc[2];
+    simCrcA(this->fifo + this->fifoPosition, length, crc);
+    this->fifoLength = this->fifoPosition = 0;
+    this->resultIsCrc = true;
+    this->resultData[0] = crc[0];
+    this->resultData[1] = crc[1];
+    this->resultLength = 0;
+    this->resultError = 0;
+    _finish((uint64_t)this->timing.crcNanosPerByte * (length + 1), 0x04);   // CRCIRq, in DivIrqReg
+
+  } else if (command == CMD_MF_AUTHENT) {
+    _startAuthent();
+  }
+  // Transceive starts with StartSend (see BitFramingReg); Idle just stops the command
+}
+
+// Schedules the end of the command (after the given time), with the given interrupt bits.
+void SimMfrc522::_finish(uint64_t nanos, byte irq) {
+  this->busy = true;
+  this->completionTime = hostNanos() + nanos;
+  this->resultIrq = irq;
+}
+
+void SimMfrc522::update() {
+  if (! this->busy || hostNanos() < this->completionTime) {
+    return;
+  }
+  this->busy = false;
+
+  if (this->resultIsCrc) {
+    this->regs[REG_CRC_L] = this->resultData[0];
+    this->regs[REG_CRC_H] = this->resultData[1];
+    this->regs[REG_DIV_IRQ] |= this->resultIrq;
+  } else {
+    for (int i = 0; i < this->resultLength && this->fifoLength < (int)sizeof(this->fifo); i ++) {
+      this->fifo[this->fifoLength ++] = this->resultData[i];
+    }
+    this->regs[REG_ERROR] = this->resultError;
+    this->regs[REG_COLL] = (this->regs[REG_COLL] & 0x80) | this->resultColl;
+    this->regs[REG_CONTROL] = (this->regs[REG_CONTROL] & 0xF8) | this->resultLastBits;
+    this->regs[REG_COM_IRQ] |= this->resultIrq;
+    if (this->resultIrq & IRQ_IDLE) {
+      this->regs[REG_COMMAND] &= 0xF0;   // the command is over (MFAuthent)
+    }
+  }
+  _updateIrq();
+}
+
+// The IRQ pin is active while an enabled interrupt bit is set; the interrupt is fired
+// on its activation.
+void SimMfrc522::_updateIrq() {
+  bool active = (this->regs[REG_COM_IRQ] & this->regs[REG_COM_IEN] & 0x7F) != 0
+             || (this->regs[REG_DIV_IRQ] & this->regs[REG_DIV_IEN] & 0x14) != 0;
+  if (active && ! this->irqAsserted && this->irqPin != 0xFF) {
+    this->irqAsserted = true;
+    hostTriggerInterrupt(this->irqPin);
+  }
+  this->irqAsserted = active;
+}
+
+void SimMfrc522::_startTransceive() {
+  byte frame[64];
+  int length = this->fifoLength - this->fifoPosition;
+  memcpy(frame, this->fifo + this->fifoPosition, length);
+  this->fifoLength = this->fifoPosition = 0;
+
+  byte txLastBits = this->regs[REG_BIT_FRAMING] & 0x07;
+  uint64_t txNanos = frameNanos(length, txLastBits);
+
+  byte answerLastBits = 0;
+  int collisionBit = -1;
+  uint64_t tagNanos = 0;
+  int answerLength = _antennaOn()? _answer(frame, length, txLastBits, this->resultData, &answerLastBits, &collisionBit, &tagNanos) : -1;
+
+  this->resultIsCrc = false;
+  this->resultColl = 0;
+  this->resultError = 0;
+  this->rfFrames ++;
+
+  uint64_t nanos;
+  if (answerLength < 0) {
+    this->resultLength = 0;
+    this->resultLastBits = 0;
+    this->timeouts ++;
+    uint64_t timeout = _timeoutNanos();
+    nanos = txNanos + timeout;
+    if (timeout > 0) {
+      _finish(nanos, IRQ_TIMER);
+    } else {
+      this->busy = false;   // without the timer, no interrupt ever comes
+    }
+  } else {
+    this->resultLength = answerLength;
+    this->resultLastBits = answerLastBits;
+    if (collisionBit >= 0) {
+      this->resultError = 0x08;                       // CollErr
+      this->resultColl = (byte)((collisionBit + 1) & 0x1F);  // CollPos (0 means the 32nd bit)
+    }
+    nanos = txNanos + this->timing.fdtNanos + tagNanos + frameNanos(answerLength, answerLastBits);
+    _finish(nanos, IRQ_RX);
+  }
+  this->rfNanos += nanos;
+}
+
+// MFAuthent: the 12 bytes in the FIFO are the command (key A or B), the block, the key
+// and the last 4 bytes of the UID. Takes the 4 frames of the three pass authentication.
+void SimMfrc522::_startAuthent() {
+  byte data[12];
+  int length = this->fifoLength - this->fifoPosition;
+  memset(data, 0, sizeof(data));
+  memcpy(data, this->fifo + this->fifoPosition, (length < 12)? length : 12);
+  this->fifoLength = this->fifoPosition = 0;
+
+  this->resultIsCrc = false;
+  this->resultLength = 0;
+  this->resultLastBits = 0;
+  this->resultColl = 0;
+  this->resultError = 0;
+  this->authentications ++;
+  this->rfFrames += 2;
+
+  uint64_t frames = frameNanos(4, 0) + this->timing.fdtNanos + frameNanos(4, 0)
+                  + this->timing.fdtNanos + frameNanos(8, 0);
+
+  SimTag* tag = NULL;
+  for (int i = 0; i < this->numTags; i ++) {
+    if (this->tags[i]->present && this->tags[i]->state == SimTag::ACTIVE && memcmp(this->tags[i]->uid, data + 8, 4) == 0) {
+      tag = this->tags[i];
+    }
+  }
+
+  bool success = false;
+  if (tag != NULL && _antennaOn() && data[1] <= tag->lastBlock()) {
+    int sector = tag->sectorOf(data[1]);
+    int trailer = data[1];
+    while (! tag->isTrailer(trailer)) {
+      trailer ++;
+    }
+    const byte* key = tag->memory[trailer] + ((data[0] == 0x61)? 10 : 0);
+    if (tag->authFailures > 0) {
+      tag->authFailures --;
+    } else if (memcmp(key, data + 2, 6) == 0) {
+      success = true;
+      tag->authSector = sector;
+    }
+    if (! success) {
+      tag->powerOff();   // the tag goes back to IDLE (it stays in the field)
+    }
+  }
+
+  uint64_t nanos;
+  if (success) {
+    this->regs[REG_STATUS2] |= 0x08;   // MFCrypto1On
+    nanos = frames + this->timing.fdtNanos + frameNanos(4, 0);
+    _finish(nanos, IRQ_IDLE);
+  } else {
+    this->timeouts ++;
+    nanos = frames + _timeoutNanos();
+    _finish(nanos, IRQ_TIMER);
+  }
+  this->rfNanos += nanos;
+}
+
+/**
+ * Gives the answer of the tags in the field to the frame (its length, or -1 if no tag
+ * answers), and the time taken by the tag before answering (e.g. to write its EEPROM).
+ * If the answers of the tags differ, "collisionBit" gets the first bit that differs.
+ */
+int SimMfrc522::_answer(const byte* frame, int length, byte txLastBits, byte* answer, byte* answerLastBits, int* collisionBit, uint64_t* tagNanos) {
+  *answerLastBits = 0;
+  *collisionBit = -1;
+  *tagNanos = 0;
+
+  // the tags that left the field lose their state
+  for (int i = 0; i < this->numTags; i ++) {
+    if (! this->tags[i]->present) {
+      this->tags[i]->powerOff();
+    }
+  }
+
+  // REQA / WUPA (short frames)
+  if (length == 1 && txLastBits == 7) {
+    bool wakeUp = (frame[0] == 0x52);
+    int answers = 0;
+    for (int i = 0; i < this->numTags; i ++) {
+      SimTag* tag = this->tags[i];
+      if (tag->present && (tag->state == SimTag::IDLE || (wakeUp && tag->state == SimTag::HALT))) {
+        tag->wasHalted = (tag->state == SimTag::HALT);
+        tag->state = SimTag::READY;
+        answers ++;
+      }
+    }
+    if (answers == 0 || (frame[0] != 0x26 && ! wakeUp)) {
+      return -1;
+    }
+    answer[0] = 0x04;   // ATQA of the tags with UIDs of 4 bytes
+    answer[1] = 0x00;
+    return 2;
+  }
+
+  // the second frame of a WRITE (or of a value operation) goes to the selected tag, even if
+  // its data starts as a command (e.g. 0x93, as a SELECT)
+  for (int i = 0; i < this->numTags; i ++) {
+    SimTag* tag = this->tags[i];
+    if (tag->present && tag->state == SimTag::ACTIVE && tag->pendingCommand != 0) {
+      return _answerActive(tag, frame, length, answer, answerLastBits, tagNanos);
+    }
+  }
+
+  // SELECT (cascade level 1)
+  if (length >= 2 && frame[0] == 0x93) {
+    if (frame[1] == 0x70) {
+      if (length != 9 || ! hasCrcA(frame, length)) {
+        return -1;
+      }
+      int selected = -1;
+      for (int i = 0; i < this->numTags; i ++) {
+        SimTag* tag = this->tags[i];
+        if (! tag->present || tag->state != SimTag::READY) {
+          continue;
+        }
+        if (memcmp(tag->uid, frame + 2, 4) == 0) {
+          tag->state = SimTag::ACTIVE;
+          tag->authSector = -1;
+          selected = i;
+        } else {
+          tag->state = tag->wasHalted? SimTag::HALT : SimTag::IDLE;
+        }
+      }
+      if (selected < 0) {
+        return -1;
+      }
+      answer[0] = this->tags[selected]->sak;
+      simCrcA(answer, 1, answer + 1);
+      return 3;
+    }
+
+    // ANTICOLLISION: the tags whose UIDs start with the bits given answer the other bits
+    int knownBits = ((frame[1] >> 4) - 2) * 8 + (frame[1] & 0x0F);
+    int answers = 0;
+    byte first[5];
+    for (int i = 0; i < this->numTags; i ++) {
+      SimTag* tag = this->tags[i];
+      if (! tag->present || tag->state != SimTag::READY) {
+        continue;
+      }
+      byte uid5[5] = { tag->uid[0], tag->uid[1], tag->uid[2], tag->uid[3],
+                       (byte)(tag->uid[0] ^ tag->uid[1] ^ tag->uid[2] ^ tag->uid[3]) };
+      bool matches = true;
+      for (int bit = 0; bit < knownBits && matches; bit ++) {
+        matches = ((uid5[bit / 8] ^ frame[2 + bit / 8]) & (1 << (bit % 8))) == 0;
+      }
+      if (! matches) {
+        continue;
+      }
+      if (answers == 0) {
+        memcpy(first, uid5, 5);
+      } else {
+        for (int bit = knownBits; bit < 40; bit ++) {
+          if ((uid5[bit / 8] ^ first[bit / 8]) & (1 << (bit % 8))) {
+            if (*collisionBit < 0 || bit < *collisionBit) {
+              *collisionBit = bit;
+            }
+            break;
+          }
+        }
+      }
+      answers ++;
+    }
+    if (answers == 0) {
+      return -1;
+    }
+    // the bits of the first byte before the position "knownBits" are ignored by the reader
+    int firstByte = knownBits / 8;
+    memcpy(answer, first + firstByte, 5 - firstByte);
+    return 5 - firstByte;
+  }
+
+  // the other commands are answered only by the selected tag
+  for (int i = 0; i < this->numTags; i ++) {
+    SimTag* tag = this->tags[i];
+    if (! tag->present) {
+      continue;
+    }
+    if (tag->state == SimTag::ACTIVE) {
+      return _answerActive(tag, frame, length, answer, answerLastBits, tagNanos);
+    }
+    if (tag->state == SimTag::READY) {
+      tag->state = tag->wasHalted? SimTag::HALT : SimTag::IDLE;   // unexpected frame
+    }
+  }
+  return -1;
+}
+
+int SimMfrc522::_answerActive(SimTag* tag, const byte* frame, int length, byte* answer, byte* answerLastBits, uint64_t* tagNanos) {
+  if (! hasCrcA(frame, length)) {
+    return -1;   // frames with errors are ignored
+  }
+
+  // second frame of a WRITE (the data) or of a value operation (the operand)
+  if (tag->pendingCommand != 0) {
+    byte command = tag->pendingCommand;
+    byte block = tag->pendingBlock;
+    tag->pendingCommand = 0;
+
+    if (command == 0xA0 && length == 18) {
+      if (tag->writesBeforeLeaving == 0) {
+        tag->present = false;   // left the field before the data arrived
+        tag->powerOff();
+        return -1;
+      }
+      memcpy(tag->memory[block], frame, 16);
+      this->blockWrites ++;
+      if (tag->writesBeforeLeaving > 0) {
+        tag->writesBeforeLeaving --;
+      }
+      *tagNanos = this->timing.eepromWriteNanos;
+      *answerLastBits = 4;
+      answer[0] = MF_ACK;
+      return 1;
+    }
+    if (length == 6) {
+      int32_t operand = (int32_t)((uint32_t)frame[0] | ((uint32_t)frame[1] << 8) | ((uint32_t)frame[2] << 16) | ((uint32_t)frame[3] << 24));
+      int32_t value = (int32_t)((uint32_t)tag->memory[block][0] | ((uint32_t)tag->memory[block][1] << 8)
+                              | ((uint32_t)tag->memory[block][2] << 16) | ((uint32_t)tag->memory[block][3] << 24));
+      if (command == 0xC1) {
+        tag->transferBuffer = value + operand;
+      } else if (command == 0xC0) {
+        tag->transferBuffer = value - operand;
+      } else {
+        tag->transferBuffer = value;
+      }
+      return -1;   // the operand is not answered
+    }
+    return -1;
+  }
+
+  byte command = frame[0];
+  byte block = (length > 1)? frame[1] : 0;
+  bool authenticated = (block <= tag->lastBlock() && tag->authSector == tag->sectorOf(block));
+  *answerLastBits = 4;
+
+  switch (command) {
+  case 0x50:   // HLTA
+    tag->state = SimTag::HALT;
+    tag->authSector = -1;
+    return -1;
+
+  case 0x30:   // READ
+    if (! authenticated) {
+      break;
+    }
+    this->blockReads ++;
+    memcpy(answer, tag->memory[block], 16);
+    simCrcA(answer, 16, answer + 16);
+    if (tag->readFailures[block] > 0) {
+      tag->readFailures[block] --;
+      answer[16] ^= 0x01;
+    }
+    *answerLastBits = 0;
+    return 18;
+
+  case 0xA0:   // WRITE (the manufacturer block is read-only)
+    if (! authenticated || block == 0) {
+      break;
+    }
+    tag->pendingCommand = command;
+    tag->pendingBlock = block;
+    answer[0] = MF_ACK;
+    return 1;
+
+  case 0xC0:   // DECREMENT
+  case 0xC1:   // INCREMENT
+  case 0xC2:   // RESTORE
+    if (! authenticated || ! isValueBlock(tag->memory[block])) {
+      break;
+    }
+    tag->pendingCommand = command;
+    tag->pendingBlock = block;
+    answer[0] = MF_ACK;
+    return 1;
+
+  case 0xB0:   // TRANSFER
+    if (! authenticated || block == 0) {
+      break;
+    }
+    writeValue(tag->memory[block], tag->transferBuffer,
+               isValueBlock(tag->memory[block])? tag->memory[block][12] : 0);
+    this->blockWrites ++;
+    *tagNanos = this->timing.eepromWriteNanos;
+    answer[0] = MF_ACK;
+    return 1;
+
+  default:
+    tag->powerOff();   // unknown command
+    return -1;
+  }
+
+  // NAK: the tag goes back to IDLE
+  tag->powerOff();
+  answer[0] = MF_NAK;
+  return 1;
+}
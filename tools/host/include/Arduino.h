@@ -0,0 +1,174 @@
+
+#ifndef __HOST_ARDUINO___
+#define __HOST_ARDUINO___
+
+/*
+ * The part of the Arduino API used by the library, for the host build (Linux/macOS) of
+ * the tools in tools/host/. The time is given by the clock of the host, or by the clock
+ * of the simulation (see HostClock.h); the pins do nothing, except the interrupts, which
+ * are triggered by the simulated MFRC522 (see SimMfrc522.h).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HEX  16
+#define DEC  10
+
+#define LOW           0
+#define HIGH          1
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+
+#define CHANGE   1
+#define FALLING  2
+#define RISING   3
+
+#define MSBFIRST  1
+
+#define PROGMEM
+#define F(str)               (str)
+#define pgm_read_byte(p)     (*(const uint8_t*)(p))
+#define pgm_read_dword(p)    (*(const uint32_t*)(p))
+
+// pins of the NodeMCU used in the examples
+#define D2  4
+#define D3  0
+#define D4  2
+#define A0  17
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(int interrupt, void (*handler)(void), int mode);
+void detachInterrupt(int interrupt);
+void noInterrupts();
+void interrupts();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+
+class String {
+private:
+    std::string s;
+
+public:
+    String(const char* str = "") : s(str != NULL? str : "") {}
+    String(const std::string& str) : s(str) {}
+    String(char c) : s(1, c) {}
+    String(int value) : s(std::to_string(value)) {}
+    String(unsigned int value) : s(std::to_string(value)) {}
+    String(long value) : s(std::to_string(value)) {}
+    String(unsigned long value) : s(std::to_string(value)) {}
+
+    unsigned int length() const { return s.size(); }
+    const char* c_str() const { return s.c_str(); }
+    void reserve(unsigned int size) { s.reserve(size); }
+
+    bool concat(const String& str) { s += str.s; return true; }
+    bool concat(const char* str) { s += str; return true; }
+    bool concat(char c) { s += c; return true; }
+    bool concat(int value) { s += std::to_string(value); return true; }
+    String& operator+=(const String& str) { concat(str); return *this; }
+    String& operator+=(const char* str) { concat(str); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+
+    bool equals(const String& str) const { return s == str.s; }
+    bool operator==(const String& str) const { return s == str.s; }
+    bool operator!=(const String& str) const { return s != str.s; }
+    bool operator==(const char* str) const { return s == str; }
+
+    char operator[](unsigned int index) const { return (index < s.size())? s[index] : 0; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+    int indexOf(char c) const { size_t p = s.find(c); return (p == std::string::npos)? -1 : (int)p; }
+    String substring(unsigned int from) const { return (from < s.size())? String(s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return (from < to && from < s.size())? String(s.substr(from, to - from)) : String();
+    }
+    void remove(unsigned int index) { if (index < s.size()) s.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < s.size()) s.erase(index, count); }
+    void trim();
+    long toInt() const { return atol(s.c_str()); }
+
+    void toCharArray(char* buffer, unsigned int bufferSize) const {
+        if (bufferSize == 0) return;
+        size_t n = (s.size() < bufferSize - 1)? s.size() : bufferSize - 1;
+        memcpy(buffer, s.data(), n);
+        buffer[n] = '\0';
+    }
+    void getBytes(byte* buffer, unsigned int bufferSize) const { toCharArray((char*)buffer, bufferSize); }
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r.concat(b); return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r.concat(b); return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r.concat(b); return r; }
+inline String operator+(const String& a, char b) { String r(a); r.concat(b); return r; }
+inline String operator+(const String& a, int b) { String r(a); r.concat(b); return r; }
+
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str) { return write(str.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    size_t readBytes(uint8_t* buffer, size_t length);
+    size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+    void setTimeout(unsigned long timeout) { (void)timeout; }
+};
+
+// Serial of the host: writes to the standard output, and reads nothing
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t b) { return fputc(b, stdout) == EOF? 0 : 1; }
+    using Print::write;
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,33 @@
+
+#ifndef __HOST_ARDUINO_EXTRAS___
+#define __HOST_ARDUINO_EXTRAS___
+
+#include <Arduino.h>
+
+/*
+ * Functions of the host build that don't exist in Arduino: control of the clock, of the
+ * interrupts and of the heap counters, used by the simulator and by the tools.
+ *
+ * The clock (micros() and millis()) is the clock of the host plus the time "charged" by
+ * the simulated hardware (SPI transfers, frames in the air...). With the simulated clock,
+ * only the charged time (and delay()) counts, so the times reported by the tools depend
+ * only on the timing model, not on the speed of the host.
+ */
+
+void hostSetSimulatedClock(bool simulated);
+bool hostIsSimulatedClock();
+uint64_t hostNanos();
+void hostAdvanceNanos(uint64_t nanos);   // charges the time (may be called by any thread)
+
+// the hook is called in yield() and delay() (e.g. to let the simulator fire its interrupt)
+void hostSetClockHook(void (*hook)());
+
+// calls the handler attached to the interrupt of the pin, if any (as if its edge happened)
+void hostTriggerInterrupt(uint8_t pin);
+
+// bytes allocated with "new" (e.g. by String) and not yet freed, and the peak of it
+long hostUsedHeap();
+long hostPeakHeap();
+void hostResetPeakHeap();
+
+#endif
@@ -0,0 +1,176 @@
+
+#ifndef __HOST_MFRC522___
+#define __HOST_MFRC522___
+
+#include <Arduino.h>
+#include <SPI.h>
+
+/*
+ * Class MFRC522 of Balboa's library (miguelbalboa/MFRC522 1.4.8), for the host build of
+ * the tools in tools/host/: the part of its API used by EasyMFRC522. The functions do the
+ * same sequences of register accesses as the original ones (in HostMfrc522.cpp), through
+ * the SPI bus of the host, which goes to the simulated MFRC522 (see SimMfrc522.h). So, the
+ * SPI traffic and the time of the commands are the ones of the real library.
+ */
+
+#ifndef MFRC522_SPICLOCK
+#define MFRC522_SPICLOCK  (4000000u)   // the same default of Balboa's library
+#endif
+
+class MFRC522 {
+public:
+    enum PCD_Register : byte {
+        CommandReg      = 0x01 << 1,
+        ComIEnReg       = 0x02 << 1,
+        DivIEnReg       = 0x03 << 1,
+        ComIrqReg       = 0x04 << 1,
+        DivIrqReg       = 0x05 << 1,
+        ErrorReg        = 0x06 << 1,
+        Status1Reg      = 0x07 << 1,
+        Status2Reg      = 0x08 << 1,
+        FIFODataReg     = 0x09 << 1,
+        FIFOLevelReg    = 0x0A << 1,
+        WaterLevelReg   = 0x0B << 1,
+        ControlReg      = 0x0C << 1,
+        BitFramingReg   = 0x0D << 1,
+        CollReg         = 0x0E << 1,
+        ModeReg         = 0x11 << 1,
+        TxModeReg       = 0x12 << 1,
+        RxModeReg       = 0x13 << 1,
+        TxControlReg    = 0x14 << 1,
+        TxASKReg        = 0x15 << 1,
+        CRCResultRegH   = 0x21 << 1,
+        CRCResultRegL   = 0x22 << 1,
+        ModWidthReg     = 0x24 << 1,
+        TModeReg        = 0x2A << 1,
+        TPrescalerReg   = 0x2B << 1,
+        TReloadRegH     = 0x2C << 1,
+        TReloadRegL     = 0x2D << 1,
+        VersionReg      = 0x37 << 1
+    };
+
+    enum PCD_Command : byte {
+        PCD_Idle        = 0x00,
+        PCD_Mem         = 0x01,
+        PCD_CalcCRC     = 0x03,
+        PCD_Transmit    = 0x04,
+        PCD_NoCmdChange = 0x07,
+        PCD_Receive     = 0x08,
+        PCD_Transceive  = 0x0C,
+        PCD_MFAuthent   = 0x0E,
+        PCD_SoftReset   = 0x0F
+    };
+
+    enum PICC_Command : byte {
+        PICC_CMD_REQA           = 0x26,
+        PICC_CMD_WUPA           = 0x52,
+        PICC_CMD_CT             = 0x88,
+        PICC_CMD_SEL_CL1        = 0x93,
+        PICC_CMD_SEL_CL2        = 0x95,
+        PICC_CMD_SEL_CL3        = 0x97,
+        PICC_CMD_HLTA           = 0x50,
+        PICC_CMD_MF_AUTH_KEY_A  = 0x60,
+        PICC_CMD_MF_AUTH_KEY_B  = 0x61,
+        PICC_CMD_MF_READ        = 0x30,
+        PICC_CMD_MF_WRITE       = 0xA0,
+        PICC_CMD_MF_DECREMENT   = 0xC0,
+        PICC_CMD_MF_INCREMENT   = 0xC1,
+        PICC_CMD_MF_RESTORE     = 0xC2,
+        PICC_CMD_MF_TRANSFER    = 0xB0
+    };
+
+    enum MIFARE_Misc {
+        MF_ACK      = 0xA,
+        MF_KEY_SIZE = 6
+    };
+
+    enum PICC_Type : byte {
+        PICC_TYPE_UNKNOWN,
+        PICC_TYPE_ISO_14443_4,
+        PICC_TYPE_ISO_18092,
+        PICC_TYPE_MIFARE_MINI,
+        PICC_TYPE_MIFARE_1K,
+        PICC_TYPE_MIFARE_4K,
+        PICC_TYPE_MIFARE_UL,
+        PICC_TYPE_MIFARE_PLUS,
+        PICC_TYPE_MIFARE_DESFIRE,
+        PICC_TYPE_TNP3XXX,
+        PICC_TYPE_NOT_COMPLETE = 0xff
+    };
+
+    enum StatusCode : byte {
+        STATUS_OK,
+        STATUS_ERROR,
+        STATUS_COLLISION,
+        STATUS_TIMEOUT,
+        STATUS_NO_ROOM,
+        STATUS_INTERNAL_ERROR,
+        STATUS_INVALID,
+        STATUS_CRC_WRONG,
+        STATUS_MIFARE_NACK = 0xff
+    };
+
+    typedef struct {
+        byte size;
+        byte uidByte[10];
+        byte sak;
+    } Uid;
+
+    typedef struct {
+        byte keyByte[MF_KEY_SIZE];
+    } MIFARE_Key;
+
+    Uid uid;
+
+    MFRC522(byte chipSelectPin, byte resetPowerDownPin);
+
+    // basic interface functions for communicating with the MFRC522
+    void PCD_WriteRegister(PCD_Register reg, byte value);
+    void PCD_WriteRegister(PCD_Register reg, byte count, byte* values);
+    byte PCD_ReadRegister(PCD_Register reg);
+    void PCD_ReadRegister(PCD_Register reg, byte count, byte* values, byte rxAlign = 0);
+    void PCD_SetRegisterBitMask(PCD_Register reg, byte mask);
+    void PCD_ClearRegisterBitMask(PCD_Register reg, byte mask);
+    StatusCode PCD_CalculateCRC(byte* data, byte length, byte* result);
+
+    // functions for manipulating the MFRC522
+    void PCD_Init();
+    void PCD_Reset();
+    void PCD_AntennaOn();
+    void PCD_AntennaOff();
+
+    // functions for communicating with PICCs
+    StatusCode PCD_TransceiveData(byte* sendData, byte sendLen, byte* backData, byte* backLen, byte* validBits = NULL, byte rxAlign = 0, bool checkCRC = false);
+    StatusCode PCD_CommunicateWithPICC(byte command, byte waitIRq, byte* sendData, byte sendLen, byte* backData = NULL, byte* backLen = NULL, byte* validBits = NULL, byte rxAlign = 0, bool checkCRC = false);
+    StatusCode PICC_RequestA(byte* bufferATQA, byte* bufferSize);
+    StatusCode PICC_WakeupA(byte* bufferATQA, byte* bufferSize);
+    StatusCode PICC_REQA_or_WUPA(byte command, byte* bufferATQA, byte* bufferSize);
+    StatusCode PICC_Select(Uid* uid, byte validBits = 0);
+    StatusCode PICC_HaltA();
+
+    // functions for communicating with MIFARE PICCs
+    StatusCode PCD_Authenticate(byte command, byte blockAddr, MIFARE_Key* key, Uid* uid);
+    void PCD_StopCrypto1();
+    StatusCode MIFARE_Read(byte blockAddr, byte* buffer, byte* bufferSize);
+    StatusCode MIFARE_Write(byte blockAddr, byte* buffer, byte bufferSize);
+    StatusCode MIFARE_Decrement(byte blockAddr, int32_t delta);
+    StatusCode MIFARE_Increment(byte blockAddr, int32_t delta);
+    StatusCode MIFARE_Restore(byte blockAddr);
+    StatusCode MIFARE_Transfer(byte blockAddr);
+
+    // support functions
+    StatusCode PCD_MIFARE_Transceive(byte* sendData, byte sendLen, bool acceptTimeout = false);
+    static PICC_Type PICC_GetType(byte sak);
+
+    // convenience functions
+    bool PICC_IsNewCardPresent();
+    bool PICC_ReadCardSerial();
+
+private:
+    byte _chipSelectPin;
+    byte _resetPowerDownPin;
+
+    StatusCode MIFARE_TwoStepHelper(byte command, byte blockAddr, int32_t data);
+};
+
+#endif
@@ -0,0 +1,35 @@
+
+#ifndef __HOST_SPI___
+#define __HOST_SPI___
+
+#include <Arduino.h>
+
+/*
+ * SPI bus of the host build: the bytes go to the simulated MFRC522 (see SimMfrc522.h),
+ * which counts the transactions and bytes, and charges their time in the simulated clock.
+ */
+
+#define SPI_MODE0  0
+
+class SPISettings {
+public:
+    uint32_t clock;
+
+    SPISettings() : clock(4000000) {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) : clock(clock) {
+        (void)bitOrder; (void)dataMode;
+    }
+};
+
+class SPIClass {
+public:
+    void begin() {}
+    void end() {}
+    void beginTransaction(SPISettings settings);
+    uint8_t transfer(uint8_t data);
+    void endTransaction();
+};
+
+extern SPIClass SPI;
+
+#endif
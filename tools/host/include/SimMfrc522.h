@@ -0,0 +1,151 @@
+
+#ifndef __SIM_MFRC522___
+#define __SIM_MFRC522___
+
+#include <Arduino.h>
+#include <atomic>
+
+/*
+ * Simulated MFRC522, with Mifare Classic tags in its field, for the host build of the
+ * tools in tools/host/. It is accessed through the SPI bus of the host (see SPI.h), as
+ * the real chip: registers, FIFO, the commands Transceive, MFAuthent and CalcCRC, the
+ * timer, and the IRQ pin. The tags answer the frames of ISO 14443-3 (REQA, WUPA, the
+ * anticollision, SELECT, HLTA) and the Mifare commands (READ, WRITE, INCREMENT, DECREMENT,
+ * RESTORE, TRANSFER), in plain text (the Crypto1 cipher is not simulated).
+ *
+ * Each command takes the time given by the timing model (SimTiming), which is charged in
+ * the clock of the host (see HostArduino.h); its end is seen by the SPI reads of ComIrqReg
+ * (or by the IRQ pin) only after that time.
+ */
+
+// Timing model: the frames take the time of ISO 14443-A at 106 kbit/s (1 etu = 128/fc =
+// 9.44 us per bit, 9 bits per byte with the parity, plus start and end of frame)
+struct SimTiming {
+    uint32_t spiOverheadNanos;    // each SPI transaction (beginTransaction(), chip select...)
+    uint32_t fdtNanos;            // frame delay time: from the end of a frame to the answer
+    uint32_t eepromWriteNanos;    // programming of a block in the tag (WRITE and TRANSFER)
+    uint32_t crcNanosPerByte;     // CRC coprocessor of the MFRC522
+
+    SimTiming() : spiOverheadNanos(1500), fdtNanos(91000), eepromWriteNanos(2500000), crcNanosPerByte(600) {}
+};
+
+// SAK of the types of tag
+#define SIM_TAG_MINI  0x09
+#define SIM_TAG_1K    0x08
+#define SIM_TAG_4K    0x18
+
+class SimTag {
+public:
+    enum State { IDLE, READY, ACTIVE, HALT };
+
+    byte uid[4];
+    byte sak;
+    byte memory[256][16];
+    std::atomic<bool> present;     // may be changed by any thread
+
+    // faults to inject
+    int readFailures[256];         // next reads of the block that are answered with a wrong CRC
+    int writesBeforeLeaving;       // the tag leaves the field after this number of writes (-1: never)
+    int authFailures;              // next authentications that fail
+
+    // state of the protocol (used by the simulator)
+    State state;
+    bool wasHalted;                // woken up by WUPA from the HALT state
+    int authSector;
+    byte pendingCommand;           // command waiting for its second frame (WRITE or a value operation)
+    byte pendingBlock;
+    int32_t transferBuffer;
+
+    SimTag(uint32_t uidValue, byte sak = SIM_TAG_1K);
+
+    void format();                 // blank tag: block 0 with the UID, data blocks zeroed, default trailers
+    void powerOff();               // the tag left the field (or the antenna was turned off)
+    int lastBlock();
+    int sectorOf(int block);
+    bool isTrailer(int block);
+};
+
+class SimMfrc522 {
+public:
+    SimTiming timing;
+
+    // counters (see resetCounters())
+    unsigned long spiTransactions;
+    unsigned long spiBytes;
+    unsigned long spiPolls;         // transactions that only read ComIrqReg or DivIrqReg (waiting for a command)
+    uint64_t spiNanos;              // time of the SPI transfers (bytes and overhead of the transactions)
+    unsigned long rfFrames;         // frames sent by the reader
+    uint64_t rfNanos;               // time of the commands in the air, from the first frame to the answer (or timeout)
+    unsigned long timeouts;         // frames not answered
+    unsigned long authentications;
+    unsigned long blockReads;
+    unsigned long blockWrites;
+
+    SimMfrc522();
+
+    void addTag(SimTag* tag);
+    void removeTags();
+    void setIrqPin(byte pin);       // pin with the interrupt fired by the IRQ output
+    void resetCounters();
+
+    // interface with the SPI bus (see SPI.h)
+    void select(uint32_t spiClock);
+    uint8_t transfer(uint8_t value);
+    void deselect();
+
+    // completes the command in progress if its time has come (called in each SPI transfer,
+    // and in yield() and delay(), so the IRQ is fired even without accesses to the chip)
+    void update();
+
+private:
+    static const int MAX_TAGS = 8;
+    SimTag* tags[MAX_TAGS];
+    int numTags;
+
+    byte regs[64];
+    byte fifo[64];
+    int fifoLength;
+    int fifoPosition;              // next byte to be read from the FIFO
+
+    // SPI transaction
+    uint64_t spiByteNanos;
+    int spiCount;
+    bool spiRead;
+    byte spiAddress;
+    byte spiFirstAddress;
+
+    // command in progress
+    bool busy;
+    uint64_t completionTime;
+    byte resultIrq;                // bits of ComIrqReg (or of DivIrqReg, for CalcCRC) at the end
+    byte resultError;
+    byte resultColl;
+    byte resultLastBits;
+    byte resultData[64];
+    int resultLength;
+    bool resultIsCrc;
+
+    byte irqPin;
+    bool irqAsserted;
+
+    void _reset();
+    byte _readRegister(byte reg);
+    void _writeRegister(byte reg, byte value);
+    void _startCommand(byte command);
+    void _startTransceive();
+    void _startAuthent();
+    void _finish(uint64_t nanos, byte irq);
+    void _updateIrq();
+    uint64_t _timeoutNanos();
+    bool _antennaOn();
+
+    int _answer(const byte* frame, int length, byte txLastBits, byte* answer, byte* answerLastBits, int* collisionBit, uint64_t* tagNanos);
+    int _answerActive(SimTag* tag, const byte* frame, int length, byte* answer, byte* answerLastBits, uint64_t* tagNanos);
+};
+
+extern SimMfrc522 simMfrc522;
+
+// CRC_A of ISO 14443-3, with the low byte first in "result"
+void simCrcA(const byte* data, int length, byte* result);
+
+#endif
@@ -0,0 +1,118 @@
+#include <EasyMFRC522.h>
+#include <HostArduino.h>
+#include <SimMfrc522.h>
+
+#include <algorithm>
+#include <vector>
+
+/*
+ * Measures the cost and the benefit of the files with parity (see setFileParity()) on a
+ * simulated tag with weak blocks (SimTag::readFailures), in the simulated clock: a file of
+ * DATA_SIZE bytes is written without parity and with parity groups of 4 and 2 blocks, and
+ * then read in TAPS taps. In each tap, one data block of the file fails some reads (with a
+ * wrong CRC): 1 to 3 reads, or (one tap in four) more reads than the retries of the library,
+ * as a block too weak to be read in that tap.
+ *
+ * Output: CSV lines "csv,mode,group,taps,errors,blocks_used,blocks_recovered,p50_micros,
+ * p99_micros,reads_avg", where "blocks_used" is the number of blocks written by writeFile()
+ * (with the header and the parity blocks), "blocks_recovered" the blocks rebuilt from the
+ * parity (TransferStats::blocksRecovered), the percentiles are of the time of the taps
+ * (detection, readFile() and release of the tag), and "reads_avg" is the average number of
+ * reads of blocks per tap (with the retries).
+ *
+ * The tool fails (exit code 1) if a file with parity gives errors or wrong data, or if a
+ * weak block is not rebuilt from the parity in some tap.
+ */
+
+#define TAPS           50
+#define DATA_SIZE      128    // 8 blocks
+#define DATA_BLOCKS    (DATA_SIZE / 16)
+#define FILE_BLOCK     1
+#define DEAD_FAILURES  6      // more than the reads tried by the library for a block
+
+EasyMFRC522 rfidReader(D4, D3);
+SimTag tag(0x51525354);
+byte data[DATA_SIZE];
+
+int errors = 0;
+
+// Gives the block of the tag with the data block "index" of the file (see _readParityFile()).
+static int blockOfData(int index, int group) {
+  int offset = (group == 0)? 16 * index : 16 * ((index / group) * (group + 1) + index % group);
+  return rfidReader.getBlockOfOffset(FILE_BLOCK + 1, offset);
+}
+
+static void runMode(const char* mode, int group) {
+  rfidReader.setFileParity(group);
+  simMfrc522.resetCounters();
+  if (! rfidReader.detectTag() || rfidReader.writeFile(FILE_BLOCK, "parity", data, DATA_SIZE) < 0) {
+    fprintf(stderr, "error: could not write the file (%s)\n", mode);
+    errors ++;
+    return;
+  }
+  unsigned long blocksUsed = simMfrc522.blockWrites;
+  rfidReader.unselectMifareTag(true);
+
+  std::vector<unsigned long> tapMicros;
+  int tapErrors = 0;
+  unsigned long recovered = 0;
+  unsigned long reads = 0;
+  byte buffer[DATA_SIZE];
+
+  for (int t = 0; t < TAPS; t ++) {
+    int weakBlock = blockOfData((t * 3) % DATA_BLOCKS, group);
+    tag.readFailures[weakBlock] = (t % 4 == 3)? DEAD_FAILURES : 1 + t % 3;
+    rfidReader.resetTransferStats();
+    simMfrc522.resetCounters();
+    memset(buffer, 0, sizeof(buffer));
+
+    unsigned long start = micros();
+    int result = -1;
+    if (rfidReader.detectTag()) {
+      result = rfidReader.readFile(FILE_BLOCK, "parity", buffer, DATA_SIZE);
+    }
+    rfidReader.unselectMifareTag(true);
+    tapMicros.push_back(micros() - start);
+
+    unsigned long tapRecovered = rfidReader.getTransferStats().blocksRecovered;
+    recovered += tapRecovered;
+    reads += simMfrc522.blockReads;
+    if (result < 0) {
+      tapErrors ++;
+    } else if (result != DATA_SIZE || memcmp(buffer, data, DATA_SIZE) != 0) {
+      fprintf(stderr, "error: %s read wrong data in the tap %d\n", mode, t);
+      errors ++;
+    }
+    if (group > 0 && tapRecovered != 1) {
+      fprintf(stderr, "error: %s rebuilt %lu blocks in the tap %d, instead of 1\n", mode, tapRecovered, t);
+      errors ++;
+    }
+    memset(tag.readFailures, 0, sizeof(tag.readFailures));   // failures not consumed by the reads
+  }
+
+  std::sort(tapMicros.begin(), tapMicros.end());
+  printf("csv,%s,%d,%d,%d,%lu,%lu,%lu,%lu,%.2f\n", mode, group, TAPS, tapErrors, blocksUsed, recovered,
+         tapMicros[(TAPS - 1) * 50 / 100], tapMicros[(TAPS - 1) * 99 / 100], (float)reads / TAPS);
+
+  if (group > 0 && tapErrors > 0) {
+    fprintf(stderr, "error: %s failed in %d taps\n", mode, tapErrors);
+    errors ++;
+  }
+}
+
+int main() {
+  hostSetSimulatedClock(true);
+  simMfrc522.addTag(&tag);
+  rfidReader.init();
+  for (int i = 0; i < DATA_SIZE; i ++) {
+    data[i] = (byte)(i * 11 + 3);
+  }
+
+  printf("csv,mode,group,taps,errors,blocks_used,blocks_recovered,p50_micros,p99_micros,reads_avg\n");
+  runMode("retries", 0);
+  runMode("parity", 4);
+  runMode("parity", 2);
+
+  rfidReader.setFileParity(0);
+  return (errors == 0)? 0 : 1;
+}
@@ -0,0 +1,139 @@
+#include <EasyMFRC522.h>
+#include <HostArduino.h>
+#include <SimMfrc522.h>
+
+#include <functional>
+
+/*
+ * Measures the SPI traffic of the block reads and writes in the mock SPI bus of the host
+ * build (the simulated MFRC522), for each SPI clock, comparing two paths:
+ *   - "burst":  the transfer layer of EasyMFRC522 (readRaw()/writeRaw() of one block);
+ *   - "balboa": MIFARE_Read()/MIFARE_Write() of Balboa's class (register at a time, with
+ *               the CRCs calculated by the MFRC522), at its fixed clock (MFRC522_SPICLOCK).
+ * The write is always followed by a read, as the verification done by writeRaw().
+ *
+ * The sector is authenticated before the measures, so they have only the block commands.
+ * For the "burst" path, the counters of EasyMFRC522 (getTransferStats()) must be equal to
+ * the traffic seen in the bus; otherwise, the tool fails (exit code 1). It also fails if a
+ * write to a tag slow to program the block (15ms) times out at 10 MHz.
+ *
+ * Output: CSV lines "csv,operation,path,spi_clock,transactions,polls,command_transactions,
+ * bytes,spi_micros,total_micros" with the totals per operation; "total_micros" is the time in
+ * the simulated clock. Both paths poll ComIrqReg (and Balboa's, DivIrqReg) while waiting for
+ * the frames in the air or the CRCs, so "polls" grows with the SPI clock, while the total
+ * time is dominated by the RF timing. "command_transactions" (the transactions that are not
+ * polls: FIFO, commands, status) is the cost of the block operation itself; the tool fails if
+ * it changes with the clock in the "burst" path.
+ */
+
+#define BLOCK  1
+
+EasyMFRC522 rfidReader(D4, D3);
+SimTag tag(0x11223344);
+
+int errors = 0;
+unsigned long burstReadTransactions = 0;    // transactions that are not polls, in the first clock
+unsigned long burstWriteTransactions = 0;
+
+void measure(const char* operation, const char* path, uint32_t clock, std::function<int()> run) {
+  rfidReader.resetTransferStats();
+  simMfrc522.resetCounters();
+  uint64_t start = hostNanos();
+
+  int result = run();
+  uint64_t elapsed = hostNanos() - start;
+
+  unsigned long commandTransactions = simMfrc522.spiTransactions - simMfrc522.spiPolls;
+  printf("csv,%s,%s,%u,%lu,%lu,%lu,%lu,%.1f,%.1f\n", operation, path, (unsigned)clock,
+         simMfrc522.spiTransactions, simMfrc522.spiPolls, commandTransactions, simMfrc522.spiBytes,
+         simMfrc522.spiNanos / 1000.0, elapsed / 1000.0);
+
+  if (result < 0) {
+    fprintf(stderr, "error: %s/%s failed (%d)\n", operation, path, result);
+    errors ++;
+  }
+  if (strcmp(path, "burst") != 0) {
+    return;
+  }
+  const EasyMFRC522::TransferStats& stats = rfidReader.getTransferStats();
+  if (stats.spiTransactions != simMfrc522.spiTransactions || stats.spiBytes != simMfrc522.spiBytes || stats.spiPolls != simMfrc522.spiPolls) {
+    fprintf(stderr, "error: %s/%s counted %lu transactions, %lu bytes and %lu polls, but the bus had %lu, %lu and %lu\n",
+            operation, path, stats.spiTransactions, stats.spiBytes, stats.spiPolls,
+            simMfrc522.spiTransactions, simMfrc522.spiBytes, simMfrc522.spiPolls);
+    errors ++;
+  }
+  unsigned long& expected = (strcmp(operation, "read") == 0)? burstReadTransactions : burstWriteTransactions;
+  if (expected == 0) {
+    expected = commandTransactions;
+  } else if (expected != commandTransactions) {
+    fprintf(stderr, "error: %s/%s had %lu transactions besides the polls, but %lu with another clock\n",
+            operation, path, commandTransactions, expected);
+    errors ++;
+  }
+}
+
+int main() {
+  hostSetSimulatedClock(true);
+  simMfrc522.addTag(&tag);
+
+  rfidReader.init();
+  if (! rfidReader.detectTag()) {
+    fprintf(stderr, "error: the simulated tag was not detected\n");
+    return 1;
+  }
+
+  byte data[18];
+  byte buffer[18];
+  for (int i = 0; i < 16; i ++) {
+    data[i] = (byte)(i * 7);
+  }
+  if (rfidReader.writeRaw(BLOCK, data, 16) < 0) {   // authenticates the sector
+    fprintf(stderr, "error: could not write the block\n");
+    return 1;
+  }
+  MFRC522* device = rfidReader.getMFRC522();
+
+  printf("csv,operation,path,spi_clock,transactions,polls,command_transactions,bytes,spi_micros,total_micros\n");
+
+  const uint32_t clocks[] = { 1000000UL, 4000000UL, 10000000UL };
+  for (unsigned c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c ++) {
+    rfidReader.setSpiClock(clocks[c]);
+
+    measure("read", "burst", clocks[c], [&]() {
+      return rfidReader.readRaw(BLOCK, buffer, 16);
+    });
+    measure("write+verify", "burst", clocks[c], [&]() {
+      return rfidReader.writeRaw(BLOCK, data, 16);
+    });
+  }
+
+  measure("read", "balboa", MFRC522_SPICLOCK, [&]() {
+    byte size = sizeof(buffer);
+    return -(int)device->MIFARE_Read(BLOCK, buffer, &size);   // STATUS_OK is 0
+  });
+  measure("write+verify", "balboa", MFRC522_SPICLOCK, [&]() {
+    byte size = sizeof(buffer);
+    int status = device->MIFARE_Write(BLOCK, data, 16);
+    if (status == MFRC522::STATUS_OK) {
+      status = device->MIFARE_Read(BLOCK, buffer, &size);
+    }
+    return -status;
+  });
+
+  if (memcmp(buffer, data, 16) != 0) {
+    fprintf(stderr, "error: the data read is not the data written\n");
+    errors ++;
+  }
+
+  // a tag slow to program the block (still inside the 25ms timer of the MFRC522) must not
+  // give timeouts with the fastest clock, where the polling of ComIrqReg is fastest
+  rfidReader.setSpiClock(10000000UL);
+  simMfrc522.timing.eepromWriteNanos = 15000000UL;
+  simMfrc522.resetCounters();
+  if (rfidReader.writeRaw(BLOCK, data, 16) < 0 || simMfrc522.blockWrites != 1) {
+    fprintf(stderr, "error: the write of a slow tag failed or was retried (%lu writes)\n", simMfrc522.blockWrites);
+    errors ++;
+  }
+  simMfrc522.timing = SimTiming();
+  return (errors == 0)? 0 : 1;
+}
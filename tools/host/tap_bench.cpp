@@ -0,0 +1,91 @@
+#include <EasyMFRC522.h>
+#include <RfidDictionaryView.h>
+#include <HostArduino.h>
+#include <SimMfrc522.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * Runs the workloads of the example TapBenchmark (examples/TapBenchmark) on Linux, against
+ * the timing model of the simulated MFRC522 (SimTiming), with the tag kept still over the
+ * reader. The sketch itself is compiled here, with its setup() and one loop(), so the
+ * workloads are the same ones of the board.
+ *
+ * Output: the lines printed by the sketch; the ones starting with "csv," have, per workload,
+ * the p50/p99 of the time of the taps and the median of the time in the commands to the tag
+ * (all in the simulated clock, so they only change if the library or the timing model
+ * change), the average and maximum number of commands to the tag (RF transactions) per tap,
+ * and the peak heap used in a tap (bytes allocated with "new", as sampled by the sketch).
+ *
+ * The tool fails (exit code 1) if some workload is missing, has errors or skipped taps.
+ */
+
+#define WORKLOADS  5   // run by loop() of the sketch
+
+// the free heap of the sketch, measured in the heap counters of the host
+#define HOST_HEAP_SIZE  (1L << 20)
+#define FREE_HEAP()     (HOST_HEAP_SIZE - hostUsedHeap())
+
+// the Serial of the sketch: writes to the standard output, keeping the CSV lines of the results
+class BenchSerial : public HardwareSerial {
+public:
+  struct Result {
+    std::string name;
+    int taps;
+    int errors;
+  };
+  std::vector<Result> results;
+  std::string line;
+
+  size_t write(uint8_t b) {
+    if (b == '\n') {
+      checkLine();
+      line.clear();
+    } else if (b != '\r') {
+      line += (char)b;
+    }
+    return HardwareSerial::write(b);
+  }
+  using Print::write;
+
+private:
+  void checkLine() {
+    char name[32];
+    Result result;
+    if (sscanf(line.c_str(), "csv,%31[^,],%d,%d,", name, &result.taps, &result.errors) == 3) {   // not the header
+      result.name = name;
+      results.push_back(result);
+    }
+  }
+};
+
+BenchSerial benchSerial;
+
+#define Serial  benchSerial
+#include "../../examples/TapBenchmark/TapBenchmark.ino"
+#undef Serial
+
+int main() {
+  hostSetSimulatedClock(true);
+  SimTag tag(0x31323334);
+  simMfrc522.addTag(&tag);
+
+  setup();
+  loop();
+  fflush(stdout);
+
+  int errors = 0;
+  if (benchSerial.results.size() != WORKLOADS) {
+    fprintf(stderr, "error: %d workloads reported, instead of %d\n", (int)benchSerial.results.size(), WORKLOADS);
+    errors ++;
+  }
+  for (unsigned i = 0; i < benchSerial.results.size(); i ++) {
+    const BenchSerial::Result& result = benchSerial.results[i];
+    if (result.taps != TAPS || result.errors != 0) {
+      fprintf(stderr, "error: workload %s had %d taps and %d errors\n", result.name.c_str(), result.taps, result.errors);
+      errors ++;
+    }
+  }
+  return (errors == 0)? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#include <EasyMFRC522.h>
+#include <RfidBatch.h>
+#include <HostArduino.h>
+#include <SimMfrc522.h>
+
+/*
+ * Tests of EasyMFRC522::executeBatch() on a simulated 1k tag:
+ *   - writes and reads of a batch give the data and results of writeRaw()/readRaw();
+ *   - requests with initial blocks out of the tag (e.g. 300 or -1) fail with -902, without
+ *     writing to any block (they were wrapped to byte before).
+ *
+ * Returns 1 (and prints the failures) if some test fails.
+ */
+
+#define CHECK(condition)  check((condition), #condition, __LINE__)
+
+static int failures = 0;
+
+static void check(bool condition, const char* text, int line) {
+  if (! condition) {
+    printf("FAILED (line %d): %s\n", line, text);
+    failures ++;
+  }
+}
+
+EasyMFRC522 rfidReader(D4, D3);
+SimTag tag(0x41424344);
+
+static void testRoundTrip() {
+  byte data[40];
+  byte buffer[40];
+  for (int i = 0; i < 40; i ++) {
+    data[i] = (byte)(i + 9);
+  }
+  RfidStaticBatch<2> writes;
+  CHECK(writes.addWrite(2, data, 40) == 0);   // blocks 2, 4 and 5 (3 is a trailer)
+  CHECK(rfidReader.executeBatch(writes) >= 0);
+  CHECK(writes.getResult(0) == 5);
+
+  RfidStaticBatch<2> reads;
+  CHECK(reads.addRead(2, buffer, 40) == 0);
+  CHECK(rfidReader.executeBatch(reads) >= 0);
+  CHECK(reads.getResult(0) == 40);
+  CHECK(memcmp(buffer, data, 40) == 0);
+}
+
+static void testOutOfTag() {
+  byte data[16];
+  memset(data, 0xAB, sizeof(data));
+  byte before[256][16];
+  memcpy(before, tag.memory, sizeof(before));
+
+  RfidStaticBatch<3> batch;
+  batch.addWrite(300, data, 16);   // would be block 44, as a byte
+  batch.addWrite(-1, data, 16);    // would be block 255
+  batch.addRead(64, data, 16);
+  CHECK(rfidReader.executeBatch(batch) == -902);
+  CHECK(batch.getResult(0) == -902);
+  CHECK(batch.getResult(1) == -902);
+  CHECK(batch.getResult(2) == -902);
+  CHECK(memcmp(before, tag.memory, sizeof(before)) == 0);
+}
+
+int main() {
+  hostSetSimulatedClock(true);
+  simMfrc522.addTag(&tag);
+  rfidReader.init();
+  if (! rfidReader.detectTag()) {
+    printf("FAILED: the simulated tag was not detected\n");
+    return 1;
+  }
+
+  testRoundTrip();
+  testOutOfTag();
+
+  if (failures > 0) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("all tests of the batches passed\n");
+  return 0;
+}
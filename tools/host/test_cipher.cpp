@@ -0,0 +1,119 @@
+#include <EasyMFRC522.h>
+#include <RfidCipher.h>
+#include <HostArduino.h>
+#include <SimMfrc522.h>
+
+/*
+ * Tests of the encrypted files (see setFileCipher()) on simulated tags:
+ *   - a file written with the cipher is read back with it, and its data is not stored in
+ *     clear in the tag;
+ *   - readFile() fails with -1030 (authentication failed) if a byte of the data is flipped,
+ *     if the label in the header is changed (and the file is read with the new label), or
+ *     if the blocks of the file are copied to a tag with another UID;
+ *   - without the cipher, it fails with -1031.
+ *
+ * Returns 1 (and prints the failures) if some test fails.
+ */
+
+#define CHECK(condition)  check((condition), #condition, __LINE__)
+
+#define FILE_BLOCK  1
+#define DATA_SIZE   40
+
+static int failures = 0;
+
+static void check(bool condition, const char* text, int line) {
+  if (! condition) {
+    printf("FAILED (line %d): %s\n", line, text);
+    failures ++;
+  }
+}
+
+EasyMFRC522 rfidReader(D4, D3);
+SimTag tag(0x61626364);
+SimTag otherTag(0x71727374);
+
+const byte key[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+RfidCipher cipher(key);
+
+byte data[DATA_SIZE];
+byte buffer[DATA_SIZE];
+
+// the tag is the only one in the field, and is selected
+static void useTag(SimTag* selected) {
+  rfidReader.unselectMifareTag(true);
+  simMfrc522.removeTags();
+  simMfrc522.addTag(selected);
+  CHECK(rfidReader.detectTag());
+}
+
+static void writeFile() {
+  useTag(&tag);
+  CHECK(rfidReader.writeFile(FILE_BLOCK, "secret", data, DATA_SIZE) >= 0);
+}
+
+static void testRoundTrip() {
+  writeFile();
+  memset(buffer, 0, sizeof(buffer));
+  CHECK(rfidReader.readFile(FILE_BLOCK, "secret", buffer, DATA_SIZE) == DATA_SIZE);
+  CHECK(memcmp(buffer, data, DATA_SIZE) == 0);
+
+  // the first data block (after the header and the block with the nonce and the tag) is not in clear
+  int dataBlock = rfidReader.getBlockOfOffset(FILE_BLOCK + 1, 16);
+  CHECK(memcmp(tag.memory[dataBlock], data, 16) != 0);
+}
+
+static void testFlippedData() {
+  writeFile();
+  int dataBlock = rfidReader.getBlockOfOffset(FILE_BLOCK + 1, 32);   // the second data block
+  tag.memory[dataBlock][5] ^= 0x01;
+  CHECK(rfidReader.readFile(FILE_BLOCK, "secret", buffer, DATA_SIZE) == -1030);
+}
+
+static void testChangedLabel() {
+  writeFile();
+  tag.memory[FILE_BLOCK][1] = 'S';   // first char of the label, authenticated with the data
+  CHECK(rfidReader.readFile(FILE_BLOCK, "Secret", buffer, DATA_SIZE) == -1030);
+}
+
+static void testOtherUid() {
+  writeFile();
+  int lastBlock = rfidReader.getBlockOfOffset(FILE_BLOCK + 1, 16 + DATA_SIZE - 1);
+  for (int block = FILE_BLOCK; block <= lastBlock; block ++) {
+    if (! tag.isTrailer(block)) {
+      memcpy(otherTag.memory[block], tag.memory[block], 16);
+    }
+  }
+  useTag(&otherTag);
+  CHECK(rfidReader.readFile(FILE_BLOCK, "secret", buffer, DATA_SIZE) == -1030);
+}
+
+static void testNoCipher() {
+  writeFile();
+  rfidReader.setFileCipher(NULL);
+  CHECK(rfidReader.readFile(FILE_BLOCK, "secret", buffer, DATA_SIZE) == -1031);
+  rfidReader.setFileCipher(&cipher);
+}
+
+int main() {
+  hostSetSimulatedClock(true);
+  simMfrc522.addTag(&tag);
+  rfidReader.init();
+  rfidReader.setFileCipher(&cipher);
+  for (int i = 0; i < DATA_SIZE; i ++) {
+    data[i] = (byte)(i * 13 + 7);
+  }
+
+  testRoundTrip();
+  testFlippedData();
+  testChangedLabel();
+  testOtherUid();
+  testNoCipher();
+
+  if (failures > 0) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("all tests of the encrypted files passed\n");
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include <EasyMFRC522.h>
+#include <RfidDictionaryView.h>
+#include <RfidStaticDictionary.h>
+#include <HostArduino.h>
+#include <SimMfrc522.h>
+
+/*
+ * Tests of the dictionaries (RfidDictionaryView and RfidStaticDictionary) on a simulated tag,
+ * with the log of changes:
+ *   - the changes appended to the log by RfidDictionaryView are seen by RfidStaticDictionary,
+ *     and the changes of RfidStaticDictionary (that rewrite the dictionary) by both classes;
+ *   - a record that fills the log up to its last byte;
+ *   - the same, with the parity of files enabled in the EasyMFRC522 (setFileParity()).
+ *
+ * Returns 1 (and prints the failures) if some test fails.
+ */
+
+#define CHECK(condition)  check((condition), #condition, __LINE__)
+
+static int failures = 0;
+
+static void check(bool condition, const char* text, int line) {
+  if (! condition) {
+    printf("FAILED (line %d): %s\n", line, text);
+    failures ++;
+  }
+}
+
+EasyMFRC522 rfidReader(D4, D3);
+
+static void testLogShared() {
+  {
+    RfidDictionaryView view(&rfidReader, 1);
+    view.setLogCapacity(64);
+    view.set("name", "a value long enough to take more than one block");
+    view.set("age", "30");      // in the log, from here on
+    view.set("city", "recife");
+    view.set("age", "31");
+    view.remove("city");
+    view.set("zip", "50000");
+  }
+  {
+    RfidStaticDictionary<256, 16> dict(&rfidReader, 1);
+    char value[64];
+    CHECK(dict.getNumEntries() == 3);
+    CHECK(dict.get("age", value, sizeof(value)) == 2 && strcmp(value, "31") == 0);
+    CHECK(dict.get("zip", value, sizeof(value)) == 5 && strcmp(value, "50000") == 0);
+    CHECK(! dict.hasKey("city"));
+    CHECK(dict.set("age", "30") == 0);   // the same content of the base dictionary: the log must not be applied again
+  }
+  {
+    RfidDictionaryView view(&rfidReader, 1);
+    CHECK(view.getNumEntries() == 3);
+    CHECK(view.get("age") == "30");
+    CHECK(view.get("zip") == "50000");
+    CHECK(! view.hasKey("city"));
+  }
+}
+
+static void testFullLog() {
+  RfidDictionaryView view(&rfidReader, 1);
+  view.setLogCapacity(32);
+  view.set("a", "1");                                  // rewrites the dictionary, with an empty log
+  view.set("b", "0123456789012345678901234567");       // record of 30 bytes: the log is full
+
+  RfidDictionaryView other(&rfidReader, 1);
+  CHECK(other.get("b") == "0123456789012345678901234567");
+
+  view.set("c", "2");                                  // no space in the log: rewrites the dictionary
+  RfidStaticDictionary<256, 16> dict(&rfidReader, 1);
+  char value[40];
+  CHECK(dict.get("b", value, sizeof(value)) == 28);
+  CHECK(dict.get("c", value, sizeof(value)) == 1);
+}
+
+int main() {
+  hostSetSimulatedClock(true);
+  SimTag tag(0x01020304);
+  simMfrc522.addTag(&tag);
+  rfidReader.init();
+  if (! rfidReader.detectTag()) {
+    printf("FAILED: the simulated tag was not detected\n");
+    return 1;
+  }
+
+  testLogShared();
+  testFullLog();
+
+  tag.format();
+  rfidReader.setFileParity(2);
+  testLogShared();
+  testFullLog();
+  CHECK(rfidReader.getFileParity() == 2);
+
+  if (failures > 0) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("all tests of the dictionaries passed\n");
+  return 0;
+}
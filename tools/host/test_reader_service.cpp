@@ -0,0 +1,166 @@
+#include <EasyMFRC522.h>
+#include <RfidReaderService.h>
+#include <HostArduino.h>
+#include <SimMfrc522.h>
+
+#include <thread>
+#include <vector>
+
+/*
+ * Tests of RfidReaderService on Linux, with std::thread producers and the service thread
+ * using the simulated MFRC522 (in the real clock of the host, as the service sleeps):
+ *   - requests of many threads, served in sessions with the tag;
+ *   - a request for another tag (the tag in the field is detected, but not accepted) and a
+ *     request without tag, that must expire with -3301 (without spinning on the detection);
+ *   - stop() while many threads submit: each request accepted by submit() must be done
+ *     (a stress test: the race between submit() and the end of the service is not forced,
+ *     it may only happen in some of the rounds).
+ *
+ * Returns 1 (and prints the failures) if some test fails.
+ */
+
+#define CHECK(condition)  check((condition), #condition, __LINE__)
+
+static int failures = 0;
+
+static void check(bool condition, const char* text, int line) {
+  if (! condition) {
+    printf("FAILED (line %d): %s\n", line, text);
+    failures ++;
+  }
+}
+
+EasyMFRC522 rfidReader(D4, D3);
+SimTag tag(0x5A5B5C5D);
+
+static void testProducers() {
+  RfidReaderService service(&rfidReader);
+  CHECK(service.start());
+
+  const int THREADS = 4;
+  static byte written[THREADS][32];
+  static byte read[THREADS][32];
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < THREADS; t ++) {
+    threads.push_back(std::thread([t, &service]() {
+      for (int i = 0; i < 32; i ++) {
+        written[t][i] = (byte)(t * 32 + i);
+      }
+      int block = 4 * (t + 1);   // one sector per thread
+      RfidRequest write;
+      write.setWrite(block, written[t], 32);
+      CHECK(service.submit(&write));
+      CHECK(write.wait(5000));
+      CHECK(write.result >= 0);
+
+      RfidRequest readBack;
+      readBack.setRead(block, read[t], 32);
+      CHECK(service.submit(&readBack));
+      CHECK(readBack.wait(5000));
+      CHECK(readBack.result >= 0);
+      CHECK(memcmp(read[t], written[t], 32) == 0);
+      CHECK(EasyMFRC522::isSameUid(readBack.uid, write.uid));
+    }));
+  }
+  for (unsigned t = 0; t < threads.size(); t ++) {
+    threads[t].join();
+  }
+
+  service.stop();
+  CHECK(! service.isRunning());
+}
+
+static void testExpiration() {
+  RfidReaderService service(&rfidReader);
+  CHECK(service.start());
+
+  // the tag in the field is not the one required
+  RfidRequest other;
+  MFRC522::Uid otherUid;
+  otherUid.size = 4;
+  otherUid.uidByte[0] = 1; otherUid.uidByte[1] = 2; otherUid.uidByte[2] = 3; otherUid.uidByte[3] = 4;
+  other.setDetect();
+  other.setTargetUid(otherUid);
+  other.timeout = 200;
+
+  simMfrc522.resetCounters();
+  unsigned long start = millis();
+  CHECK(service.submit(&other));
+  CHECK(other.wait(2000));
+  unsigned long elapsed = millis() - start;
+  CHECK(other.result == -3301);
+  CHECK(elapsed >= 200);
+  // the task sleeps between the detections: at most one per ms (plus the time of the detection)
+  CHECK(simMfrc522.rfFrames < 20 * (elapsed + 1));
+
+  // no tag in the field
+  tag.present = false;
+  RfidRequest none;
+  none.setDetect();
+  none.timeout = 100;
+  CHECK(service.submit(&none));
+  CHECK(none.wait(2000));
+  CHECK(none.result == -3301);
+  tag.present = true;
+
+  service.stop();
+}
+
+static void testStopRace() {
+  tag.present = false;   // the requests stay pending until stop()
+
+  for (int round = 0; round < 200; round ++) {
+    RfidReaderService service(&rfidReader);
+    CHECK(service.start());
+
+    const int THREADS = 4;
+    const int REQUESTS = 8;   // per thread (all fit in the queue and in the pending list)
+    static RfidRequest requests[THREADS][REQUESTS];
+    static bool accepted[THREADS][REQUESTS];
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < THREADS; t ++) {
+      threads.push_back(std::thread([t, &service]() {
+        for (int i = 0; i < REQUESTS; i ++) {
+          requests[t][i].setDetect();
+          requests[t][i].timeout = 60000;
+          accepted[t][i] = service.submit(&requests[t][i]);
+          std::this_thread::yield();
+        }
+      }));
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds((round % 40) * 5));
+    service.stop();
+    for (unsigned t = 0; t < threads.size(); t ++) {
+      threads[t].join();
+    }
+
+    for (int t = 0; t < THREADS; t ++) {
+      for (int i = 0; i < REQUESTS; i ++) {
+        if (accepted[t][i]) {
+          CHECK(requests[t][i].isDone());
+          CHECK(requests[t][i].result == -3302);
+        }
+      }
+    }
+  }
+
+  tag.present = true;
+}
+
+int main() {
+  simMfrc522.addTag(&tag);
+  rfidReader.init();
+
+  testProducers();
+  testExpiration();
+  testStopRace();
+
+  if (failures > 0) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("all tests of RfidReaderService passed\n");
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include <EasyMFRC522.h>
+#include <HostArduino.h>
+#include <SimMfrc522.h>
+
+/*
+ * Tests of the resumable writes (see "RESUMABLE WRITES" in EasyMFRC522.cpp) on a simulated
+ * tag that leaves the field in the middle of the write (SimTag::writesBeforeLeaving):
+ *   - writeRaw() and writeFile() of 120 bytes (8 blocks of data) are interrupted after 4
+ *     block writes; when repeated in the next tap, only the blocks not verified (and the
+ *     header of the file) are written again, and the data read back is the data given;
+ *   - with other data, or with the resume disabled, the write is done from the start.
+ *
+ * Returns 1 (and prints the failures) if some test fails.
+ */
+
+#define CHECK(condition)  check((condition), #condition, __LINE__)
+
+#define DATA_SIZE    120
+#define DATA_BLOCKS  8
+
+static int failures = 0;
+
+static void check(bool condition, const char* text, int line) {
+  if (! condition) {
+    printf("FAILED (line %d): %s\n", line, text);
+    failures ++;
+  }
+}
+
+EasyMFRC522 rfidReader(D4, D3);
+SimTag tag(0x21222324);
+byte data[DATA_SIZE];
+
+// the tag leaves the field after "writes" block writes, and is tapped again
+static void leaveAfter(int writes) {
+  tag.present = true;
+  tag.writesBeforeLeaving = writes;
+  rfidReader.unselectMifareTag(true);
+  CHECK(rfidReader.detectTag());
+}
+
+static void retap() {
+  tag.present = true;
+  tag.writesBeforeLeaving = -1;
+  rfidReader.unselectMifareTag(true);
+  CHECK(rfidReader.detectTag());
+  simMfrc522.resetCounters();
+}
+
+static void fillData(byte seed) {
+  for (int i = 0; i < DATA_SIZE; i ++) {
+    data[i] = (byte)(seed + i * 5);
+  }
+}
+
+static void testWriteRaw() {
+  byte buffer[DATA_SIZE];
+  fillData(1);
+  leaveAfter(4);
+  CHECK(rfidReader.writeRaw(1, data, DATA_SIZE) < 0);
+  CHECK(rfidReader.getResumeRecord().operation == RFID_RESUME_WRITE_RAW);
+  CHECK(rfidReader.getResumeRecord().bytesVerified == 4 * 16);
+
+  retap();
+  CHECK(rfidReader.writeRaw(1, data, DATA_SIZE) >= 0);
+  CHECK(simMfrc522.blockWrites == DATA_BLOCKS - 4);
+  CHECK(rfidReader.getResumeRecord().operation == RFID_RESUME_NONE);
+  CHECK(rfidReader.readRaw(1, buffer, DATA_SIZE) == DATA_SIZE);
+  CHECK(memcmp(buffer, data, DATA_SIZE) == 0);
+}
+
+static void testWriteFile() {
+  byte buffer[DATA_SIZE];
+  fillData(2);
+  leaveAfter(4);   // the header and 3 blocks of data
+  CHECK(rfidReader.writeFile(1, "resumed", data, DATA_SIZE) < 0);
+  CHECK(rfidReader.getResumeRecord().operation == RFID_RESUME_WRITE_FILE);
+  CHECK(rfidReader.getResumeRecord().bytesVerified == 3 * 16);
+
+  retap();
+  CHECK(rfidReader.writeFile(1, "resumed", data, DATA_SIZE) >= 0);
+  CHECK(simMfrc522.blockWrites == 1 + DATA_BLOCKS - 3);
+  CHECK(rfidReader.getResumeRecord().operation == RFID_RESUME_NONE);
+  CHECK(rfidReader.readFile(1, "resumed", buffer, DATA_SIZE) == DATA_SIZE);
+  CHECK(memcmp(buffer, data, DATA_SIZE) == 0);
+}
+
+static void testNotResumed() {
+  // other data: written from the start
+  fillData(3);
+  leaveAfter(4);
+  CHECK(rfidReader.writeRaw(1, data, DATA_SIZE) < 0);
+  retap();
+  fillData(4);
+  CHECK(rfidReader.writeRaw(1, data, DATA_SIZE) >= 0);
+  CHECK(simMfrc522.blockWrites == DATA_BLOCKS);
+
+  // resume disabled: no record is kept
+  rfidReader.setResumeEnabled(false);
+  leaveAfter(4);
+  CHECK(rfidReader.writeRaw(1, data, DATA_SIZE) < 0);
+  CHECK(rfidReader.getResumeRecord().operation == RFID_RESUME_NONE);
+  retap();
+  CHECK(rfidReader.writeRaw(1, data, DATA_SIZE) >= 0);
+  CHECK(simMfrc522.blockWrites == DATA_BLOCKS);
+  rfidReader.setResumeEnabled(true);
+}
+
+int main() {
+  hostSetSimulatedClock(true);
+  simMfrc522.addTag(&tag);
+  rfidReader.init();
+  rfidReader.setResumeEnabled(true);
+  if (! rfidReader.detectTag()) {
+    printf("FAILED: the simulated tag was not detected\n");
+    return 1;
+  }
+
+  testWriteRaw();
+  testWriteFile();
+  testNotResumed();
+
+  if (failures > 0) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("all tests of the resumable writes passed\n");
+  return 0;
+}
@@ -0,0 +1,257 @@
+#include <EasyMFRC522.h>
+#include <HostArduino.h>
+#include <SimMfrc522.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * Replays traces dumped by EasyMFRC522::dumpTrace() (e.g. saved from a board in the field)
+ * on Linux, against the simulated MFRC522 of the host build, to re-run the retries and the
+ * timing of an operation without the board or the tag:
+ *
+ *   trace_replay replay FILE [OPERATION]
+ *       parses the dump and replays it (with the durations recorded, in the simulated
+ *       clock), running the operation; no tag is in the field, so any command that is not
+ *       taken from the trace fails. Prints the result, the mismatches and the time.
+ *
+ *   trace_replay record FILE [OPERATION] [FAULTS]
+ *       runs the operation on a simulated tag, recording the trace, and dumps it to FILE.
+ *       FAULTS: --read-failures BLOCK:N (the next N reads of the block fail with a CRC
+ *       error), --auth-failures N, --leave-after N (the tag leaves after N block writes).
+ *
+ *   trace_replay check
+ *       records the operations with some faults, replays each dump and fails (exit code 1)
+ *       if a replay gives a different result, has mismatches, or takes a different time.
+ *
+ * OPERATION (the same one must be given to record and to replay a trace):
+ *   --op raw|file   writeRaw() and readRaw(), or writeFile() (default: raw); the file is not
+ *                   read back, because the replay gives zeros in the reads of the blocks
+ *                   (except the last one written), and readFile() would not find it
+ *   --block B       initial block (default: 1)
+ *   --size N        size of the data (default: 64)
+ *
+ * The trace of each command is printed as CSV lines "csv,time,duration,command,block,status"
+ * (as in the example Trace-Ex1).
+ */
+
+#define TRACE_CAPACITY  512
+
+struct Operation {
+  bool file;
+  int block;
+  int size;
+  Operation() : file(false), block(1), size(64) {}
+};
+
+// the output of dumpTrace(), kept in memory
+class ByteBuffer : public Print {
+public:
+  std::vector<byte> bytes;
+  virtual size_t write(uint8_t value) {
+    bytes.push_back(value);
+    return 1;
+  }
+};
+
+EasyMFRC522 rfidReader(D4, D3);
+RfidTraceRecord trace[TRACE_CAPACITY];
+
+static int runOperation(const Operation& op) {
+  std::vector<byte> data(op.size);
+  for (int i = 0; i < op.size; i ++) {
+    data[i] = (byte)(i * 3 + 1);
+  }
+#if EASY_MFRC522_ENABLE_RESUME
+  rfidReader.clearResumeRecord();   // a failed write must be repeated from the start, as recorded
+#endif
+  int result;
+  if (op.file) {
+    result = rfidReader.writeFile(op.block, "trace", data.data(), op.size);
+  } else {
+    result = rfidReader.writeRaw(op.block, data.data(), op.size);
+    if (result >= 0) {
+      result = rfidReader.readRaw(op.block, data.data(), op.size);
+    }
+  }
+  return result;
+}
+
+static void printTrace() {
+  RfidTraceRecord record;
+  printf("csv,time,duration,command,block,status\n");
+  for (int i = 0; i < rfidReader.getTraceSize(); i ++) {
+    rfidReader.getTraceRecord(i, &record);
+    printf("csv,%u,%u,%u,%u,%u\n", (unsigned)record.time, (unsigned)record.duration,
+           (unsigned)record.command, (unsigned)record.block, (unsigned)record.status);
+  }
+}
+
+// Runs the operation on a fresh simulated tag (with the faults given), recording its trace.
+// Gives the result of the operation and the time it took, in microseconds.
+static int record(const Operation& op, SimTag& tag, ByteBuffer& dump, unsigned long* elapsedOut) {
+  simMfrc522.removeTags();
+  simMfrc522.addTag(&tag);
+  rfidReader.setTraceBuffer(trace, TRACE_CAPACITY);
+  if (! rfidReader.detectTag()) {
+    fprintf(stderr, "error: the simulated tag was not detected\n");
+    return -1;
+  }
+
+  rfidReader.clearTrace();
+  unsigned long start = micros();
+  int result = runOperation(op);
+  *elapsedOut = micros() - start;
+  rfidReader.unselectMifareTag();
+
+  rfidReader.dumpTrace(dump);
+  return result;
+}
+
+// Replays the dump, without tags in the field. Gives the result of the operation.
+static int replay(const Operation& op, const std::vector<byte>& dump, unsigned long* elapsedOut, int* mismatchesOut) {
+  static RfidTraceRecord records[TRACE_CAPACITY];
+  int numRecords = EasyMFRC522::parseTrace(dump.data(), (int)dump.size(), records, TRACE_CAPACITY);
+  if (numRecords < 0) {
+    fprintf(stderr, "error: invalid dump (%d)\n", numRecords);
+    return numRecords;
+  }
+
+  simMfrc522.removeTags();
+  rfidReader.setTraceBuffer(trace, TRACE_CAPACITY);
+  rfidReader.startReplay(records, numRecords, true);
+  unsigned long start = micros();
+  int result = runOperation(op);
+  *elapsedOut = micros() - start;
+  *mismatchesOut = rfidReader.getReplayMismatches();
+  rfidReader.stopReplay();
+  return result;
+}
+
+static bool checkCase(const char* name, const Operation& op, SimTag& tag) {
+  ByteBuffer dump;
+  unsigned long recordedMicros, replayedMicros;
+  int mismatches;
+  int recorded = record(op, tag, dump, &recordedMicros);
+  int replayed = replay(op, dump.bytes, &replayedMicros, &mismatches);
+
+  // in the replay, each command takes its recorded duration, but the time between the
+  // commands (e.g. the CRCs calculated by the MFRC522) is not recorded
+  long difference = (long)recordedMicros - (long)replayedMicros;
+  bool ok = (recorded == replayed) && (mismatches == 0) && difference >= 0 && difference <= (long)recordedMicros / 5;
+  printf("csv,check,%s,%d,%d,%d,%lu,%lu,%s\n", name, recorded, replayed, mismatches,
+         recordedMicros, replayedMicros, ok? "ok" : "FAILED");
+  return ok;
+}
+
+static int check() {
+  printf("csv,check,case,recorded_result,replayed_result,mismatches,recorded_micros,replayed_micros,status\n");
+  bool ok = true;
+  Operation raw;
+  Operation file;
+  file.file = true;
+
+  SimTag tag1(0x0A0B0C0D);
+  ok = checkCase("raw", raw, tag1) && ok;
+
+  SimTag tag2(0x0A0B0C0D);
+  tag2.readFailures[2] = 2;   // two retries in the verification of the block
+  ok = checkCase("raw_read_failures", raw, tag2) && ok;
+
+  SimTag tag3(0x0A0B0C0D);
+  tag3.writesBeforeLeaving = 3;   // the tag leaves in the middle of the write
+  ok = checkCase("raw_tag_left", raw, tag3) && ok;
+
+  SimTag tag4(0x0A0B0C0D);
+  tag4.readFailures[5] = 1;
+  ok = checkCase("file_failures", file, tag4) && ok;
+
+  return ok? 0 : 1;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: trace_replay replay FILE [--op raw|file] [--block B] [--size N]\n"
+                  "       trace_replay record FILE [--op raw|file] [--block B] [--size N]\n"
+                  "                          [--read-failures BLOCK:N] [--auth-failures N] [--leave-after N]\n"
+                  "       trace_replay check\n");
+}
+
+int main(int argc, char** argv) {
+  hostSetSimulatedClock(true);
+  rfidReader.init();
+
+  if (argc == 2 && strcmp(argv[1], "check") == 0) {
+    return check();
+  }
+  if (argc < 3 || (strcmp(argv[1], "replay") != 0 && strcmp(argv[1], "record") != 0)) {
+    usage();
+    return 2;
+  }
+  bool recording = (strcmp(argv[1], "record") == 0);
+  std::string fileName = argv[2];
+
+  Operation op;
+  SimTag tag(0x0A0B0C0D);
+  for (int i = 3; i < argc; i ++) {
+    std::string option = argv[i];
+    const char* value = (i + 1 < argc)? argv[i + 1] : NULL;
+    if (value == NULL) {
+      usage();
+      return 2;
+    }
+    i ++;
+    if (option == "--op") {
+      op.file = (strcmp(value, "file") == 0);
+    } else if (option == "--block") {
+      op.block = atoi(value);
+    } else if (option == "--size") {
+      op.size = atoi(value);
+    } else if (recording && option == "--read-failures") {
+      int block, count;
+      if (sscanf(value, "%d:%d", &block, &count) != 2 || block < 0 || block > 255) {
+        usage();
+        return 2;
+      }
+      tag.readFailures[block] = count;
+    } else if (recording && option == "--auth-failures") {
+      tag.authFailures = atoi(value);
+    } else if (recording && option == "--leave-after") {
+      tag.writesBeforeLeaving = atoi(value);
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  unsigned long elapsed;
+  int result;
+  if (recording) {
+    ByteBuffer dump;
+    result = record(op, tag, dump, &elapsed);
+    FILE* file = fopen(fileName.c_str(), "wb");
+    if (file == NULL || fwrite(dump.bytes.data(), 1, dump.bytes.size(), file) != dump.bytes.size()) {
+      fprintf(stderr, "error: could not write %s\n", fileName.c_str());
+      return 1;
+    }
+    fclose(file);
+    printf("result: %d, time (us): %lu, records: %d\n", result, elapsed, rfidReader.getTraceSize());
+
+  } else {
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (file == NULL) {
+      fprintf(stderr, "error: could not read %s\n", fileName.c_str());
+      return 1;
+    }
+    std::vector<byte> dump;
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+      dump.push_back((byte)c);
+    }
+    fclose(file);
+    int mismatches;
+    result = replay(op, dump, &elapsed, &mismatches);
+    printf("result: %d, time (us): %lu, mismatches: %d\n", result, elapsed, mismatches);
+  }
+  printTrace();
+  return 0;
+}
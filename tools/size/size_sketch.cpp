@@ -0,0 +1,26 @@
+#include <Arduino.h>
+#include "EasyMFRC522.h"
+
+/*
+ * Minimal sketch built by the "size_*" environments of platformio.ini, to measure the
+ * flash and RAM taken by the library in each configuration (see tools/size_report.py).
+ * It uses only the unlabeled reads, as a sketch that just identifies the tags would do.
+ */
+
+EasyMFRC522 rfidReader(D4, D3);
+
+byte buffer[16];
+
+void setup() {
+  Serial.begin(9600);
+  rfidReader.init();
+}
+
+void loop() {
+  if (rfidReader.detectTag()) {
+    int result = rfidReader.readRaw(1, buffer, sizeof(buffer));
+    Serial.println(result);
+    rfidReader.unselectMifareTag();
+  }
+  delay(100);
+}
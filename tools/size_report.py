@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""
+Reports the flash and static RAM used by each configuration of the library
+(see src/EasyMFRC522Config.h), as CSV lines: "csv,target,config,flash,ram".
+
+  python3 tools/size_report.py            # builds the "size_*" envs of platformio.ini (nodemcuv2)
+  python3 tools/size_report.py --host     # compiles the sources for the host, with g++ -Os
+
+The PlatformIO builds link the minimal sketch in tools/size/, so they give the size of
+the whole firmware (and the difference between the configurations is the library).
+
+The host build gives the size of the objects of the library and of the sketch (which
+holds the EasyMFRC522 object, so the RAM includes its members). It uses the headers of
+the Arduino API and of the MFRC522 library of the host build, in tools/host/include/;
+others may be given in the environment variable HOST_INCLUDES (directories separated
+by ':').
+"""
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# configurations of the host build (the PlatformIO ones are the "size_*" envs)
+HOST_CONFIGS = {
+    "full": [],
+    "minimal": ["-DEASY_MFRC522_ENABLE_PREFETCH=0", "-DEASY_MFRC522_ENABLE_TRACE=0",
+                "-DEASY_MFRC522_ENABLE_DIAGNOSTICS=0", "-DEASY_MFRC522_ENABLE_RESUME=0",
+                "-DEASY_MFRC522_ENABLE_DICTIONARY=0", "-DEASY_MFRC522_SUPPORT_MINI=0",
+                "-DEASY_MFRC522_SUPPORT_4K=0"],
+}
+
+
+def pio_envs():
+    envs = []
+    with open(os.path.join(ROOT, "platformio.ini")) as ini:
+        for line in ini:
+            match = re.match(r"\[env:(size_\w+)\]", line.strip())
+            if match:
+                envs.append(match.group(1))
+    return envs
+
+
+def pio_report():
+    for env in pio_envs():
+        result = subprocess.run(["pio", "run", "-e", env], cwd=ROOT, capture_output=True, text=True)
+        if result.returncode != 0:
+            sys.stderr.write(result.stdout + result.stderr)
+            sys.exit("error building env " + env)
+        # e.g. "RAM:   [===       ]  34.5% (used 28268 bytes from 81920 bytes)"
+        used = dict(re.findall(r"(RAM|Flash):.*\(used (\d+) bytes", result.stdout))
+        print("csv,nodemcuv2,%s,%s,%s" % (env[len("size_"):], used.get("Flash", "?"), used.get("RAM", "?")))
+
+
+def host_report():
+    includes = [d for d in os.environ.get("HOST_INCLUDES", "").split(":") if d]
+    if not includes:
+        includes = [os.path.join(ROOT, "tools", "host", "include")]
+    sources = sorted(os.path.join("src", f) for f in os.listdir(os.path.join(ROOT, "src")) if f.endswith(".cpp"))
+    sources.append(os.path.join("tools", "size", "size_sketch.cpp"))
+
+    for config, flags in HOST_CONFIGS.items():
+        flash = ram = 0
+        with tempfile.TemporaryDirectory() as tmp:
+            for source in sources:
+                obj = os.path.join(tmp, os.path.basename(source) + ".o")
+                command = ["g++", "-std=gnu++11", "-Os", "-ffunction-sections", "-fdata-sections", "-c",
+                           "-I" + os.path.join(ROOT, "src")] + ["-I" + d for d in includes] + flags
+                subprocess.run(command + [os.path.join(ROOT, source), "-o", obj], check=True)
+                # "size" (Berkeley format): text data bss dec hex filename
+                output = subprocess.run(["size", obj], capture_output=True, text=True, check=True).stdout
+                text, data, bss = [int(v) for v in output.splitlines()[1].split()[:3]]
+                flash += text + data
+                ram += data + bss
+        print("csv,host,%s,%d,%d" % (config, flash, ram))
+
+
+if __name__ == "__main__":
+    print("csv,target,config,flash,ram")
+    if "--host" in sys.argv:
+        host_report()
+    else:
+        pio_report()